@@ -0,0 +1,101 @@
+#ifndef allocations_h
+#define allocations_h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/** Counts all heap allocations of a test program
+ *
+ * Replaces every form of the global operator new and delete, so include it in
+ * one source file of the program only.  The replacements are not inline,
+ * because the standard does not allow that
+ */
+inline std::atomic<std::size_t> allocations{0};
+
+namespace Allocations {
+/** Memory of n bytes, aligned to a */
+inline void *get(std::size_t n, std::size_t a = alignof(std::max_align_t)) {
+  allocations++;
+  if (n == 0) n = 1;
+  void *p = a <= alignof(std::max_align_t)
+                ? std::malloc(n)
+                : std::aligned_alloc(a, (n + a - 1) / a * a);
+  return p;
+}
+
+/** Frees memory of get */
+[[gnu::noinline]] inline void put(void *p) noexcept { std::free(p); }
+}  // namespace Allocations
+
+void *operator new(std::size_t n) {
+  if (void *p = Allocations::get(n)) return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t n) {
+  if (void *p = Allocations::get(n)) return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t n, std::align_val_t a) {
+  if (void *p = Allocations::get(n, std::size_t(a))) return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t n, std::align_val_t a) {
+  if (void *p = Allocations::get(n, std::size_t(a))) return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  return Allocations::get(n);
+}
+
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  return Allocations::get(n);
+}
+
+void *operator new(std::size_t n, std::align_val_t a,
+                   const std::nothrow_t &) noexcept {
+  return Allocations::get(n, std::size_t(a));
+}
+
+void *operator new[](std::size_t n, std::align_val_t a,
+                     const std::nothrow_t &) noexcept {
+  return Allocations::get(n, std::size_t(a));
+}
+
+void operator delete(void *p) noexcept { Allocations::put(p); }
+void operator delete[](void *p) noexcept { Allocations::put(p); }
+void operator delete(void *p, std::size_t) noexcept { Allocations::put(p); }
+void operator delete[](void *p, std::size_t) noexcept { Allocations::put(p); }
+void operator delete(void *p, std::align_val_t) noexcept {
+  Allocations::put(p);
+}
+void operator delete[](void *p, std::align_val_t) noexcept {
+  Allocations::put(p);
+}
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  Allocations::put(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  Allocations::put(p);
+}
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  Allocations::put(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  Allocations::put(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  Allocations::put(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  Allocations::put(p);
+}
+
+#endif  // allocations_h
@@ -74,7 +74,8 @@ class Antenna {
       const Geom::Nav& pos_los, const Atmosphere::Atm& atm,
       const Distance<DistanceType::meter> dist,
       const Altitude<AltitudeType::meter> alt_of_atm,
-      const Frequency<FrequencyType::Freq> mean_freq) const;
+      const Frequency<FrequencyType::Freq> mean_freq,
+      const Path::Tolerance& tolerance) const;
 };
 
 ENUMCLASS(PolarizationType, unsigned char, I, Q, U, V, IpQ, ImQ, IpU, ImU, IpV,
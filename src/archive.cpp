@@ -0,0 +1,235 @@
+#include "archive.h"
+
+#include <algorithm>
+
+#include "file.h"
+
+namespace Instrument {
+namespace Archive {
+std::ostream &operator<<(std::ostream &os, const ChunkInfo &c) {
+  Time t0, t1;
+  t0.Seconds(c.tmin);
+  t1.Seconds(c.tmax);
+  return os << t0 << ' ' << t1 << ' ' << c.count << ' ' << c.vmin << ' '
+            << c.vmax;
+}
+
+ColumnWriter::ColumnWriter(const std::filesystem::path &base,
+                           std::size_t width, std::size_t chunk)
+    : datapath(base.string() + std::string{".bin"}),
+      indexpath(base.string() + std::string{".idx"}),
+      mwidth(width),
+      chunk_size(chunk) {
+  time.reserve(chunk_size);
+  value.reserve(chunk_size * mwidth);
+}
+
+void ColumnWriter::append(double t, const double *v) {
+  time.push_back(t);
+  value.insert(value.end(), v, v + mwidth);
+  if (time.size() >= chunk_size) flush();
+}
+
+void ColumnWriter::flush() {
+  if (time.size() == 0) return;
+
+  ChunkInfo info;
+  info.offset = std::filesystem::exists(datapath)
+                    ? std::filesystem::file_size(datapath)
+                    : 0;
+  info.count = time.size();
+  info.tmin = *std::min_element(time.cbegin(), time.cend());
+  info.tmax = *std::max_element(time.cbegin(), time.cend());
+  info.vmin = *std::min_element(value.cbegin(), value.cend());
+  info.vmax = *std::max_element(value.cbegin(), value.cend());
+
+  File::File<File::Operation::AppendBinary, File::Type::Raw> data(datapath);
+  data.write(time.data(), time.size() * sizeof(double));
+  data.write(value.data(), value.size() * sizeof(double));
+  data.close();
+
+  // The index is written last so that a reader never sees a chunk without data
+  File::File<File::Operation::AppendBinary, File::Type::Raw> index(indexpath);
+  index.write(info);
+  index.close();
+
+  time.resize(0);
+  value.resize(0);
+}
+
+Writer::Writer(const std::filesystem::path &directory, std::size_t chunk,
+               std::size_t downsample)
+    : dir(directory),
+      chunk_size(chunk ? chunk : 1),
+      spectral_downsample(downsample) {
+  std::filesystem::create_directories(dir);
+
+  // Continue an old archive
+  if (std::filesystem::exists(dir / "manifest.xml")) {
+    File::File<File::Operation::Read, File::Type::Xml> manifest(
+        dir / "manifest.xml");
+    auto root = manifest.get_child("Columns");
+    for (auto col = root.child("Column"); col;
+         col = col.next_sibling("Column")) {
+      const std::string key = col.attribute("Name").as_string();
+      names.push_back(key);
+      columns.emplace(key,
+                      ColumnWriter(dir / col.attribute("File").as_string(),
+                                   col.attribute("Width").as_ullong(),
+                                   chunk_size));
+    }
+  }
+}
+
+Writer::~Writer() {
+  try {
+    flush();
+  } catch (const std::exception &e) {
+    std::cerr << "Cannot flush archive " << dir << ":\n" << e.what() << '\n';
+  }
+}
+
+ColumnWriter &Writer::column(const std::string &key, std::size_t width) {
+  auto col = columns.find(key);
+  if (col == columns.end()) {
+    const std::string file = std::string{"column"} +
+                             std::to_string(names.size());
+    names.push_back(key);
+    col = columns.emplace(key, ColumnWriter(dir / file, width, chunk_size))
+              .first;
+    write_manifest();
+  } else if (col->second.width() not_eq width) {
+    std::ostringstream os;
+    os << "Archive column \"" << key << "\" has width "
+       << col->second.width() << ", cannot append records of width " << width
+       << '\n';
+    throw std::runtime_error(os.str());
+  }
+  return col->second;
+}
+
+void Writer::write_manifest() const {
+  File::File<File::Operation::Write, File::Type::Xml> manifest(dir /
+                                                               "manifest.xml");
+  manifest.new_child("Columns");
+  manifest.add_attribute("Version", 1);
+  manifest.add_attribute("size", names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    manifest.new_child("Column");
+    manifest.add_attribute("Name", names[i]);
+    manifest.add_attribute("File", std::string{"column"} + std::to_string(i));
+    manifest.add_attribute("Width", columns.at(names[i]).width());
+    manifest.leave_child();
+  }
+  manifest.close();
+}
+
+void Writer::append(const Time &t, const std::string &key, double x) {
+  column(key, 1).append(t.Seconds(), &x);
+}
+
+void Writer::append(const Time &t, const std::string &key,
+                    const std::vector<float> &spectrum) {
+  const std::size_t n = spectrum.size();
+  const std::size_t d = spectral_downsample ? spectral_downsample : 1;
+  const std::size_t m = (n + d - 1) / d;
+
+  std::vector<double> downsampled(m, 0);
+  for (std::size_t i = 0; i < m; i++) {
+    const std::size_t first = i * d;
+    const std::size_t last = std::min(first + d, n);
+    for (std::size_t j = first; j < last; j++)
+      downsampled[i] += double(spectrum[j]);
+    downsampled[i] /= double(last - first);
+  }
+
+  column(key, m).append(t.Seconds(), downsampled.data());
+}
+
+void Writer::flush() {
+  for (auto &col : columns) col.second.flush();
+}
+
+Reader::Reader(const std::filesystem::path &directory) : dir(directory) {
+  File::File<File::Operation::Read, File::Type::Xml> manifest(dir /
+                                                              "manifest.xml");
+  auto root = manifest.get_child("Columns");
+  for (auto col = root.child("Column"); col;
+       col = col.next_sibling("Column"))
+    columns[col.attribute("Name").as_string()] = {
+        col.attribute("File").as_string(), col.attribute("Width").as_ullong()};
+}
+
+const std::pair<std::string, std::size_t> &Reader::column(
+    const std::string &key) const {
+  auto col = columns.find(key);
+  if (col == columns.end()) {
+    std::ostringstream os;
+    os << "No column \"" << key << "\" in archive " << dir << '\n';
+    throw std::runtime_error(os.str());
+  }
+  return col->second;
+}
+
+std::vector<std::string> Reader::keys() const {
+  std::vector<std::string> out;
+  for (auto &col : columns) out.push_back(col.first);
+  return out;
+}
+
+std::vector<ChunkInfo> Reader::chunks(const std::string &key, const Time &t0,
+                                      const Time &t1) const {
+  const std::filesystem::path indexpath =
+      (dir / column(key).first).string() + std::string{".idx"};
+  const double start = t0.Seconds();
+  const double end = t1.Seconds();
+
+  std::vector<ChunkInfo> out;
+  if (not std::filesystem::exists(indexpath)) return out;
+
+  const std::size_t n =
+      std::filesystem::file_size(indexpath) / sizeof(ChunkInfo);
+  std::vector<ChunkInfo> index(n);
+  File::File<File::Operation::ReadBinary, File::Type::Raw> file(indexpath);
+  file.read(index.data(), n * sizeof(ChunkInfo));
+  file.close();
+
+  for (auto &c : index)
+    if (c.tmax >= start and c.tmin <= end) out.push_back(c);
+  return out;
+}
+
+Series Reader::read(const std::string &key, const Time &t0,
+                    const Time &t1) const {
+  const auto &col = column(key);
+  const double start = t0.Seconds();
+  const double end = t1.Seconds();
+
+  Series out{col.second, {}, {}};
+  const auto overlap = chunks(key, t0, t1);
+  if (overlap.size() == 0) return out;
+
+  File::File<File::Operation::ReadBinary, File::Type::Raw> file(
+      (dir / col.first).string() + std::string{".bin"});
+  std::vector<double> time;
+  std::vector<double> value;
+  for (auto &c : overlap) {
+    time.resize(c.count);
+    value.resize(c.count * out.width);
+    file.seek<false>(c.offset);
+    file.read(time.data(), time.size() * sizeof(double));
+    file.read(value.data(), value.size() * sizeof(double));
+
+    for (std::size_t i = 0; i < c.count; i++) {
+      if (time[i] < start or time[i] > end) continue;
+      out.time.push_back(time[i]);
+      out.value.insert(out.value.end(), value.cbegin() + i * out.width,
+                       value.cbegin() + (i + 1) * out.width);
+    }
+  }
+  file.close();
+
+  return out;
+}
+}  // namespace Archive
+}  // namespace Instrument
@@ -0,0 +1,149 @@
+#ifndef archive_h
+#define archive_h
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "timeclass.h"
+
+namespace Instrument {
+namespace Archive {
+/** Summary of a single chunk of a column
+ *
+ * The index file of a column is a plain array of these, so a range query
+ * only has to read the index and then seek to the chunks it overlaps
+ */
+struct ChunkInfo {
+  std::uint64_t offset;  // Byte position of the chunk in the data file
+  std::uint64_t count;   // Number of records in the chunk
+  double tmin;           // First time in the chunk [s since epoch]
+  double tmax;           // Last time in the chunk [s since epoch]
+  double vmin;           // Smallest value in the chunk
+  double vmax;           // Largest value in the chunk
+
+  friend std::ostream &operator<<(std::ostream &os, const ChunkInfo &c);
+};  // ChunkInfo
+
+/** A time-series as read from the archive
+ *
+ * value holds width values per time, record after record
+ */
+struct Series {
+  std::size_t width;
+  std::vector<double> time;
+  std::vector<double> value;
+
+  std::size_t size() const noexcept { return time.size(); }
+};  // Series
+
+/** Buffered writer of a single column
+ *
+ * Records are kept in memory until chunk_size of them are available and are
+ * then appended to the data file as [time..., value...] while the summary of
+ * the chunk is appended to the index file
+ */
+class ColumnWriter {
+  std::filesystem::path datapath;
+  std::filesystem::path indexpath;
+  std::size_t mwidth;
+  std::size_t chunk_size;
+  std::vector<double> time;
+  std::vector<double> value;
+
+ public:
+  ColumnWriter(const std::filesystem::path &base, std::size_t width,
+               std::size_t chunk);
+
+  void append(double t, const double *v);
+  void flush();
+
+  std::size_t width() const noexcept { return mwidth; }
+};  // ColumnWriter
+
+/** Writer of the chunked columnar archive
+ *
+ * The archive is a directory with a manifest.xml listing the columns and a
+ * pair of column*.bin (chunk data) and column*.idx (chunk summaries) files per
+ * column.  Opening an existing archive appends to it
+ */
+class Writer {
+  std::filesystem::path dir;
+  std::size_t chunk_size;
+  std::size_t spectral_downsample;
+  std::vector<std::string> names;
+  std::map<std::string, ColumnWriter> columns;
+
+  ColumnWriter &column(const std::string &key, std::size_t width);
+  void write_manifest() const;
+
+ public:
+  /** Opens an archive
+   *
+   * @param[in] directory The archive directory, created if it does not exist
+   * @param[in] chunk Number of records per chunk
+   * @param[in] downsample Number of spectral channels averaged into one stored
+   * channel, 0 means that no spectra are stored
+   */
+  Writer(const std::filesystem::path &directory, std::size_t chunk = 1024,
+         std::size_t downsample = 0);
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+  ~Writer();
+
+  void append(const Time &t, const std::string &key, double x);
+  void append(const Time &t, const std::string &key,
+              const std::vector<float> &spectrum);
+
+  template <size_t N>
+  void save(const Time &t, const std::map<std::string, double> &hk_data,
+            const std::map<std::string, double> &frontend_data,
+            const std::array<std::vector<std::vector<float>>, N> &backends_data,
+            const std::array<std::string, N> &backend_names) {
+    for (auto &hk : hk_data)
+      append(t, std::string{"Housekeeping/"} + hk.first, hk.second);
+    for (auto &fe : frontend_data)
+      append(t, std::string{"Frontend/"} + fe.first, fe.second);
+    if (spectral_downsample) {
+      for (size_t i = 0; i < N; i++)
+        for (size_t j = 0; j < backends_data[i].size(); j++)
+          append(t,
+                 std::string{"Spectrometer/"} + backend_names[i] +
+                     std::string{"/"} + std::to_string(j),
+                 backends_data[i][j]);
+    }
+  }
+
+  void flush();
+
+  const std::filesystem::path &path() const noexcept { return dir; }
+};  // Writer
+
+/** Reader of the chunked columnar archive */
+class Reader {
+  std::filesystem::path dir;
+  std::map<std::string, std::pair<std::string, std::size_t>> columns;
+
+  const std::pair<std::string, std::size_t> &column(
+      const std::string &key) const;
+
+ public:
+  Reader(const std::filesystem::path &directory);
+
+  /** All keys in the archive */
+  std::vector<std::string> keys() const;
+
+  /** The summaries of all chunks of key that overlap [t0, t1] */
+  std::vector<ChunkInfo> chunks(const std::string &key, const Time &t0,
+                                const Time &t1) const;
+
+  /** All records of key in [t0, t1], reading only the overlapping chunks */
+  Series read(const std::string &key, const Time &t0, const Time &t1) const;
+};  // Reader
+}  // namespace Archive
+}  // namespace Instrument
+
+#endif  // archive_h
@@ -0,0 +1,63 @@
+#include "archive.h"
+#include "cli_parsing.h"
+
+Time parse_time(const std::string &t) {
+  Time out;
+  std::istringstream is(t);
+  is >> out;
+  return out;
+}
+
+int main(int argc, char **argv) try {
+  CommandLine::App extract("Extract a time range from a columnar archive");
+
+  std::string dir;
+  extract.NewRequiredOption("-a,--archive", dir, "The archive directory");
+  std::string key;
+  extract.NewPlainOption("-k,--key", key,
+                         "The column to extract (empty lists all columns)");
+  std::string start = "1970-01-01 00:00:00";
+  extract.NewDefaultOption("-s,--start", start,
+                           "First time to extract (YYYY-MM-DD HH:MM:SS)");
+  std::string end = "2200-01-01 00:00:00";
+  extract.NewDefaultOption("-e,--end", end,
+                           "Last time to extract (YYYY-MM-DD HH:MM:SS)");
+  bool summary = false;
+  extract.NewDefaultOption("--summary", summary,
+                           "Output setting\n\t0: All records in the range\n\t1: "
+                           "Per-chunk time and min/max summaries only");
+
+  // Parse input options
+  extract.Parse(argc, argv);
+
+  const Instrument::Archive::Reader archive{dir};
+
+  if (key.size() == 0) {
+    for (auto &k : archive.keys()) std::cout << k << '\n';
+    return EXIT_SUCCESS;
+  }
+
+  const Time t0 = parse_time(start);
+  const Time t1 = parse_time(end);
+
+  if (summary) {
+    for (auto &c : archive.chunks(key, t0, t1)) std::cout << c << '\n';
+  } else {
+    const auto series = archive.read(key, t0, t1);
+    for (std::size_t i = 0; i < series.size(); i++) {
+      Time t;
+      t.Seconds(series.time[i]);
+      std::cout << t;
+      for (std::size_t j = 0; j < series.width; j++)
+        std::cout << ' ' << series.value[i * series.width + j];
+      std::cout << '\n';
+    }
+  }
+
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::ostringstream os;
+  os << "Terminated with errors:\n" << e.what() << '\n';
+  std::cerr << os.str();
+  return EXIT_FAILURE;
+}
@@ -1,7 +1,14 @@
 #include "atm.h"
 
+#include <algorithm>
 #include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
 #include <numeric>
+#include <sstream>
+#include <string>
 #include <type_traits>
 
 namespace Atmosphere {
@@ -14,72 +21,231 @@ Point &Point::operator+=(const LazyPoint &x) noexcept {
   return *this;
 }
 
+namespace {
+/** First value and inverse step of x if every value is within half a step of
+ * the uniform grid between its ends, or zeroes */
+template <typename T>
+std::array<double, 2> uniform_grid(const std::vector<T> &x) {
+  if (x.size() < 2) return {0, 0};
+  const double x0 = grid_coord(x.front());
+  const double dx = (grid_coord(x.back()) - x0) / double(x.size() - 1);
+  if (not(dx > 0)) return {0, 0};
+  for (size_t i = 1; i < x.size() - 1; i++)
+    if (not(std::abs(grid_coord(x[i]) - x0 - double(i) * dx) < 0.5 * dx))
+      return {0, 0};
+  return {x0, 1 / dx};
+}
+
+/** Interpolation point of v on x, guessing its position if x is uniform */
+template <typename T>
+LinearInterpPoint locate(const std::vector<T> &x, const T &v,
+                         const std::array<double, 2> &uniform) {
+  if (uniform[1] == 0) return interp_point(x, v);
+  const double pos = std::ceil((grid_coord(v) - uniform[0]) * uniform[1]);
+  return interp_point(
+      x, v, pos > 0 ? size_t(std::min(pos, double(x.size()))) : 0);
+}
+
+/** The number after the white space at first, which is moved past it */
+double parse_number(const char *&first, const char *last) {
+  while (first not_eq last and std::isspace(static_cast<unsigned char>(*first)))
+    first++;
+  const char *const start = first;
+  if (first not_eq last and *first == '+') first++;
+
+  double x = 0;
+  auto [end, ec] = std::from_chars(first, last, x);
+  if (first not_eq start and first not_eq last and *first == '-')
+    ec = std::errc::invalid_argument;  // A sign after a sign
+  if (ec == std::errc::result_out_of_range) {
+    // Rounded to zero or infinity, as streams do
+    x = std::strtod(std::string(first, end).c_str(), nullptr);
+  } else if (ec not_eq std::errc()) {
+    std::ostringstream os;
+    os << "Expected a number in the data of the atmosphere, got \""
+       << std::string(start, std::min(last, start + 20)) << "\"\n";
+    throw std::runtime_error(os.str());
+  }
+  first = end;
+  return x;
+}
+}  // namespace
+
+void Atm::set_uniform() noexcept {
+  uniform = {uniform_grid(tid), uniform_grid(alt), uniform_grid(lat),
+             uniform_grid(lon)};
+}
+
 InterPoints Atm::interpPoints(
     const Time newtid, const Altitude<AltitudeType::meter> newalt,
     const Coordinate<CoordinateType::lat> newlat,
     const Coordinate<CoordinateType::lon> newlon) const noexcept {
-  LinearInterpPoint tidout(1, 0), altout(1, 0), latout(1, 0), lonout(1, 0);
-
-  if (tid.size() > 1) {
-    auto tidpos = std::find_if(tid.cbegin(), tid.cend(), [newtid](auto a) {
-      return not(a < newtid) and not(a == newtid);
-    });
-    auto tidlow = (tidpos == tid.cbegin()) ? tid.cbegin() : tidpos - 1;
-    auto tidw = (tidpos == tid.cend())
-                    ? 1.0
-                    : Interp::weight(newtid.Seconds(), tidlow->Seconds(),
-                                     tidpos->Seconds());
-    tidout = LinearInterpPoint(tidw, size_t(tidlow - tid.cbegin()));
+  return {locate(tid, newtid, uniform[0]), locate(alt, newalt, uniform[1]),
+          locate(lat, newlat, uniform[2]), locate(lon, newlon, uniform[3])};
+}
+
+InterPoints Atm::interpPoints(const Time newtid,
+                              const Altitude<AltitudeType::meter> newalt,
+                              const Coordinate<CoordinateType::lat> newlat,
+                              const Coordinate<CoordinateType::lon> newlon,
+                              const InterPoints &hint) const noexcept {
+  return {interp_point(tid, newtid, hint.Tid().index() + 1),
+          interp_point(alt, newalt, hint.Alt().index() + 1),
+          interp_point(lat, newlat, hint.Lat().index() + 1),
+          interp_point(lon, newlon, hint.Lon().index() + 1)};
+}
+
+Atm::Atm(const std::vector<Time> &t,
+         const std::vector<Altitude<AltitudeType::meter>> &a,
+         const std::vector<Coordinate<CoordinateType::lat>> &la,
+         const std::vector<Coordinate<CoordinateType::lon>> &lo,
+         const Grid<Point, 4> &d)
+    : tid(t), alt(a), lat(la), lon(lo), nnlte(0) {
+  if (d.sizes() not_eq std::array<std::size_t, 4>{tid.size(), alt.size(),
+                                                   lat.size(), lon.size()})
+    throw std::runtime_error("Bad atmosphere");
+  if (size()) {
+    spec = d(0, 0, 0, 0).specs();
+    nnlte = d(0, 0, 0, 0).nlte.size();
   }
+  resize();
 
-  if (alt.size() > 1) {
-    auto altpos = std::find_if(alt.cbegin(), alt.cend(),
-                               [newalt](auto a) { return newalt <= a; });
-    auto altlow = (altpos == alt.cbegin()) ? alt.cbegin() : altpos - 1;
-    auto altw = (altpos == alt.cend())
-                    ? 1.0
-                    : Interp::weight(newalt, altlow->value(), altpos->value());
-    altout = LinearInterpPoint(altw, size_t(altlow - alt.cbegin()));
+  std::size_t i = 0;
+  for (auto &x : d) {
+    if (x.specs() not_eq spec or x.nlte.size() not_eq nnlte)
+      throw std::runtime_error("Bad atmosphere");
+    point(i++, x);
   }
+  set_uniform();
+}
+
+void Atm::resize() {
+  const std::size_t n = size();
+  P.resize(n);
+  T.resize(n);
+  M.resize(n, Magnetism<MagnetismType::T>({0, 0, 0}));
+  W.resize(n, Wind<WindType::meters_per_second>({0, 0, 0}));
+  vmr.resize(n * spec.size());
+  nlte.resize(n * nnlte);
+}
 
-  if (lat.size() > 1) {
-    auto latpos = std::find_if(lat.cbegin(), lat.cend(),
-                               [newlat](auto a) { return newlat <= a; });
-    auto latlow = (latpos == lat.cbegin()) ? lat.cbegin() : latpos - 1;
-    auto latw = (latpos == lat.cend())
-                    ? 1.0
-                    : Interp::weight(newlat, latlow->value(), latpos->value());
-    latout = LinearInterpPoint(latw, size_t(latlow - lat.cbegin()));
+void Atm::parse(const char *first, const char *last) {
+  const std::size_t n = size();
+  for (std::size_t i = 0; i < n; i++) {
+    P[i] = parse_number(first, last);
+    T[i] = parse_number(first, last);
+    M[i].u() = parse_number(first, last);
+    M[i].v() = parse_number(first, last);
+    M[i].w() = parse_number(first, last);
+    W[i].u() = parse_number(first, last);
+    W[i].v() = parse_number(first, last);
+    W[i].w() = parse_number(first, last);
+    for (std::size_t is = 0; is < spec.size(); is++)
+      vmr[is * n + i] = parse_number(first, last);
+    for (std::size_t il = 0; il < nnlte; il++)
+      nlte[il * n + i] = parse_number(first, last);
   }
 
-  if (lon.size() > 1) {
-    auto lonpos = std::find_if(lon.cbegin(), lon.cend(),
-                               [newlon](auto a) { return newlon <= a; });
-    auto lonlow = (lonpos == lon.cbegin()) ? lon.cbegin() : lonpos - 1;
-    auto lonw = (lonpos == lon.cend())
-                    ? 1.0
-                    : Interp::weight(newlon, lonlow->value(), lonpos->value());
-    lonout = LinearInterpPoint(lonw, size_t(lonlow - lon.cbegin()));
+  while (first not_eq last and std::isspace(static_cast<unsigned char>(*first)))
+    first++;
+  if (first not_eq last) {
+    const char *const value = first;
+    while (first not_eq last and first - value < 20 and
+           not std::isspace(static_cast<unsigned char>(*first)))
+      first++;
+    std::ostringstream os;
+    os << "Expected " << n << " points in the data of the atmosphere, got "
+       << "more: \"" << std::string(value, first) << "\"\n";
+    throw std::runtime_error(os.str());
   }
+}
 
-  return {tidout, altout, latout, lonout};
+Point Atm::point(std::size_t i) const {
+  const std::size_t n = size();
+  Point out(spec);
+  out.P = P[i];
+  out.T = T[i];
+  out.M = M[i];
+  out.W = W[i];
+  for (std::size_t is = 0; is < spec.size(); is++)
+    out.vmr[is].value() = vmr[is * n + i];
+  out.nlte.resize(nnlte);
+  for (std::size_t il = 0; il < nnlte; il++) out.nlte[il] = nlte[il * n + i];
+  return out;
+}
+
+void Atm::point(std::size_t i, const Point &p) {
+  if (p.vmr.size() not_eq spec.size() or p.nlte.size() not_eq nnlte) {
+    std::ostringstream os;
+    os << "A point of " << p.vmr.size() << " species and " << p.nlte.size()
+       << " NLTE levels cannot be set in an atmosphere of " << spec.size()
+       << " species and " << nnlte << " NLTE levels\n";
+    throw std::runtime_error(os.str());
+  }
+  for (std::size_t is = 0; is < spec.size(); is++) {
+    if (spec[is] == Species::Isotope()) {
+      spec[is] = p.vmr[is].isot();
+    } else if (spec[is] not_eq p.vmr[is].isot()) {
+      std::ostringstream os;
+      os << "Species " << is << " of the atmosphere is " << spec[is]
+         << ", not " << p.vmr[is].isot() << " as of the point\n";
+      throw std::runtime_error(os.str());
+    }
+  }
+
+  const std::size_t n = size();
+  P[i] = p.P;
+  T[i] = p.T;
+  M[i] = p.M;
+  W[i] = p.W;
+  for (std::size_t is = 0; is < spec.size(); is++)
+    vmr[is * n + i] = p.vmr[is].value();
+  for (std::size_t il = 0; il < nnlte; il++) nlte[il * n + i] = p.nlte[il];
 }
 
 Point Atm::operator()(const InterPoints &aip) const noexcept {
   const auto map = aip.Weights();
 
-  Point out(map[0].weight() *
-            data(map[0].tid(), map[0].alt(), map[0].lat(), map[0].lon()));
-  for (size_t i = 1; i < map.size(); i++) {
-    if (map[i].weight() not_eq 0) {
-      out += LazyPoint(
-          data(map[i].tid(), map[i].alt(), map[i].lat(), map[i].lon()),
-          map[i].weight());
+  // The points with weight, always including the first
+  std::array<std::size_t, InterPoints::Output::size()> pos;
+  std::array<double, InterPoints::Output::size()> w;
+  std::size_t np = 0;
+  for (size_t i = 0; i < map.size(); i++) {
+    if (i == 0 or map[i].weight() not_eq 0) {
+      pos[np] = index(map[i].tid(), map[i].alt(), map[i].lat(), map[i].lon());
+      w[np] = map[i].weight();
+      np++;
     }
   }
 
-  // Note that this is necessary to fix the arithmetic of adding pressures
-  out.expP();
+  // The weighted sum of a field, with the pressure summed as its logarithm
+  auto sum = [&](const auto *x) {
+    auto out = w[0] * x[pos[0]];
+    for (std::size_t i = 1; i < np; i++) out += w[i] * x[pos[i]];
+    return out;
+  };
+
+  const std::size_t n = size();
+  Point out(spec);
+  double logp = w[0] * std::log(P[pos[0]]);
+  for (std::size_t i = 1; i < np; i++) logp += std::log(P[pos[i]]) * w[i];
+  out.P = std::exp(logp);
+  out.T = sum(T.data());
+  out.M = M[pos[0]];
+  out.M *= w[0];
+  out.W = W[pos[0]];
+  out.W *= w[0];
+  for (std::size_t i = 1; i < np; i++) {
+    auto m = M[pos[i]];
+    out.M += m *= w[i];
+    auto v = W[pos[i]];
+    out.W += v *= w[i];
+  }
+  for (std::size_t is = 0; is < spec.size(); is++)
+    out.vmr[is].value() = sum(vmr.data() + is * n);
+  out.nlte.resize(nnlte);
+  for (std::size_t il = 0; il < nnlte; il++)
+    out.nlte[il] = sum(nlte.data() + il * n);
 
   return out;
 }
@@ -1,8 +1,11 @@
 #ifndef atm_h
 #define atm_h
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <iostream>
+#include <utility>
 #include <vector>
 
 #include "constants.h"
@@ -17,20 +20,23 @@
 namespace Atmosphere {
 class LazyPoint;
 
+class Atm;
+
 class Point {
   friend class LazyPoint;
+  friend class Atm;
 
   Pressure<PressureType::Pa> P;
   Temperature<TemperatureType::K> T;
   Magnetism<MagnetismType::T> M;
   Wind<WindType::meters_per_second> W;
-  std::vector<VMR<VMRType::ratio>> vmr;
-  std::vector<NLTE<NLTEType::ratio>> nlte;
+  VMRs vmr;
+  SmallVector<NLTE<NLTEType::ratio>, 4> nlte;
 
  public:
   Point(Pressure<PressureType::Pa> p, Temperature<TemperatureType::K> t,
         Magnetism<MagnetismType::T> m, Wind<WindType::meters_per_second> w,
-        const std::vector<VMR<VMRType::ratio>> &v) noexcept
+        const VMRs &v) noexcept
       : P(p), T(t), M(m), W(w), vmr(v), nlte(0) {}
 
   Point(decltype(vmr)::size_type n = 0) noexcept
@@ -53,6 +59,23 @@ class Point {
     return *this;
   }
 
+  Point(Point &&ap) noexcept
+      : P(ap.P),
+        T(ap.T),
+        M(ap.M),
+        W(ap.W),
+        vmr(std::move(ap.vmr)),
+        nlte(std::move(ap.nlte)) {}
+  Point &operator=(Point &&ap) noexcept {
+    P = ap.P;
+    T = ap.T;
+    M = ap.M;
+    W = ap.W;
+    vmr = std::move(ap.vmr);
+    nlte = std::move(ap.nlte);
+    return *this;
+  }
+
   decltype(vmr)::size_type size() const { return vmr.size(); }
 
   void resize(decltype(vmr)::size_type n) { vmr.resize(n); }
@@ -88,9 +111,7 @@ class Point {
 
   Wind<WindType::meters_per_second> &WindField() noexcept { return W; }
 
-  const std::vector<VMR<VMRType::ratio>> &VolumeMixingRatios() const {
-    return vmr;
-  }
+  const VMRs &VolumeMixingRatios() const { return vmr; }
 
   double VolumeMixingRatio(Species::Isotope s) const noexcept {
     if (auto v = std::find_if(vmr.cbegin(), vmr.cend(),
@@ -268,7 +289,7 @@ class Point {
     file.write(M);
     file.write(W);
     for (auto x : vmr) file.write(x.value());
-    file.write(nlte);
+    for (auto n : nlte) file.write(n);
   }
 
   template <typename Input>
@@ -285,7 +306,7 @@ class Point {
     file.read(M);
     file.read(W);
     for (auto &x : vmr) file.read(x.value());
-    file.read(nlte);
+    for (auto &n : nlte) file.read(n);
   }
 };  // Point
 
@@ -348,6 +369,11 @@ class InterPoints {
     return *this;
   }
 
+  constexpr LinearInterpPoint Tid() const noexcept { return tid; }
+  constexpr LinearInterpPoint Alt() const noexcept { return alt; }
+  constexpr LinearInterpPoint Lat() const noexcept { return lat; }
+  constexpr LinearInterpPoint Lon() const noexcept { return lon; }
+
   class Uses {
     double w;
     size_t itid;
@@ -476,34 +502,274 @@ class InterPoints {
   }
 };
 
+/** Coordinate of a grid value for interpolation */
+inline double grid_coord(const Time &t) { return t.Seconds(); }
+
+template <typename T>
+double grid_coord(const T &x) noexcept {
+  return x.value();
+}
+
+/** Whether a grid time comes before the position of t, which is after the
+ * grid times not after t */
+inline auto grid_before(const Time &t) {
+  return [t](const Time &a) { return a < t or a == t; };
+}
+
+/** Whether a grid value comes before the position of x, which is at the first
+ * grid value not below x */
+template <typename T>
+auto grid_before(const T &x) noexcept {
+  return [x](const T &a) { return not(x <= a); };
+}
+
+/** Interpolation point of v on the increasing grid x given its position */
+template <typename T>
+LinearInterpPoint grid_point(const std::vector<T> &x, const T &v,
+                             std::size_t pos) {
+  if (pos == x.size()) return {1, pos - 1};
+  const std::size_t low = pos == 0 ? 0 : pos - 1;
+  return {Interp::weight(grid_coord(v), grid_coord(x[low]),
+                         grid_coord(x[pos])),
+          low};
+}
+
+/** Interpolation point of v on the increasing grid x, by bisection */
+template <typename T>
+LinearInterpPoint interp_point(const std::vector<T> &x, const T &v) {
+  if (x.size() < 2) return {1, 0};
+  return grid_point(
+      x, v,
+      std::size_t(std::partition_point(x.cbegin(), x.cend(), grid_before(v)) -
+                  x.cbegin()));
+}
+
+/** Interpolation point of v on the increasing grid x, galloping from a guess
+ * of its position such as the one of a nearby value */
+template <typename T>
+LinearInterpPoint interp_point(const std::vector<T> &x, const T &v,
+                               std::size_t hint) {
+  if (x.size() < 2) return {1, 0};
+  return grid_point(x, v, Interp::gallop(x, hint, grid_before(v)));
+}
+
 class Atm {
   std::vector<Time> tid;
   std::vector<Altitude<AltitudeType::meter>> alt;
   std::vector<Coordinate<CoordinateType::lat>> lat;
   std::vector<Coordinate<CoordinateType::lon>> lon;
-  Grid<Point, 4> data;
 
-  bool ok() const {
-    auto specs = operator()(0, 0, 0, 0).specs();
-    for (auto &x : data) {
-      if (specs not_eq x.specs()) return false;
+  /** Species and number of NLTE levels of all points */
+  std::vector<Species::Isotope> spec;
+  std::size_t nnlte;
+
+  /** Each field of all points in the row-major order of the grids, with one
+   * field after the other for the volume mixing ratios and NLTE levels */
+  std::vector<Pressure<PressureType::Pa>> P;
+  std::vector<Temperature<TemperatureType::K>> T;
+  std::vector<Magnetism<MagnetismType::T>> M;
+  std::vector<Wind<WindType::meters_per_second>> W;
+  std::vector<double> vmr;
+  std::vector<NLTE<NLTEType::ratio>> nlte;
+
+  /** First value and inverse step of each of tid, alt, lat and lon that is
+   * uniform enough to guess the positions of values, or zeroes */
+  std::array<std::array<double, 2>, 4> uniform;
+
+  /** Sets uniform, to be called whenever the grids change */
+  void set_uniform() noexcept;
+
+  std::size_t size() const noexcept {
+    return tid.size() * alt.size() * lat.size() * lon.size();
+  }
+
+  std::size_t index(size_t i, size_t j, size_t k, size_t m) const noexcept {
+    return ((i * alt.size() + j) * lat.size() + k) * lon.size() + m;
+  }
+
+  /** Sizes the fields to the grids, species and NLTE levels */
+  void resize();
+
+  bool ok() const noexcept {
+    const std::size_t n = size();
+    return P.size() == n and T.size() == n and M.size() == n and
+           W.size() == n and vmr.size() == n * spec.size() and
+           nlte.size() == n * nnlte;
+  }
+
+  /** Bytes of the fields as stored in binary files */
+  std::size_t bytes() const noexcept {
+    return size() * (8 + spec.size() + nnlte) * sizeof(double);
+  }
+
+  /** Sets the fields from the text of points in [first, last), as written by
+   * saveAtm, without locale or stream overhead
+   *
+   * Throws if a value is missing or not a number, or if values are left over
+   */
+  void parse(const char *first, const char *last);
+
+  /** Writes get(i) for i in [0, n) to a binary file as plain doubles, a
+   * buffer at a time */
+  template <typename Output, typename Get>
+  static void writeDoubles(Output &file, std::size_t n, Get get) {
+    std::array<double, 1024> buf;
+    for (std::size_t i = 0; i < n; i += buf.size()) {
+      const std::size_t m = std::min(buf.size(), n - i);
+      for (std::size_t j = 0; j < m; j++) buf[j] = get(i + j);
+      file.write(buf.data(), m * sizeof(double));
+    }
+  }
+
+  /** Reads n plain doubles of a binary file, a buffer at a time, and calls
+   * set(i, x) for each */
+  template <typename Input, typename Set>
+  static void readDoubles(Input &file, std::size_t n, Set set) {
+    std::array<double, 1024> buf;
+    for (std::size_t i = 0; i < n; i += buf.size()) {
+      const std::size_t m = std::min(buf.size(), n - i);
+      file.read(buf.data(), m * sizeof(double));
+      for (std::size_t j = 0; j < m; j++) set(i + j, buf[j]);
     }
-    return true;
   }
 
+  /** Component k of a vector field value v */
+  template <typename V>
+  static double &component(V &v, std::size_t k) noexcept {
+    return k == 0 ? v.u() : k == 1 ? v.v() : v.w();
+  }
+
+  /** Reads the fields of a binary file, one block each */
+  template <typename Input>
+  void readFields(Input &file) {
+    readDoubles(file, P.size(), [this](auto i, double x) { P[i] = x; });
+    readDoubles(file, T.size(), [this](auto i, double x) { T[i] = x; });
+    readDoubles(file, 3 * M.size(), [this](auto i, double x) {
+      component(M[i / 3], i % 3) = x;
+    });
+    readDoubles(file, 3 * W.size(), [this](auto i, double x) {
+      component(W[i / 3], i % 3) = x;
+    });
+    readDoubles(file, vmr.size(), [this](auto i, double x) { vmr[i] = x; });
+    readDoubles(file, nlte.size(), [this](auto i, double x) { nlte[i] = x; });
+  }
+
+  /** Writes the fields to a binary file as plain doubles, one block each */
+  template <typename Output>
+  void saveFields(Output &file) const {
+    writeDoubles(file, P.size(), [this](auto i) { return P[i].value(); });
+    writeDoubles(file, T.size(), [this](auto i) { return T[i].value(); });
+    writeDoubles(file, 3 * M.size(),
+                 [this](auto i) { return M[i / 3].value()[i % 3]; });
+    writeDoubles(file, 3 * W.size(),
+                 [this](auto i) { return W[i / 3].value()[i % 3]; });
+    writeDoubles(file, vmr.size(), [this](auto i) { return vmr[i]; });
+    writeDoubles(file, nlte.size(), [this](auto i) { return nlte[i].value(); });
+  }
+
+  /** The point at position i of the fields */
+  Point point(std::size_t i) const;
+
+  /** Sets the point at position i of the fields
+   *
+   * Unnamed species of the atmosphere take the names of those of the point,
+   * other species must be the same as those of the point
+   */
+  void point(std::size_t i, const Point &p);
+
+ public:
+  /** A point of the grids, read and changed like a Point and converted to one
+   *
+   * A is Atm, or const Atm for points that are only read.  A view cannot be
+   * copied, and only the temporary view returned by indexing an Atm changes
+   * the point.  Convert to a Point for a copy that outlives the indexing
+   */
+  template <typename A>
+  class PointView {
+    A *atm;
+    std::size_t i;
+
+   public:
+    PointView(A &a, std::size_t pos) noexcept : atm(&a), i(pos) {}
+    PointView(const PointView &) = delete;
+
+    PointView &operator=(const Point &p) && {
+      atm->point(i, p);
+      return *this;
+    }
+
+    PointView &operator=(const PointView &p) && {
+      return std::move(*this) = Point(p);
+    }
+
+    operator Point() const { return atm->point(i); }
+
+    Pressure<PressureType::Pa> Pres() const noexcept { return atm->P[i]; }
+
+    Temperature<TemperatureType::K> Temp() const noexcept { return atm->T[i]; }
+
+    void Temp(Temperature<TemperatureType::K> x) && noexcept { atm->T[i] = x; }
+
+    auto &MagField() && noexcept { return atm->M[i]; }
+
+    Magnetism<MagnetismType::T> MagField() const & noexcept {
+      return atm->M[i];
+    }
+
+    auto &WindField() && noexcept { return atm->W[i]; }
+
+    Wind<WindType::meters_per_second> WindField() const & noexcept {
+      return atm->W[i];
+    }
+
+    auto &NonLTERatio(std::size_t id) && noexcept {
+      return atm->nlte[id * atm->size() + i];
+    }
+
+    NLTE<NLTEType::ratio> NonLTERatio(std::size_t id) const & noexcept {
+      return atm->nlte[id * atm->size() + i];
+    }
+
+    double VolumeMixingRatio(Species::Isotope s) const noexcept {
+      for (std::size_t is = 0; is < atm->spec.size(); is++)
+        if (atm->spec[is] == s) return atm->vmr[is * atm->size() + i];
+      return 0;
+    }
+
+    void VolumeMixingRatio(Species::Isotope s, double x) && noexcept {
+      for (std::size_t is = 0; is < atm->spec.size(); is++)
+        if (atm->spec[is] == s) {
+          atm->vmr[is * atm->size() + i] = x;
+          return;
+        }
+    }
+
+    VMRs VolumeMixingRatios() const {
+      return Point(*this).VolumeMixingRatios();
+    }
+
+    const std::vector<Species::Isotope> &specs() const noexcept {
+      return atm->spec;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const PointView &p) {
+      return os << Point(p);
+    }
+  };  // PointView
+
  public:
   Atm(const std::vector<Time> &t,
       const std::vector<Altitude<AltitudeType::meter>> &a,
       const std::vector<Coordinate<CoordinateType::lat>> &la,
       const std::vector<Coordinate<CoordinateType::lon>> &lo,
-      const Grid<Point, 4> &d)
-      : tid(t), alt(a), lat(la), lon(lo), data(d) {
-    if (not ok()) throw std::runtime_error("Bad atmosphere");
-  }
+      const Grid<Point, 4> &d);
 
   Atm(std::size_t t = 0, std::size_t a = 0, std::size_t la = 0,
       std::size_t lo = 0, std::size_t s = 0)
-      : tid(t), alt(a), lat(la), lon(lo), data(s, t, a, la, lo) {}
+      : tid(t), alt(a), lat(la), lon(lo), spec(s), nnlte(0) {
+    resize();
+    set_uniform();
+  }
 
   size_t ntid() const noexcept { return tid.size(); }
   size_t nalt() const noexcept { return alt.size(); }
@@ -528,7 +794,7 @@ class Atm {
         for (decltype(a.lat.size()) k = 0; k < a.lat.size(); k++) {
           for (decltype(a.lon.size()) m = 0; m < a.lon.size(); m++) {
             os << a.tid[i] << ' ' << a.alt[j] << ' ' << a.lat[k] << ' '
-               << a.lon[m] << ' ' << a.data(i, j, k, m);
+               << a.lon[m] << ' ' << a(i, j, k, m);
             if (i < a.tid.size() - 1 or j < a.alt.size() - 1 or
                 k < a.lat.size() - 1 or m < a.lon.size() - 1)
               os << '\n';
@@ -545,31 +811,45 @@ class Atm {
       for (decltype(a.alt.size()) j = 0; j < a.alt.size(); j++) {
         for (decltype(a.lat.size()) k = 0; k < a.lat.size(); k++) {
           for (decltype(a.lon.size()) m = 0; m < a.lon.size(); m++) {
-            is >> a.tid[i] >> a.alt[j] >> a.lat[k] >> a.lon[m] >>
-                a.data(i, j, k, m);
+            Point p(a.spec);
+            is >> a.tid[i] >> a.alt[j] >> a.lat[k] >> a.lon[m] >> p;
+            a(i, j, k, m) = p;
           }
         }
       }
     }
+    a.set_uniform();
     return is;
   }
 
-  Point &operator()(size_t i, size_t j, size_t k, size_t m) noexcept {
-    return data(i, j, k, m);
+  PointView<Atm> operator()(size_t i, size_t j, size_t k, size_t m) noexcept {
+    return {*this, index(i, j, k, m)};
   }
 
-  const Point &operator()(size_t i, size_t j, size_t k,
-                          size_t m) const noexcept {
-    return data(i, j, k, m);
+  PointView<const Atm> operator()(size_t i, size_t j, size_t k,
+                                  size_t m) const noexcept {
+    return {*this, index(i, j, k, m)};
   }
 
   Point operator()(const InterPoints &aip) const noexcept;
 
+  /** The grid points around a position and their weights
+   *
+   * Uniform grids locate the position directly, others by bisection
+   */
   InterPoints interpPoints(
       const Time newtid, const Altitude<AltitudeType::meter> newalt,
       const Coordinate<CoordinateType::lat> newlat,
       const Coordinate<CoordinateType::lon> newlon) const noexcept;
 
+  /** As interpPoints, but searching the grids from the points of a nearby
+   * position, such as the previous one along a path */
+  InterPoints interpPoints(const Time newtid,
+                           const Altitude<AltitudeType::meter> newalt,
+                           const Coordinate<CoordinateType::lat> newlat,
+                           const Coordinate<CoordinateType::lon> newlon,
+                           const InterPoints &hint) const noexcept;
+
   Point operator()(
       const Time newtid, const Altitude<AltitudeType::meter> newalt,
       const Coordinate<CoordinateType::lat> newlat,
@@ -583,6 +863,13 @@ class Atm {
     return {ip, operator()(ip)};
   }
 
+  template <typename Pos>
+  std::pair<InterPoints, Point> operator()(Pos pos,
+                                           const InterPoints &hint) const {
+    auto ip = interpPoints(pos.t(), pos.h(), pos.lat(), pos.lon(), hint);
+    return {ip, operator()(ip)};
+  }
+
   friend void saveAtm(File::File<File::Operation::Write, File::Type::Xml> &file,
                       const Atm &a) {
     if (not a.ok()) throw std::runtime_error("Bad atmosphere");
@@ -592,7 +879,8 @@ class Atm {
     file.add_attribute("Altitudes", a.alt.size());
     file.add_attribute("Latitudes", a.lat.size());
     file.add_attribute("Longitudes", a.lon.size());
-    file.add_attribute("Species", a(0, 0, 0, 0).specs());
+    file.add_attribute("Species", a.spec);
+    file.add_attribute("NLTE", a.nnlte);
 
     file.new_child("Time");
     file << '\n' << a.tid;
@@ -616,7 +904,7 @@ class Atm {
         for (decltype(a.lat.size()) k = 0; k < a.lat.size(); k++) {
           for (decltype(a.lon.size()) m = 0; m < a.lon.size(); m++) {
             file << '\n';
-            a(i, j, k, m).savePureAscii(file);
+            a.point(a.index(i, j, k, m)).savePureAscii(file);
           }
         }
       }
@@ -637,7 +925,10 @@ class Atm {
     file.add_attribute("Altitudes", a.alt.size());
     file.add_attribute("Latitudes", a.lat.size());
     file.add_attribute("Longitudes", a.lon.size());
-    file.add_attribute("Species", a(0, 0, 0, 0).specs());
+    file.add_attribute("Species", a.spec);
+    file.add_attribute("NLTE", a.nnlte);
+    file.add_attribute("Layout", "Fields");
+    file.add_attribute("Bytes", a.bytes());
 
     file.new_child("Time");
     file.write(a.tid);
@@ -656,15 +947,7 @@ class Atm {
     file.leave_child();
 
     file.new_child("Data");
-    for (decltype(a.tid.size()) i = 0; i < a.tid.size(); i++) {
-      for (decltype(a.alt.size()) j = 0; j < a.alt.size(); j++) {
-        for (decltype(a.lat.size()) k = 0; k < a.lat.size(); k++) {
-          for (decltype(a.lon.size()) m = 0; m < a.lon.size(); m++) {
-            a(i, j, k, m).saveBinary(file);
-          }
-        }
-      }
-    }
+    a.saveFields(file);
     file.leave_child();
 
     file.leave_child();
@@ -677,7 +960,8 @@ class Atm {
     a.alt.resize(file.get_attribute("Altitudes").as_int());
     a.lat.resize(file.get_attribute("Latitudes").as_int());
     a.lon.resize(file.get_attribute("Longitudes").as_int());
-    auto specs = file.get_vector_attribute<Species::Isotope>("Species");
+    a.spec = file.get_vector_attribute<Species::Isotope>("Species");
+    a.nnlte = file.get_attribute("NLTE").as_uint();
 
     file.get_child("Time");
     file >> a.tid;
@@ -695,19 +979,11 @@ class Atm {
     file >> a.lon;
     file.leave_child();
 
-    a.data.resize(a.tid.size(), a.alt.size(), a.lat.size(), a.lon.size());
-    auto data = std::istringstream(file.get_child("Data").text().as_string());
-    for (decltype(a.tid.size()) i = 0; i < a.tid.size(); i++) {
-      for (decltype(a.alt.size()) j = 0; j < a.alt.size(); j++) {
-        for (decltype(a.lat.size()) k = 0; k < a.lat.size(); k++) {
-          for (decltype(a.lon.size()) m = 0; m < a.lon.size(); m++) {
-            a(i, j, k, m) = specs;
-            a(i, j, k, m).readPureAscii(data);
-          }
-        }
-      }
-    }
+    a.resize();
+    const char *data = file.get_child("Data").text().as_string();
+    a.parse(data, data + std::strlen(data));
     file.leave_child();
+    a.set_uniform();
 
     file.leave_child();
   }
@@ -719,7 +995,10 @@ class Atm {
     a.alt.resize(file.get_attribute("Altitudes").as_int());
     a.lat.resize(file.get_attribute("Latitudes").as_int());
     a.lon.resize(file.get_attribute("Longitudes").as_int());
-    auto specs = file.get_vector_attribute<Species::Isotope>("Species");
+    a.spec = file.get_vector_attribute<Species::Isotope>("Species");
+    a.nnlte = file.get_attribute("NLTE").as_uint();
+    const std::string layout = file.get_attribute("Layout").as_string();
+    const auto bytes = file.get_attribute("Bytes").as_ullong();
 
     file.get_child("Time");
     file.read(a.tid);
@@ -737,18 +1016,32 @@ class Atm {
     file.read(a.lon);
     file.leave_child();
 
-    a.data.resize(a.tid.size(), a.alt.size(), a.lat.size(), a.lon.size());
-    for (decltype(a.tid.size()) i = 0; i < a.tid.size(); i++) {
-      for (decltype(a.alt.size()) j = 0; j < a.alt.size(); j++) {
-        for (decltype(a.lat.size()) k = 0; k < a.lat.size(); k++) {
-          for (decltype(a.lon.size()) m = 0; m < a.lon.size(); m++) {
-            a(i, j, k, m) = specs;
-            a(i, j, k, m).readBinary(file);
-          }
-        }
+    a.resize();
+    file.get_child("Data");
+    if (layout == "Fields" and bytes == a.bytes()) {
+      a.readFields(file);
+    } else if (layout.empty()) {
+      // Files of point after point, from before the fields were kept apart
+      for (std::size_t i = 0; i < a.size(); i++) {
+        Point p(a.spec);
+        p.readBinary(file);
+        a.point(i, p);
       }
+    } else {
+      std::ostringstream os;
+      os << "Cannot read an atmosphere of layout \"" << layout << "\" and "
+         << bytes << " bytes of data, expected layout \"Fields\" and "
+         << a.bytes() << " bytes\n";
+      throw std::runtime_error(os.str());
+    }
+    if (not file.good()) {
+      std::ostringstream os;
+      os << "The data of the atmosphere ends early, expected " << a.bytes()
+         << " bytes\n";
+      throw std::runtime_error(os.str());
     }
     file.leave_child();
+    a.set_uniform();
 
     file.leave_child();
   }
@@ -1,5 +1,8 @@
 #include "atmpath.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Path {
 std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
     Geom::Nav nav, const Atmosphere::Atm& atm,
@@ -28,7 +31,7 @@ std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
   for (;;) {
     bool hit_surface = nav.move(dist);
     pos = nav.ellipsoidPos();
-    data = atm(pos);
+    data = atm(pos, data.first);
     out.push_back({nav, data});
     if (hit_surface or pos.h() > alt_of_atm) break;
   }
@@ -39,7 +42,7 @@ std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
   if (pos.h() > alt_of_atm) {
     nav.move(alt_of_atm, false);
     pos = nav.ellipsoidPos();
-    data = atm(pos);
+    data = atm(pos, data.first);
     out.back() = Point{nav, data};
   }
 
@@ -49,6 +52,74 @@ std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
     return {out, BackgroundType::Surface};
 }
 
+namespace {
+/** The points of path to keep so that the others are within tolerance */
+std::vector<Point> adapt(const std::vector<Point>& path,
+                         const Tolerance& tolerance) {
+  const std::size_t n = path.size();
+  if (n < 3) return path;
+
+  // Distance along the path and the values to keep within tolerance
+  std::vector<double> s(n, 0), log_p(n), t(n);
+  for (std::size_t i = 0; i < n; i++) {
+    if (i) s[i] = s[i - 1] + dist(path[i - 1], path[i]);
+    log_p[i] = std::log(path[i].atm.Pres());
+    t[i] = path[i].atm.Temp();
+  }
+
+  // Whether point i is within tolerance of the line from point a to point b
+  auto within = [&](std::size_t a, std::size_t i, std::size_t b) {
+    const double x = (s[i] - s[a]) / (s[b] - s[a]);
+    auto off = [x](double ya, double yi, double yb) {
+      return std::abs(yi - ya - x * (yb - ya));
+    };
+    if (not(off(log_p[a], log_p[i], log_p[b]) <= tolerance.log_p and
+            off(t[a], t[i], t[b]) <= tolerance.t))
+      return false;
+
+    const auto &va = path[a].atm.VolumeMixingRatios(),
+               &vi = path[i].atm.VolumeMixingRatios(),
+               &vb = path[b].atm.VolumeMixingRatios();
+    for (std::size_t is = 0; is < vi.size(); is++) {
+      const double ya = va[is].value(), yi = vi[is].value(),
+                   yb = vb[is].value();
+      const double scale =
+          std::max({std::abs(ya), std::abs(yi), std::abs(yb)});
+      if (not(off(ya, yi, yb) <= tolerance.vmr * scale)) return false;
+    }
+    return true;
+  };
+
+  // From each kept point, the farthest point that leaves all between within
+  // tolerance, and at most the longest step away
+  const double max_dist = tolerance.max_dist * (1 + 1e-9);
+  std::vector<Point> out{path.front()};
+  for (std::size_t a = 0; a < n - 1;) {
+    std::size_t b = a + 1;
+    while (b + 1 < n and s[b + 1] - s[a] <= max_dist) {
+      bool ok = true;
+      for (std::size_t i = a + 1; ok and i <= b; i++) ok = within(a, i, b + 1);
+      if (not ok) break;
+      b++;
+    }
+    out.push_back(path[b]);
+    a = b;
+  }
+  return out;
+}
+}  // namespace
+
+std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
+    Geom::Nav nav, const Atmosphere::Atm& atm,
+    const Distance<DistanceType::meter> dist,
+    const Altitude<AltitudeType::meter> alt_of_atm,
+    const Tolerance& tolerance) {
+  auto [path, background] =
+      calc_single_geometric_path(nav, atm, dist, alt_of_atm);
+  if (tolerance.max_dist <= dist) return {path, background};
+  return {adapt(path, tolerance), background};
+}
+
 Distance<DistanceType::meter> dist(const Point& a, const Point& b) noexcept {
   return std::hypot(a.nav.x() - b.nav.x(), a.nav.y() - b.nav.y(),
                     a.nav.z() - b.nav.z());
@@ -49,6 +49,40 @@ std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
     const Distance<DistanceType::meter> dist,
     const Altitude<AltitudeType::meter> alt_of_atm);
 
+/** How far an adaptive path may be from the path of fixed steps
+ *
+ * At every point of the fixed steps that the adaptive path leaves out, the
+ * pressure, temperature and volume mixing ratios are within these of their
+ * linear interpolation in distance between the neighbouring points that are
+ * kept.  This bounds the atmospheric state at the points of the fixed steps,
+ * not the radiance computed along the path
+ */
+struct Tolerance {
+  /** Of the natural logarithm of the pressure */
+  double log_p;
+
+  /** Of the temperature [K] */
+  double t;
+
+  /** Of the volume mixing ratios, relative to the largest of the point and
+   * its neighbours */
+  double vmr;
+
+  /** Longest step, which keeps all points if no longer than the fixed step */
+  Distance<DistanceType::meter> max_dist;
+};
+
+/** As calc_single_geometric_path, but leaving out the points of the fixed
+ * steps that are within tolerance of the points around them
+ *
+ * The steps are then longer where the atmosphere changes slowly, such as high
+ * up, and as long as dist where it changes fast
+ */
+std::pair<std::vector<Point>, BackgroundType> calc_single_geometric_path(
+    Geom::Nav nav, const Atmosphere::Atm &atm,
+    const Distance<DistanceType::meter> dist,
+    const Altitude<AltitudeType::meter> alt_of_atm, const Tolerance &tolerance);
+
 Distance<DistanceType::meter> dist(const Point &a, const Point &b) noexcept;
 }  // namespace Path
 
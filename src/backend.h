@@ -8,8 +8,8 @@
 #include <vector>
 
 #include "file.h"
+#include "frequency_grid.h"
 #include "gui.h"
-#include "mathhelpers.h"
 #include "python_interface.h"
 #include "timeclass.h"
 
@@ -34,7 +34,7 @@ struct Controller {
   bool mirror;
 
   std::string name;
-  std::vector<std::vector<double>> f;
+  std::vector<FrequencyGrid::Ptr> f;
   std::vector<std::vector<float>> d;
 
   Controller(const std::string &controller_name, const std::string &h, int tcp,
@@ -61,7 +61,7 @@ struct Controller {
     d.resize(N);
     for (size_t i = 0; i < N; i++) {
       const size_t n = freq_counts[i];
-      f[i] = linspace(freq_limits(i, 0), freq_limits(i, 1), n);
+      f[i] = FrequencyGrid::Linear(freq_limits(i, 0), freq_limits(i, 1), n);
       d[i] = std::vector<float>(n, 0);
     }
   }
@@ -98,7 +98,7 @@ struct Controller {
     d.resize(N);
     for (int i = 0; i < N; i++) {
       const int n = freq_counts[i];
-      f[i] = linspace(freq_limits(i, 0), freq_limits(i, 1), n);
+      f[i] = FrequencyGrid::Linear(freq_limits(i, 0), freq_limits(i, 1), n);
       d[i] = std::vector<float>(n, 0);
     }
   }
@@ -116,22 +116,22 @@ std::vector<std::array<GUI::Plotting::Frame, 4>> PlotFrame(
     for (size_t j = 0; j < ctrls[i].f.size(); j++) {
       raw.push_back(GUI::Plotting::Line(
           std::string{"Cold "} + std::to_string(j), ctrls[i].f[j],
-          GUI::Plotting::Data{ctrls[i].f[j].size()}));
+          GUI::Plotting::Data{ctrls[i].f[j]->size()}));
       raw.push_back(GUI::Plotting::Line(
           std::string{"Target "} + std::to_string(j), ctrls[i].f[j],
-          GUI::Plotting::Data{ctrls[i].f[j].size()}));
+          GUI::Plotting::Data{ctrls[i].f[j]->size()}));
       raw.push_back(GUI::Plotting::Line(
           std::string{"Hot "} + std::to_string(j), ctrls[i].f[j],
-          GUI::Plotting::Data{ctrls[i].f[j].size()}));
+          GUI::Plotting::Data{ctrls[i].f[j]->size()}));
       noi.push_back(GUI::Plotting::Line(
           std::string{"System Noise "} + std::to_string(j), ctrls[i].f[j],
-          GUI::Plotting::Data{ctrls[i].f[j].size()}));
+          GUI::Plotting::Data{ctrls[i].f[j]->size()}));
       avg.push_back(GUI::Plotting::Line(
           std::string{"Average Measurement "} + std::to_string(j),
-          ctrls[i].f[j], GUI::Plotting::Data{ctrls[i].f[j].size()}));
+          ctrls[i].f[j], GUI::Plotting::Data{ctrls[i].f[j]->size()}));
       itg.push_back(GUI::Plotting::Line(
           std::string{"Last Measurement "} + std::to_string(j), ctrls[i].f[j],
-          GUI::Plotting::Data{ctrls[i].f[j].size()}));
+          GUI::Plotting::Data{ctrls[i].f[j]->size()}));
     }
     tmp.push_back(std::array<GUI::Plotting::Frame, 4>{
         GUI::Plotting::Frame{"Raw", "Frequency", "Counts", raw},
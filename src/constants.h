@@ -1,6 +1,7 @@
 #ifndef constants_h
 #define constants_h
 
+#include <array>
 #include <cmath>
 
 /** Namespace containing several constants, physical and mathematical **/
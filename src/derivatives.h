@@ -226,6 +226,10 @@ class Target {
       return false;
   }
 
+  constexpr bool isLine(std::size_t id) const noexcept {
+    return mtype == Type::Line and pos_id == id;
+  }
+
   constexpr bool isLineCenter(std::size_t id) const noexcept {
     if (mtype not_eq Type::Line)
       return false;
@@ -0,0 +1,186 @@
+#include "faddeeva.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Faddeeva {
+namespace {
+/** Terms of Weideman's rational approximation */
+constexpr std::size_t N = 36;
+
+/** |x| + y up to where the rational approximation is accurate enough */
+constexpr double R = 13;
+
+/** Close to the real axis, Re w(z) is orders of magnitude smaller than Im w(z)
+ * for |x| >= X and the rational approximation only gives it to the precision
+ * of the latter, so the scalar w(z) is used there for y < Y
+ */
+constexpr double X = 2.5;
+constexpr double Y = 0.1;
+
+/** 1 / sqrt(pi) exactly as in the scalar w(z) */
+constexpr double ispi = 0.56418958354775628694807945156;
+
+/** Arguments handled together, sized to keep the work arrays on the stack */
+constexpr std::size_t block = 256;
+
+const double L = std::sqrt(N / std::sqrt(2.0));
+
+/** The polynomial coefficients of the approximation, highest order first
+ *
+ * From the discrete Fourier transform of exp(-t^2) (L^2 + t^2) at the points
+ * t = L tan(theta / 2), see Weideman, SIAM J. Numer. Anal. 31 (1994) 1497
+ */
+const std::array<double, N> coeffs = [] {
+  constexpr std::size_t M = 2 * N;
+  std::array<double, 2 * M> f{};
+  for (std::size_t k = 1; k < 2 * M; k++) {
+    const double theta = (double(k) - double(M)) * Constant::pi / double(M);
+    const double t = L * std::tan(theta / 2);
+    f[(k + M) % (2 * M)] = std::exp(-t * t) * (L * L + t * t);
+  }
+
+  std::array<double, N> a{};
+  for (std::size_t k = 1; k <= N; k++) {
+    double sum = 0;
+    for (std::size_t j = 0; j < 2 * M; j++)
+      sum += f[j] * std::cos(Constant::pi * double(k * j) / double(M));
+    a[N - k] = sum / double(2 * M);
+  }
+  return a;
+}();
+
+/** Where the scalar w(z) uses its continued fraction, for y > 0 */
+constexpr bool use_continued_fraction(double ax, double y) noexcept {
+  return y > 7 or
+         (ax > 6 and (y > 0.1 or (ax > 8 and y > 1e-10) or ax > 28));
+}
+
+/** w(x + iy) for y > 0 and |x| + y < R */
+void weideman(const double *x, const double *y, double *wr, double *wi,
+              std::size_t n) noexcept {
+  std::array<double, block> Zr, Zi, qr, qi;
+
+  // q = 1 / (L - iz) and Z = (L + iz) / (L - iz)
+  for (std::size_t i = 0; i < n; i++) {
+    const double a = L + y[i];
+    const double d = 1 / (a * a + x[i] * x[i]);
+    qr[i] = a * d;
+    qi[i] = x[i] * d;
+    Zr[i] = (L * L - y[i] * y[i] - x[i] * x[i]) * d;
+    Zi[i] = 2 * L * x[i] * d;
+    wr[i] = coeffs[0];
+    wi[i] = 0;
+  }
+
+  // Horner's scheme for the polynomial in Z
+  for (std::size_t c = 1; c < N; c++) {
+    for (std::size_t i = 0; i < n; i++) {
+      const double pr = wr[i] * Zr[i] - wi[i] * Zi[i] + coeffs[c];
+      const double pi = wr[i] * Zi[i] + wi[i] * Zr[i];
+      wr[i] = pr;
+      wi[i] = pi;
+    }
+  }
+
+  // w = 2 p q^2 + q / sqrt(pi)
+  for (std::size_t i = 0; i < n; i++) {
+    const double q2r = qr[i] * qr[i] - qi[i] * qi[i];
+    const double q2i = 2 * qr[i] * qi[i];
+    const double pr = wr[i];
+    const double pi = wi[i];
+    wr[i] = 2 * (pr * q2r - pi * q2i) + Constant::inv_sqrt_pi * qr[i];
+    wi[i] = 2 * (pr * q2i + pi * q2r) + Constant::inv_sqrt_pi * qi[i];
+  }
+}
+
+/** w(x + iy) for y > 0, x not 0, |x| + y <= 1e7 and use_continued_fraction
+ *
+ * w(z) = i / sqrt(pi) / (z - 1/2 / (z - 1 / (z - 3/2 / (z - ...))))
+ *
+ * With the number of terms, and the order of operations, of the scalar w(z)
+ * so that the two give the same result
+ */
+void continued_fraction(const double *x, const double *y, double *wr,
+                        double *wi, std::size_t n) noexcept {
+  std::array<double, block> nu;
+
+  double numax = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    nu[i] = std::floor(3.9 + 11.398 / (0.08254 * std::abs(x[i]) +
+                                       0.1421 * y[i] + 0.2023));
+    numax = std::max(numax, nu[i]);
+    wr[i] = x[i];
+    wi[i] = y[i];
+  }
+
+  // Only the terms each argument needs, from the innermost
+  for (double k = numax - 1; k > 0; k--) {
+    for (std::size_t i = 0; i < n; i++) {
+      const double denom = (0.5 * k) / (wr[i] * wr[i] + wi[i] * wi[i]);
+      const bool use = k < nu[i];
+      wr[i] = use ? x[i] - wr[i] * denom : wr[i];
+      wi[i] = use ? y[i] + wi[i] * denom : wi[i];
+    }
+  }
+
+  for (std::size_t i = 0; i < n; i++) {
+    if (std::abs(x[i]) + y[i] > 4000) {
+      // Two terms, w(z) = i / sqrt(pi) z / (z^2 - 1/2)
+      const double dr = x[i] * x[i] - y[i] * y[i] - 0.5;
+      const double di = 2 * x[i] * y[i];
+      const double denom = ispi / (dr * dr + di * di);
+      wr[i] = denom * (x[i] * di - y[i] * dr);
+      wi[i] = denom * (x[i] * dr + y[i] * di);
+    } else {
+      const double denom = ispi / (wr[i] * wr[i] + wi[i] * wi[i]);
+      const double r = denom * wi[i];
+      wi[i] = denom * wr[i];
+      wr[i] = r;
+    }
+  }
+}
+}  // namespace
+
+void w(const Complex *z, Complex *out, std::size_t n) noexcept {
+  std::array<std::size_t, block> near_idx, far_idx;
+  std::array<double, block> near_x, near_y, far_x, far_y;
+  std::array<double, block> wr, wi;
+
+  for (std::size_t start = 0; start < n; start += block) {
+    const std::size_t end = std::min(n, start + block);
+
+    // Sort the arguments by how they are computed before writing anything,
+    // since out may be z
+    std::size_t nnear = 0, nfar = 0;
+    for (std::size_t i = start; i < end; i++) {
+      const double x = z[i].real();
+      const double y = z[i].imag();
+      const double ax = std::abs(x);
+      if (y > 0 and x not_eq 0 and ax + y <= 1e7 and
+          use_continued_fraction(ax, y)) {
+        far_idx[nfar] = i;
+        far_x[nfar] = x;
+        far_y[nfar] = y;
+        nfar++;
+      } else if (y > 0 and ax + y < R and (ax < X or y >= Y)) {
+        near_idx[nnear] = i;
+        near_x[nnear] = x;
+        near_y[nnear] = y;
+        nnear++;
+      } else {
+        out[i] = w(z[i]);
+      }
+    }
+
+    weideman(near_x.data(), near_y.data(), wr.data(), wi.data(), nnear);
+    for (std::size_t j = 0; j < nnear; j++)
+      out[near_idx[j]] = Complex(wr[j], wi[j]);
+
+    continued_fraction(far_x.data(), far_y.data(), wr.data(), wi.data(), nfar);
+    for (std::size_t j = 0; j < nfar; j++)
+      out[far_idx[j]] = Complex(wr[j], wi[j]);
+  }
+}
+}  // namespace Faddeeva
@@ -0,0 +1,29 @@
+#ifndef faddeeva_h
+#define faddeeva_h
+
+#include <Faddeeva.hh>
+
+#include <cstddef>
+
+#include "complex.h"
+
+namespace Faddeeva {
+/** Computes out[i] = w(z[i]) for all i < n
+ *
+ * Arguments in the upper half-plane are evaluated together, as plain loops
+ * over the arguments that the compiler vectorizes.  Where the scalar w(z) uses
+ * its continued fraction, the same continued fraction gives the same result.
+ * Closer to the origin, Weideman's rational approximation is accurate to a
+ * relative 1e-13.  Arguments close to the real axis for which that leaves
+ * Re w(z) imprecise, and all others, are passed to the scalar w(z)
+ *
+ * z and out may be the same array
+ *
+ * @param[in] z Arguments of the Faddeeva function
+ * @param[out] out The Faddeeva function of z
+ * @param[in] n Number of arguments
+ */
+void w(const Complex *z, Complex *out, std::size_t n) noexcept;
+}  // namespace Faddeeva
+
+#endif  // faddeeva_h
@@ -1,5 +1,10 @@
 #include "file.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 std::vector<std::string> File::Devices(std::vector<std::string> contains,
                                        size_t maxN) {
   std::vector<std::string> out;
@@ -24,3 +29,53 @@ std::vector<std::string> File::Devices(std::vector<std::string> contains,
 
   return out;
 }
+
+File::Mapped::Mapped(const std::string &path, Access access)
+    : fd(::open(path.c_str(), O_RDONLY)), ptr(nullptr), n(0) {
+  struct stat st;
+  if (fd < 0 or ::fstat(fd, &st) not_eq 0) {
+    if (fd >= 0) ::close(fd);
+    std::ostringstream os;
+    os << '"' << path << '"' << " cannot be opened.  Cannot map it.";
+    throw std::runtime_error(os.str());
+  }
+
+  n = std::size_t(st.st_size);
+  if (n) {
+    void *p = ::mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      std::ostringstream os;
+      os << '"' << path << '"' << " cannot be mapped to memory.";
+      throw std::runtime_error(os.str());
+    }
+    if (access == Access::Sequential) ::madvise(p, n, MADV_SEQUENTIAL);
+    ptr = static_cast<const char *>(p);
+  }
+}
+
+File::Mapped::Mapped(Mapped &&m) noexcept : fd(m.fd), ptr(m.ptr), n(m.n) {
+  m.fd = -1;
+  m.ptr = nullptr;
+  m.n = 0;
+}
+
+File::Mapped &File::Mapped::operator=(Mapped &&m) noexcept {
+  if (this not_eq &m) {
+    close();
+    std::swap(fd, m.fd);
+    std::swap(ptr, m.ptr);
+    std::swap(n, m.n);
+  }
+  return *this;
+}
+
+File::Mapped::~Mapped() noexcept { close(); }
+
+void File::Mapped::close() noexcept {
+  if (ptr) ::munmap(const_cast<char *>(ptr), n);
+  if (fd >= 0) ::close(fd);
+  fd = -1;
+  ptr = nullptr;
+  n = 0;
+}
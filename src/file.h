@@ -16,6 +16,8 @@ ENUMCLASS(Operation, unsigned char, Read, Write, Append, ReadBinary,
 
 ENUMCLASS(Type, unsigned char, Raw, Xml)
 
+ENUMCLASS(Access, unsigned char, Normal, Sequential)
+
 template <class T>
 std::ostream &operator<<(std::ostream &os, const std::vector<T> &x) {
   if constexpr (std::is_arithmetic<T>::value) {
@@ -118,6 +120,12 @@ class File {
     return fil.eof();
   }
 
+  /** Whether all binary data so far was read */
+  bool good() const noexcept {
+    static_assert(X == Operation::ReadBinary);
+    return fil.good();
+  }
+
   template <typename T>
   File &operator<<(const T &x) {
     static_assert(X == Operation::Append or X == Operation::Write,
@@ -353,6 +361,33 @@ class File {
 
 std::vector<std::string> Devices(std::vector<std::string> contains,
                                  size_t maxN = 9);
+
+/** A whole file mapped to memory for reading */
+class Mapped {
+  int fd;
+  const char *ptr;
+  std::size_t n;
+
+  /** Unmaps and closes the file, leaving an empty mapping */
+  void close() noexcept;
+
+ public:
+  /** Maps the file at path, throws if it cannot be opened or mapped
+   *
+   * With Access::Sequential the kernel is told that the file is read from
+   * the front to the back, so it reads ahead further
+   */
+  explicit Mapped(const std::string &path, Access access = Access::Normal);
+  Mapped(Mapped &&m) noexcept;
+  Mapped &operator=(Mapped &&m) noexcept;
+  Mapped(const Mapped &) = delete;
+  Mapped &operator=(const Mapped &) = delete;
+  ~Mapped() noexcept;
+
+  /** The first byte of the file, nullptr if it is empty */
+  const char *data() const noexcept { return ptr; }
+  std::size_t size() const noexcept { return n; }
+};  // Mapped
 }  // namespace File
 
 #endif  // file_h
@@ -65,7 +65,8 @@ Results<N> internal_compute(
     const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
     const std::vector<Derivative::Target>& targets,
     const std::vector<Absorption::Band>& bands,
-    const std::vector<Path::Point>& path) {
+    const std::vector<Path::Point>& path,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables) {
   const size_t np = path.size();
   const size_t nf = f_grid.size();
   const size_t nt = targets.size();
@@ -77,10 +78,13 @@ Results<N> internal_compute(
   Absorption::PropagationMatrix::Results<N> K1(rad0.size(), nt), K2(K1), S1(K1),
       S2(K1), A1(K1), A2(K1);
 
+  // Scratch space of the propagation matrix shared by all path points
+  Absorption::PropagationMatrix::Workspace ws;
+
   // Compute the point farthest from the sensor and set it as starting point
   // (FIXME: Only LTE at this point)
-  Absorption::PropagationMatrix::compute(K2, S2, /*A2,*/ f_grid, bands,
-                                         path[np - 1], targets);
+  Absorption::PropagationMatrix::compute(K2, S2, /*A2,*/ ws, f_grid, bands,
+                                         path[np - 1], targets, tables);
 
   // For all path points starting at the second to last (first is computed
   // already
@@ -92,8 +96,8 @@ Results<N> internal_compute(
     std::swap(A1, A2);
 
     // Compute the current point of the path
-    Absorption::PropagationMatrix::compute(K2, S2, /*A2,*/ f_grid, bands,
-                                           path[ip], targets);
+    Absorption::PropagationMatrix::compute(K2, S2, /*A2,*/ ws, f_grid, bands,
+                                           path[ip], targets, tables);
 
     // Extract and compute this level
     Sub rad_out(rad.x, 0, ip);
@@ -110,10 +114,11 @@ Results<N> internal_compute(
     for (size_t iv = 0; iv < nf; iv++) {
       auto T = TraMat<N>::Identity();
       for (size_t ip = 0; ip < np - 1; ip++) {
-        T = rad.T(ip, iv) *
+        T = rad.T.unchecked(ip, iv) *
             T;  // FIXME: Confirm multiplication order for polarization
         for (size_t id = 0; id < nt; id++) {
-          rad.dx(id, ip + 1, iv) = T * rad.dx(id, ip + 1, iv);
+          auto& dx = rad.dx.unchecked(id, ip + 1, iv);
+          dx = T * dx;
         }
       }
     }
@@ -126,32 +131,36 @@ Results<1> compute(const std::vector<RadVec<1>>& rad0,
                    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
                    const std::vector<Derivative::Target>& targets,
                    const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path) {
-  return internal_compute(rad0, f_grid, targets, bands, path);
+                   const std::vector<Path::Point>& path,
+                   const std::vector<Absorption::Xsec::Lut::Table>& tables) {
+  return internal_compute(rad0, f_grid, targets, bands, path, tables);
 }
 
 Results<2> compute(const std::vector<RadVec<2>>& rad0,
                    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
                    const std::vector<Derivative::Target>& targets,
                    const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path) {
-  return internal_compute(rad0, f_grid, targets, bands, path);
+                   const std::vector<Path::Point>& path,
+                   const std::vector<Absorption::Xsec::Lut::Table>& tables) {
+  return internal_compute(rad0, f_grid, targets, bands, path, tables);
 }
 
 Results<3> compute(const std::vector<RadVec<3>>& rad0,
                    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
                    const std::vector<Derivative::Target>& targets,
                    const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path) {
-  return internal_compute(rad0, f_grid, targets, bands, path);
+                   const std::vector<Path::Point>& path,
+                   const std::vector<Absorption::Xsec::Lut::Table>& tables) {
+  return internal_compute(rad0, f_grid, targets, bands, path, tables);
 }
 
 Results<4> compute(const std::vector<RadVec<4>>& rad0,
                    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
                    const std::vector<Derivative::Target>& targets,
                    const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path) {
-  return internal_compute(rad0, f_grid, targets, bands, path);
+                   const std::vector<Path::Point>& path,
+                   const std::vector<Absorption::Xsec::Lut::Table>& tables) {
+  return internal_compute(rad0, f_grid, targets, bands, path, tables);
 }
 
 template <std::size_t N>
@@ -214,7 +223,8 @@ void compute_convolution_single_path(
     const std::vector<Derivative::Target>& derivs,
     const std::vector<Sensor::Polarization>& measurement_polarization,
     const Sensor::Antenna::Output& antenna,
-    const Sensor::MeasurementUnit unit) {
+    const Sensor::MeasurementUnit unit,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables) {
   std::vector<Atmosphere::InterPoints::Output> weights(antenna.path.size());
   for (std::size_t ip = 0; ip < antenna.path.size(); ip++)
     weights[ip] = antenna.path[ip].ip.Weights();
@@ -224,8 +234,8 @@ void compute_convolution_single_path(
       antenna.background, antenna.path.front().nav.ellipsoidPos(),
       sensor_f_grid);
 
-  auto forward_results =
-      Forward::compute(rad0, sensor_f_grid, derivs, bands, antenna.path);
+  auto forward_results = Forward::compute(rad0, sensor_f_grid, derivs, bands,
+                                          antenna.path, tables);
 
   switch (unit) {
     case Sensor::MeasurementUnit::PlanckBT:
@@ -247,12 +257,15 @@ Convolution compute_convolution(
     const Geom::Nav& pos_los, const std::vector<Absorption::Band>& bands,
     const std::vector<Derivative::Target>& derivs,
     const Sensor::Properties& sensor_prop,
-    const Distance<DistanceType::meter> layer_thickness) {
+    const Distance<DistanceType::meter> layer_thickness,
+    const Path::Tolerance& tolerance,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables) {
   Convolution out(sensor_prop.f_grid.size(), sensor_prop.stokes_dim, atm,
                   derivs);
 
-  const auto paths = sensor_prop.antenna.calc(
-      pos_los, atm, layer_thickness, atm.max_alt(), mean(sensor_prop.f_grid));
+  const auto paths =
+      sensor_prop.antenna.calc(pos_los, atm, layer_thickness, atm.max_alt(),
+                               mean(sensor_prop.f_grid), tolerance);
 
   // Compute and convolve all the different paths (stokes dim must be compiled
   // separately)
@@ -260,19 +273,19 @@ Convolution compute_convolution(
     if (sensor_prop.stokes_dim == 4) {
       compute_convolution_single_path<4>(
           out, background, bands, sensor_prop.f_grid, derivs, sensor_prop.polar,
-          single_path, sensor_prop.unit);
+          single_path, sensor_prop.unit, tables);
     } else if (sensor_prop.stokes_dim == 3) {
       compute_convolution_single_path<3>(
           out, background, bands, sensor_prop.f_grid, derivs, sensor_prop.polar,
-          single_path, sensor_prop.unit);
+          single_path, sensor_prop.unit, tables);
     } else if (sensor_prop.stokes_dim == 2) {
       compute_convolution_single_path<2>(
           out, background, bands, sensor_prop.f_grid, derivs, sensor_prop.polar,
-          single_path, sensor_prop.unit);
+          single_path, sensor_prop.unit, tables);
     } else if (sensor_prop.stokes_dim == 1) {
       compute_convolution_single_path<1>(
           out, background, bands, sensor_prop.f_grid, derivs, sensor_prop.polar,
-          single_path, sensor_prop.unit);
+          single_path, sensor_prop.unit, tables);
     } else {
       std::cerr << "Bad Stokes Dim\n";
       std::terminate();
@@ -42,29 +42,37 @@ struct Results {
   }
 };
 
-Results<1> compute(const std::vector<RadVec<1>>& rad0,
-                   const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
-                   const std::vector<Derivative::Target>& targets,
-                   const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path);
-
-Results<2> compute(const std::vector<RadVec<2>>& rad0,
-                   const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
-                   const std::vector<Derivative::Target>& targets,
-                   const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path);
-
-Results<3> compute(const std::vector<RadVec<3>>& rad0,
-                   const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
-                   const std::vector<Derivative::Target>& targets,
-                   const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path);
-
-Results<4> compute(const std::vector<RadVec<4>>& rad0,
-                   const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
-                   const std::vector<Derivative::Target>& targets,
-                   const std::vector<Absorption::Band>& bands,
-                   const std::vector<Path::Point>& path);
+Results<1> compute(
+    const std::vector<RadVec<1>>& rad0,
+    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
+    const std::vector<Derivative::Target>& targets,
+    const std::vector<Absorption::Band>& bands,
+    const std::vector<Path::Point>& path,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables = {});
+
+Results<2> compute(
+    const std::vector<RadVec<2>>& rad0,
+    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
+    const std::vector<Derivative::Target>& targets,
+    const std::vector<Absorption::Band>& bands,
+    const std::vector<Path::Point>& path,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables = {});
+
+Results<3> compute(
+    const std::vector<RadVec<3>>& rad0,
+    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
+    const std::vector<Derivative::Target>& targets,
+    const std::vector<Absorption::Band>& bands,
+    const std::vector<Path::Point>& path,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables = {});
+
+Results<4> compute(
+    const std::vector<RadVec<4>>& rad0,
+    const std::vector<Frequency<FrequencyType::Freq>>& f_grid,
+    const std::vector<Derivative::Target>& targets,
+    const std::vector<Absorption::Band>& bands,
+    const std::vector<Path::Point>& path,
+    const std::vector<Absorption::Xsec::Lut::Table>& tables = {});
 
 inline std::size_t num_derivs(const std::vector<Derivative::Target>& derivs,
                               std::size_t natm, std::size_t nsurf) noexcept {
@@ -119,7 +127,9 @@ Convolution compute_convolution(
     const Geom::Nav& pos_los, const std::vector<Absorption::Band>& bands,
     const std::vector<Derivative::Target>& derivs,
     const Sensor::Properties& sensor_prop,
-    const Distance<DistanceType::meter> layer_thickness);
+    const Distance<DistanceType::meter> layer_thickness,
+    const Path::Tolerance& tolerance = {0, 0, 0, 0},
+    const std::vector<Absorption::Xsec::Lut::Table>& tables = {});
 
 }  // namespace RTE::Forward
 
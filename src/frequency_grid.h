@@ -0,0 +1,104 @@
+#ifndef frequency_grid_h
+#define frequency_grid_h
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+/** An immutable frequency axis of a spectrometer board
+ *
+ * Grids are only handed out as shared pointers to const, so the controller,
+ * the calibration, the plots and the saved files all refer to the same
+ * object.  Uniform grids are stored as (f0, df, size) and are never expanded
+ * to a vector.  A uniform grid is made once per configuration: asking again
+ * for the same limits and count returns the existing grid as long as anyone
+ * still holds it, and grids nobody holds are forgotten
+ */
+class FrequencyGrid {
+  std::size_t mid;
+  std::size_t n;
+  double mf0;
+  double mdf;
+  double mlast;
+  std::vector<double> irregular;
+
+  static std::size_t next_id() noexcept {
+    static std::mutex mtx;
+    static std::size_t id = 0;
+    std::lock_guard lock{mtx};
+    return id++;
+  }
+
+  FrequencyGrid(double f0, double df, double last, std::size_t count) noexcept
+      : mid(next_id()), n(count), mf0(f0), mdf(df), mlast(last) {}
+  FrequencyGrid(std::vector<double> &&f) noexcept
+      : mid(next_id()),
+        n(f.size()),
+        mf0(n ? f.front() : 0),
+        mdf(0),
+        mlast(n ? f.back() : 0),
+        irregular(std::move(f)) {}
+
+ public:
+  using Ptr = std::shared_ptr<const FrequencyGrid>;
+
+  /** The grid of linspace(s, e, count) */
+  static Ptr Linear(double s, double e, std::size_t count) {
+    using Key = std::tuple<double, double, std::size_t>;
+    static std::mutex mtx;
+    static std::map<Key, std::weak_ptr<const FrequencyGrid>> made;
+
+    std::lock_guard lock{mtx};
+
+    // Forget the grids nobody holds any more, so configurations that are no
+    // longer used do not stay in the map
+    for (auto it = made.begin(); it not_eq made.end();) {
+      if (it->second.expired())
+        it = made.erase(it);
+      else
+        ++it;
+    }
+
+    auto &old = made[Key{s, e, count}];
+    if (auto grid = old.lock()) return grid;
+
+    Ptr grid;
+    if (count == 1)
+      grid = Ptr(new FrequencyGrid((e + s) / 2, 0, (e + s) / 2, 1));
+    else
+      grid = Ptr(new FrequencyGrid(s, count ? (e - s) / double(count - 1) : 0,
+                                   e, count));
+    old = grid;
+    return grid;
+  }
+
+  /** A grid of any frequencies */
+  static Ptr Irregular(std::vector<double> f) {
+    return Ptr(new FrequencyGrid(std::move(f)));
+  }
+
+  /** Unique identifier of the grid during this run */
+  std::size_t id() const noexcept { return mid; }
+
+  std::size_t size() const noexcept { return n; }
+  bool uniform() const noexcept { return irregular.empty(); }
+  double f0() const noexcept { return mf0; }
+  double df() const noexcept { return mdf; }
+
+  double operator[](std::size_t i) const noexcept {
+    if (not uniform()) return irregular[i];
+    return i + 1 == n ? mlast : mf0 + mdf * double(i);
+  }
+
+  /** All frequencies, for users that need them as a vector */
+  std::vector<double> values() const {
+    std::vector<double> out(n);
+    for (std::size_t i = 0; i < n; i++) out[i] = operator[](i);
+    return out;
+  }
+};  // FrequencyGrid
+
+#endif  // frequency_grid_h
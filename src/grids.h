@@ -2,10 +2,14 @@
 #define grids_h
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <numeric>
+#include <type_traits>
 #include <vector>
 
 template <typename... Inds>
@@ -13,42 +17,113 @@ constexpr std::size_t mul(Inds... inds) {
   return (std::size_t(inds) * ...);
 }
 
-/** Row-major grid creation */
+/** Row-major grid creation
+ *
+ * The elements are aligned to 64 bytes for vector instructions.  Copies of
+ * trivially copyable elements are single memory copies, and moves only move
+ * the pointer to the elements
+ */
 template <typename b, std::size_t n>
 class Grid {
-  std::unique_ptr<b[]> ptr;
+ public:
+  static constexpr std::size_t N = n;
+  using base = b;
+  static_assert(N, "Must have size");
+
+  static constexpr std::size_t alignment =
+      std::max(alignof(b), std::size_t(64));
+
+ private:
+  b *ptr;
   std::array<std::size_t, n> gridsize;
 
-  std::size_t nelem() const {
-    return std::reduce(gridsize.cbegin(), gridsize.cend(), 1,
+  std::size_t nelem() const noexcept {
+    return std::reduce(gridsize.cbegin(), gridsize.cend(), std::size_t(1),
                        std::multiplies<std::size_t>());
   }
 
- public:
-  static constexpr std::size_t N = n;
-  using base = b;
-  static_assert(N, "Must have size");
+  /** Aligned memory for count elements, not yet constructed */
+  static base *allocate(std::size_t count) {
+    if (count == 0) return nullptr;
+    return static_cast<base *>(
+        ::operator new(count * sizeof(base), std::align_val_t(alignment)));
+  }
 
+  /** Destroys the elements and frees their memory */
+  void clear() noexcept {
+    if (ptr) {
+      std::destroy_n(ptr, nelem());
+      ::operator delete(ptr, std::align_val_t(alignment));
+      ptr = nullptr;
+    }
+  }
+
+  /** Allocates the elements of the grid sizes and constructs them by init,
+   * which is passed the memory */
+  template <typename Init>
+  void create(Init &&init) {
+    ptr = allocate(nelem());
+    try {
+      init(ptr);
+    } catch (...) {
+      ::operator delete(ptr, std::align_val_t(alignment));
+      ptr = nullptr;
+      throw;
+    }
+  }
+
+  /** Constructs copies of the elements of g, which has the same sizes */
+  void create_copy(const Grid &g) {
+    if constexpr (std::is_trivially_copyable_v<base>) {
+      create([&](base *p) {
+        if (p) std::memcpy(p, g.ptr, nelem() * sizeof(base));
+      });
+    } else {
+      create([&](base *p) { std::uninitialized_copy_n(g.ptr, nelem(), p); });
+    }
+  }
+
+ public:
   template <typename... Inds>
   Grid(const base &fillval, Inds... inds)
-      : ptr(std::make_unique<base[]>(mul(inds...))),
-        gridsize({std::size_t(inds)...}) {
+      : ptr(nullptr), gridsize({std::size_t(inds)...}) {
     static_assert(sizeof...(Inds) == N,
                   "Must have same size for initialization");
-    for (auto &x : *this) x = fillval;
+    create([&](base *p) { std::uninitialized_fill_n(p, nelem(), fillval); });
   }
 
-  Grid(const Grid &g) noexcept
-      : ptr(std::make_unique<base[]>(
-            mul(std::reduce(g.gridsize.cbegin(), g.gridsize.cend(), 1,
-                            std::multiplies<std::size_t>())))),
-        gridsize(g.gridsize) {
-    const std::size_t end = nelem();
-    for (size_t i = 0; i < end; i++) ptr[i] = g.ptr[i];
-  }
+  Grid(const Grid &g) : ptr(nullptr), gridsize(g.gridsize) { create_copy(g); }
 
-  Grid(Grid &&g) noexcept : ptr(g.ptr.release()), gridsize(g.gridsize) {
+  Grid(Grid &&g) noexcept : ptr(g.ptr), gridsize(g.gridsize) {
     g.ptr = nullptr;
+    g.gridsize.fill(0);
+  }
+
+  Grid &operator=(const Grid &g) {
+    if (this == &g) return *this;
+    if (nelem() == g.nelem() and ptr) {
+      if constexpr (std::is_trivially_copyable_v<base>)
+        std::memcpy(ptr, g.ptr, nelem() * sizeof(base));
+      else
+        std::copy_n(g.ptr, nelem(), ptr);
+      gridsize = g.gridsize;
+    } else {
+      Grid copy(g);
+      swap(*this, copy);
+    }
+    return *this;
+  }
+
+  Grid &operator=(Grid &&g) noexcept {
+    swap(*this, g);
+    return *this;
+  }
+
+  ~Grid() noexcept { clear(); }
+
+  friend void swap(Grid &x, Grid &y) noexcept {
+    std::swap(x.ptr, y.ptr);
+    std::swap(x.gridsize, y.gridsize);
   }
 
   base &operator()(std::array<std::size_t, N> inds) noexcept {
@@ -69,17 +144,55 @@ class Grid {
     return ptr[index(std::array<std::size_t, N>{std::size_t(inds)...})];
   }
 
+  /** As operator(), but only checks the indices if NDEBUG is not defined
+   *
+   * Only for inner loops whose bounds are the sizes of the grid
+   */
+  base &unchecked(std::array<std::size_t, N> inds) noexcept {
+#ifndef NDEBUG
+    return ptr[index(inds)];
+#else
+    return ptr[offset(inds)];
+#endif
+  }
+
+  const base &unchecked(std::array<std::size_t, N> inds) const noexcept {
+#ifndef NDEBUG
+    return ptr[index(inds)];
+#else
+    return ptr[offset(inds)];
+#endif
+  }
+
+  template <typename... Inds>
+  base &unchecked(Inds... inds) noexcept {
+    return unchecked(std::array<std::size_t, N>{std::size_t(inds)...});
+  }
+
+  template <typename... Inds>
+  const base &unchecked(Inds... inds) const noexcept {
+    return unchecked(std::array<std::size_t, N>{std::size_t(inds)...});
+  }
+
   std::array<std::size_t, N> sizes() const { return gridsize; }
   std::size_t size(std::size_t pos) const { return gridsize[pos]; }
 
-  const base *data() const { return ptr.get(); }
+  /** Elements between neighbours along axis pos */
+  std::size_t stride(std::size_t pos) const noexcept {
+    std::size_t out = 1;
+    for (std::size_t i = pos + 1; i < N; i++) out *= gridsize[i];
+    return out;
+  }
+
+  const base *data() const { return ptr; }
 
-  base *data() { return ptr.get(); }
+  base *data() { return ptr; }
 
   template <typename... Inds>
   void resize(Inds... inds) {
-    ptr = std::make_unique<base[]>(mul(inds...));
+    clear();
     gridsize = {std::size_t(inds)...};
+    create([&](base *p) { std::uninitialized_value_construct_n(p, nelem()); });
   }
 
   auto begin() { return data(); }
@@ -107,18 +220,24 @@ class Grid {
   }
 
  private:
-  std::size_t index(std::array<std::size_t, N> ind) const noexcept {
+  std::size_t offset(std::array<std::size_t, N> ind) const noexcept {
     std::size_t posmul{gridsize.back()};
     std::size_t pos{ind.back()};
     for (std::size_t i{N - 2}; i < N; i--) {
       pos += posmul * ind[i];
       posmul *= gridsize[i];
+    }
+    return pos;
+  }
+
+  std::size_t index(std::array<std::size_t, N> ind) const noexcept {
+    for (std::size_t i = 0; i < N; i++) {
       if (ind[i] >= gridsize[i]) {
         std::cerr << "Out of range\n";
         std::terminate();
       }
     }
-    return pos;
+    return offset(ind);
   }
 };  // Grid
 
@@ -161,6 +280,18 @@ class Sub {
       return grid(ind, axispos);
   }
 
+  /** The first element, with the others at multiples of the strides from it */
+  auto *data() noexcept { return grid.data() + axispos * grid.stride(axis); }
+
+  const auto *data() const noexcept {
+    return grid.data() + axispos * grid.stride(axis);
+  }
+
+  /** Elements between neighbours along axis pos of the sub-grid */
+  std::size_t stride(std::size_t pos) const noexcept {
+    return grid.stride(pos + (pos >= axis));
+  }
+
   std::array<std::size_t, N> sizes() const {
     const std::array<std::size_t, N + 1> out_orig = grid.sizes();
     std::array<std::size_t, N> out;
@@ -1 +1,38 @@
 #include "gui.h"
+
+#include <thread>
+
+namespace GUI {
+void RenderPolicy::wait() {
+  using Clock = std::chrono::steady_clock;
+  using Seconds = std::chrono::duration<double>;
+
+  // Never draw faster than the maximum frame rate
+  if (max_fps > 0)
+    std::this_thread::sleep_until(
+        last + std::chrono::duration_cast<Clock::duration>(
+                   Seconds(1.0 / max_fps)));
+
+  if (busy > 0) {
+    busy--;
+    glfwPollEvents();
+  } else {
+    const auto deadline =
+        last + std::chrono::duration_cast<Clock::duration>(
+                   Seconds(min_refresh));
+    const Seconds timeout = deadline - Clock::now();
+    if (timeout.count() > 0) {
+      glfwWaitEventsTimeout(timeout.count());
+
+      // Woken up before the deadline by input or new data
+      if (Clock::now() < deadline) busy = extra_frames;
+    } else {
+      glfwPollEvents();
+    }
+  }
+
+  last = Clock::now();
+}
+
+void NotifyNewData() noexcept { glfwPostEmptyEvent(); }
+}  // namespace GUI
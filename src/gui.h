@@ -8,6 +8,7 @@
 #include <imgui_stdlib.h>
 #include <implot.h>
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -60,6 +61,42 @@ struct Config {
   }
 };  // Config
 
+/** Decides when the main loop draws its next frame
+ *
+ * Instead of drawing as fast as possible, the loop sleeps until there is
+ * input, new data is announced by NotifyNewData(), or min_refresh seconds
+ * have passed.  It never draws more than max_fps frames per second.  After
+ * input, a few extra frames are drawn since ImGui needs them to settle
+ */
+class RenderPolicy {
+  std::chrono::steady_clock::time_point last;
+  int busy;
+
+ public:
+  /** Most frames per second, no limit if not positive */
+  double max_fps;
+
+  /** Longest time in seconds between two frames */
+  double min_refresh;
+
+  /** Frames drawn without waiting after being woken up */
+  int extra_frames;
+
+  RenderPolicy(double fps = 60, double refresh = 0.5, int extra = 2) noexcept
+      : last(std::chrono::steady_clock::now()),
+        busy(0),
+        max_fps(fps),
+        min_refresh(refresh),
+        extra_frames(extra) {}
+
+  /** Waits for and polls the events of the next frame */
+  void wait();
+};  // RenderPolicy
+
+/** Wakes up the main loop, can be called from any thread after InitializeGUI
+ */
+void NotifyNewData() noexcept;
+
 inline void LayoutAndStyleSettings() {
   auto &style = ImGui::GetStyle();
   style.FramePadding = {0.0f, 0.0f};
@@ -17,13 +17,16 @@ inline static void glfw_error_callback(int error, const char *description) {
 }
 
 /** Begins an endless GUI loop (Opens a bracked)
+ *
+ * Waits for input, new data or a timeout before each frame
  *
  * Expects:
  *  window: A working glfw window
+ *  render_policy: A GUI::RenderPolicy
  */
 #define BeginWhileLoopGUI                  \
   while (!glfwWindowShouldClose(window)) { \
-    glfwPollEvents();                      \
+    render_policy.wait();                  \
                                            \
     ImGui_ImplOpenGL3_NewFrame();          \
     ImGui_ImplGlfw_NewFrame();             \
@@ -72,6 +75,7 @@ inline static void glfw_error_callback(int error, const char *description) {
  * Sets:
  *  window: A glfw window
  *  glsl_version: Version of GLSL
+ *  render_policy: When to draw frames, change its members before the loop
  */
 #define InitializeGUI(NAME)                                                \
   glfwSetErrorCallback(glfw_error_callback);                               \
@@ -92,7 +96,9 @@ inline static void glfw_error_callback(int error, const char *description) {
   ImGui::StyleColorsDark();                                                \
                                                                            \
   ImGui_ImplGlfw_InitForOpenGL(window, true);                              \
-  ImGui_ImplOpenGL3_Init(glsl_version)
+  ImGui_ImplOpenGL3_Init(glsl_version);                                    \
+                                                                           \
+  GUI::RenderPolicy render_policy
 
 /** Cleanup for the GUI
  *
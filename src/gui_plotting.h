@@ -5,9 +5,11 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 #include <mutex>
 #include <vector>
 
+#include "frequency_grid.h"
 #include "gui_windows.h"
 
 namespace GUI {
@@ -15,14 +17,17 @@ namespace Plotting {
 class Data {
   bool use_second;
   std::array<std::vector<double>, 2> data;
+  std::size_t gen;
   mutable std::mutex mtx;
 
  public:
-  Data(const std::vector<double> &d) : use_second(true), data({d, d}) {}
+  Data(const std::vector<double> &d)
+      : use_second(true), data({d, d}), gen(0) {}
   Data(size_t n)
       : use_second(true),
-        data({std::vector<double>(n, 0), std::vector<double>(n, 0)}) {}
-  Data(const Data &x) : use_second(true), data(x.data) {}
+        data({std::vector<double>(n, 0), std::vector<double>(n, 0)}),
+        gen(0) {}
+  Data(const Data &x) : use_second(true), data(x.data), gen(x.generation()) {}
 
   double get(size_t i) const {
     mtx.lock();
@@ -31,10 +36,18 @@ class Data {
     return x;
   }
 
+  /** Copies the current data to out, reusing its memory */
+  void get(std::vector<double> &out) const {
+    mtx.lock();
+    out.assign(data[use_second].cbegin(), data[use_second].cend());
+    mtx.unlock();
+  }
+
   void set(const std::vector<double> &newdata) {
     data[not use_second] = newdata;
     mtx.lock();
     use_second = not use_second;
+    gen++;
     mtx.unlock();
   }
 
@@ -44,6 +57,14 @@ class Data {
     mtx.unlock();
     return x;
   }
+
+  /** Changes every time the data is set */
+  size_t generation() const {
+    mtx.lock();
+    auto x = gen;
+    mtx.unlock();
+    return x;
+  }
 };  // Data
 
 /** LineGetter is a function pointer required by the plotting tool */
@@ -53,72 +74,61 @@ class Line {
   mutable std::mutex mtx;
 
   std::string mname;
-  Data xval;
+  FrequencyGrid::Ptr xval;
   Data yval;
   size_t running_avg;
   double xscale;
   double yscale;
   double xoffset;
   double yoffset;
+  size_t settings_gen;
 
-  double x(size_t i) const {
-    mtx.lock();
-    const double val = (xoffset + xval.get(i)) * xscale;
-    mtx.unlock();
-    return val;
-  }
-  double y(size_t i) const {
-    mtx.lock();
-    const double val = (yoffset + yval.get(i)) * yscale;
-    mtx.unlock();
-    return val;
-  }
+  // The plotted points, only recomputed when the generation changes
+  mutable size_t drawn_gen;
+  mutable std::vector<double> ybuf;
+  mutable std::vector<ImPlotPoint> points;
 
-  ImPlotPoint avg(size_t i) const {
-    ImPlotPoint out{0.0, 0.0};
-    size_t num{0};
+  void update() const {
+    const size_t gen = generation();
+    if (gen == drawn_gen) return;
 
-    mtx.lock();  // Access running_avg
-    bool test_loop = num < running_avg;
+    mtx.lock();
+    const size_t avg = std::max<size_t>(running_avg, 1);
+    const double xs = xscale, ys = yscale, xo = xoffset, yo = yoffset;
     mtx.unlock();
 
-    while (test_loop) {
-      mtx.lock();  // Access running_avg
-      const size_t j = running_avg * i + num;
-      mtx.unlock();
-
-      // Safety measures in case we are changing things
-      if (j < xval.N()) out.x += x(j);
-      if (j < yval.N()) out.y += y(j);
-
-      num++;
-      mtx.lock();  // Access running_avg
-      test_loop = num < running_avg;
-      mtx.unlock();
+    yval.get(ybuf);
+    points.resize(std::min(xval->size(), ybuf.size()) / avg);
+    for (size_t i = 0; i < points.size(); i++) {
+      ImPlotPoint p{0.0, 0.0};
+      for (size_t j = avg * i; j < avg * (i + 1); j++) {
+        p.x += (xo + (*xval)[j]) * xs;
+        p.y += (yo + ybuf[j]) * ys;
+      }
+      p.x /= avg;
+      p.y /= avg;
+      points[i] = p;
     }
-
-    mtx.lock();  // Access running_avg
-    out.x /= running_avg;
-    out.y /= running_avg;
-    mtx.unlock();
-    return out;
-  }
-
-  LineGetter avgfun() const {
-    return [](void *data, int i) { return static_cast<Line *>(data)->avg(i); };
+    drawn_gen = gen;
   }
 
  public:
-  Line(const std::string &name, const Data &X, const Data &Y)
+  /** A line over a frequency grid
+   *
+   * The grid is shared and immutable, only the y-values are owned by the line
+   */
+  Line(const std::string &name, FrequencyGrid::Ptr X, const Data &Y)
       : mname(name),
-        xval(X),
+        xval(std::move(X)),
         yval(Y),
         running_avg(1),
         xscale(1),
         yscale(1),
         xoffset(0),
-        yoffset(0) {
-    if (X.N() not_eq Y.N()) throw std::runtime_error("Bad data size");
+        yoffset(0),
+        settings_gen(0),
+        drawn_gen(std::numeric_limits<size_t>::max()) {
+    if (xval->size() not_eq Y.N()) throw std::runtime_error("Bad data size");
   }
   Line(const Line &other) noexcept
       : mname(other.mname),
@@ -128,36 +138,52 @@ class Line {
         xscale(other.xscale),
         yscale(other.yscale),
         xoffset(other.xoffset),
-        yoffset(other.yoffset) {}
+        yoffset(other.yoffset),
+        settings_gen(other.settings_gen),
+        drawn_gen(std::numeric_limits<size_t>::max()) {}
 
-  void setX(const std::vector<double> &x) { xval.set(x); }
   void setY(const std::vector<double> &y) { yval.set(y); }
   int size() const {
+    update();
+    return int(points.size());
+  }
+  LineGetter getter() const {
+    update();
+    return [](void *data, int i) {
+      return static_cast<Line *>(data)->points[i];
+    };
+  }
+
+  /** Changes whenever the data or how it is shown changes */
+  size_t generation() const {
     mtx.lock();
-    const int val = yval.N() / running_avg;
+    const size_t val = settings_gen;
     mtx.unlock();
-    return val;
+    return val + yval.generation();
   }
-  LineGetter getter() const { return avgfun(); }
   const std::string &name() const { return mname; }
   void Xscale(double x) {
     mtx.lock();
     xscale = x;
+    settings_gen++;
     mtx.unlock();
   }
   void Yscale(double x) {
     mtx.lock();
     yscale = x;
+    settings_gen++;
     mtx.unlock();
   }
   void Xoffset(double x) {
     mtx.lock();
     xoffset = x;
+    settings_gen++;
     mtx.unlock();
   }
   void Yoffset(double x) {
     mtx.lock();
     yoffset = x;
+    settings_gen++;
     mtx.unlock();
   }
   double Xscale() const {
@@ -187,6 +213,7 @@ class Line {
   void RunAvgCount(size_t n) {
     mtx.lock();
     running_avg = n;
+    settings_gen++;
     mtx.unlock();
   }
   size_t RunAvgCount() const {
@@ -235,7 +262,7 @@ class CAHA {
   static constexpr size_t M = PartOfHeight;
   static_assert(N >= M);
 
-  CAHA(std::string plotname, const std::vector<std::vector<double>> &f)
+  CAHA(std::string plotname, const std::vector<FrequencyGrid::Ptr> &f)
       : mname(plotname),
         raw("tmp", "tmp", "tmp", {}),
         noise("tmp", "tmp", "tmp", {}),
@@ -247,19 +274,20 @@ class CAHA {
     std::vector<Line> integrations;
     for (size_t i = 0; i < f.size(); i++) {
       raws.push_back(GUI::Plotting::Line(
-          std::string{"Cold "} + std::to_string(i), f[i], f[i].size()));
+          std::string{"Cold "} + std::to_string(i), f[i], f[i]->size()));
       raws.push_back(GUI::Plotting::Line(
-          std::string{"Target "} + std::to_string(i), f[i], f[i].size()));
+          std::string{"Target "} + std::to_string(i), f[i], f[i]->size()));
       raws.push_back(GUI::Plotting::Line(
-          std::string{"Hot "} + std::to_string(i), f[i], f[i].size()));
+          std::string{"Hot "} + std::to_string(i), f[i], f[i]->size()));
       noises.push_back(GUI::Plotting::Line(
-          std::string{"System Noise "} + std::to_string(i), f[i], f[i].size()));
+          std::string{"System Noise "} + std::to_string(i), f[i],
+          f[i]->size()));
       averagings.push_back(GUI::Plotting::Line(
           std::string{"Average Measurement "} + std::to_string(i), f[i],
-          f[i].size()));
+          f[i]->size()));
       integrations.push_back(GUI::Plotting::Line(
           std::string{"Last Measurement "} + std::to_string(i), f[i],
-          f[i].size()));
+          f[i]->size()));
     }
     raw = Frame("Raw", "Frequency", "Counts", raws);
     noise = Frame("Noise", "Frequency", "Temperature [K]", noises);
@@ -7,14 +7,18 @@
 #include <exception>
 #include <filesystem>
 #include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "archive.h"
 #include "backend.h"
 #include "chopper.h"
 #include "file.h"
+#include "frequency_grid.h"
 #include "gui.h"
 #include "timeclass.h"
 
@@ -35,8 +39,8 @@ struct Data {
   bool has_noise;
   bool has_calib_avg;
 
-  // Frequency grids of the instrument
-  std::vector<std::vector<double>> f;
+  // Frequency grids of the instrument, shared with the controller and plots
+  std::vector<FrequencyGrid::Ptr> f;
 
   // Last raw data of the instrument
   std::vector<std::vector<double>> last_target;
@@ -69,6 +73,13 @@ struct Data {
   size_t num_to_avg;        // Number to average
   size_t avg_count;         //  Count of current averages
 
+  static std::vector<std::vector<double>> zeros(
+      const std::vector<FrequencyGrid::Ptr> &grids) {
+    std::vector<std::vector<double>> out(grids.size());
+    for (size_t i = 0; i < grids.size(); i++) out[i].resize(grids[i]->size());
+    return out;
+  }
+
   Data() noexcept = default;
   Data(const Data &other) noexcept
       : target(other.target),
@@ -121,8 +132,7 @@ struct Data {
     return *this;
   }
 
-  template <typename T>
-  Data(const std::vector<std::vector<T>> &freq_grid) noexcept
+  Data(const std::vector<FrequencyGrid::Ptr> &freq_grid) noexcept
       : target(Chopper::ChopperPos::FINAL),
         has_target(false),
         has_cold(false),
@@ -130,38 +140,22 @@ struct Data {
         has_calib(false),
         has_noise(false),
         has_calib_avg(false),
-        f(freq_grid.size(), std::vector<double>(freq_grid[0].size())),
-        last_target(f),
-        last_cold(f),
-        last_hot(f),
-        last_calib(f),
-        last_noise(f),
-        avg_target(f),
-        avg_cold(f),
-        avg_hot(f),
-        avg_calib(f),
-        avg_noise(f),
+        f(freq_grid),
+        last_target(zeros(f)),
+        last_cold(last_target),
+        last_hot(last_target),
+        last_calib(last_target),
+        last_noise(last_target),
+        avg_target(last_target),
+        avg_cold(last_target),
+        avg_hot(last_target),
+        avg_calib(last_target),
+        avg_noise(last_target),
         tcold(std::numeric_limits<double>::max()),
         thot(std::numeric_limits<double>::max()),
         num_measurements(0),
         num_to_avg(std::numeric_limits<size_t>::max()),
-        avg_count(0) {
-    for (size_t i = 0; i < f.size(); i++) {
-      for (size_t j = 0; j < f[i].size(); j++) {
-        f[i][j] = freq_grid[i][j];
-        last_target[i][j] = 0;
-        last_cold[i][j] = 0;
-        last_hot[i][j] = 0;
-        last_calib[i][j] = 0;
-        last_noise[i][j] = 0;
-        avg_target[i][j] = 0;
-        avg_cold[i][j] = 0;
-        avg_hot[i][j] = 0;
-        avg_calib[i][j] = 0;
-        avg_noise[i][j] = 0;
-      }
-    }
-  }
+        avg_count(0) {}
 
   template <typename T>
   void update(Chopper::ChopperPos thistarget, double tc, double th,
@@ -303,6 +297,8 @@ class DataSaver {
   std::string timename;
   std::string filename;
   std::filesystem::path savedir;
+  size_t spectral_downsample;
+  std::unique_ptr<Archive::Writer> archive;
 
   std::string filename_composer() noexcept {
     return savedir.string() + basename + std::string{"."} + timename +
@@ -310,6 +306,15 @@ class DataSaver {
            std::string{".xml"};
   }
 
+  // The archive spans all days so it only changes with the path
+  std::filesystem::path archive_composer() noexcept {
+    updatepath.lock();
+    std::filesystem::path out{savedir.string() + basename +
+                              std::string{".archive"}};
+    updatepath.unlock();
+    return out;
+  }
+
   void update_time(bool newname = false) noexcept {
     Time now{};
     std::stringstream ss;
@@ -342,12 +347,21 @@ class DataSaver {
   }
 
  public:
-  DataSaver(const std::string &dir, const std::string &basefilename) noexcept
+  /** Saves the raw data and a columnar archive of it
+   *
+   * @param[in] dir The save directory
+   * @param[in] basefilename The start of all file names
+   * @param[in] downsample Number of spectral channels averaged into one
+   * archived channel, 0 means that the archive has no spectra
+   */
+  DataSaver(const std::string &dir, const std::string &basefilename,
+            size_t downsample = 0) noexcept
       : daily_copies(0),
         newfile(true),
         basename(basefilename),
         timename("not-a-time-starting-value"),
-        savedir(dir) {}
+        savedir(dir),
+        spectral_downsample(downsample) {}
 
   void updatePath(const std::filesystem::path &newdir) {
     updatepath.lock();
@@ -356,15 +370,46 @@ class DataSaver {
     update_time(true);
   }
 
+  /** Saves one measurement
+   *
+   * Errors of the files are reported and the measurement is not saved, so
+   * that they do not stop the acquisition
+   */
   template <size_t N>
   void save(const Chopper::ChopperPos &last,
             const std::map<std::string, double> &hk_data,
             const std::map<std::string, double> &frontend_data,
             const std::array<std::vector<std::vector<float>>, N> &backends_data,
-            const std::array<std::string, N> &backend_names) noexcept {
+            const std::array<std::string, N> &backend_names,
+            const std::array<std::vector<FrequencyGrid::Ptr>, N>
+                &backend_grids) noexcept {
+    try {
+      write(last, hk_data, frontend_data, backends_data, backend_names,
+            backend_grids);
+    } catch (const std::exception &e) {
+      std::cerr << Time() << " Cannot save data to " << filename << ":\n"
+                << e.what() << '\n';
+    }
+  }
+
+ private:
+  template <size_t N>
+  void write(
+      const Chopper::ChopperPos &last,
+      const std::map<std::string, double> &hk_data,
+      const std::map<std::string, double> &frontend_data,
+      const std::array<std::vector<std::vector<float>>, N> &backends_data,
+      const std::array<std::string, N> &backend_names,
+      const std::array<std::vector<FrequencyGrid::Ptr>, N> &backend_grids) {
+    const Time now{};
     update_time(not std::filesystem::exists(filename));
 
     if (newfile) {
+      const std::filesystem::path archive_path = archive_composer();
+      if (not archive or archive->path() not_eq archive_path)
+        archive = std::make_unique<Archive::Writer>(archive_path, 1024,
+                                                    spectral_downsample);
+
       File::File<File::Operation::Write, File::Type::Xml> metadatafile(
           filename);
 
@@ -412,6 +457,21 @@ class DataSaver {
         metadatafile.add_attribute("NumberOfBoards", backends_data[i].size());
         metadatafile.add_attribute("ChannelsPerBoard",
                                    backends_data[i][0].size());
+
+        // Uniform grids are fully described by their limits
+        std::vector<double> fstart, fend;
+        for (auto &grid : backend_grids[i]) {
+          const bool empty = grid->size() == 0;
+          fstart.push_back(empty ? 0 : (*grid)[0]);
+          fend.push_back(empty ? 0 : (*grid)[grid->size() - 1]);
+        }
+        metadatafile.add_attribute("FrequencyStart", fstart);
+        metadatafile.add_attribute("FrequencyEnd", fend);
+        for (size_t j = 0; j < backend_grids[i].size(); j++)
+          if (not backend_grids[i][j]->uniform())
+            metadatafile.add_attribute(
+                std::string{"Frequency"} + std::to_string(j),
+                backend_grids[i][j]->values());
         metadatafile.leave_child();
       }
       metadatafile.leave_child();
@@ -424,11 +484,13 @@ class DataSaver {
     File::File<File::Operation::AppendBinary, File::Type::Xml> datafile(
         filename);
     size_t n = 0;
-    n += datafile.write(Time());
+    n += datafile.write(now);
     n += datafile.write(int(last));
     for (auto &hk : hk_data) n += datafile.write(hk.second);
     for (auto &fe : frontend_data) n += datafile.write(fe.second);
     for (auto &specdata : backends_data) n += datafile.write(specdata);
+
+    archive->save(now, hk_data, frontend_data, backends_data, backend_names);
   }
 };
 
@@ -744,6 +806,49 @@ void AllInformation(Chopper &chop, ChopperController &chopper_ctrl,
   }
 }
 
+/** Stores the last measurements of all devices in their controllers
+ *
+ * This is the hand-over from the device loop to ExchangeData, which is told
+ * that there is new data once everything is stored
+ */
+template <typename ChopperController, typename Housekeeping,
+          typename HousekeepingController, typename Frontend,
+          typename FrontendController, typename Backends,
+          typename BackendControllers>
+void StoreAll(ChopperController &chopper_ctrl, Chopper::ChopperPos last,
+              Housekeeping &hk, HousekeepingController &housekeeping_ctrl,
+              Frontend &frontend, FrontendController &frontend_ctrl,
+              Backends &backends, BackendControllers &backend_ctrls) noexcept {
+  std::cout << Time() << " Store Chopper\n";
+  chopper_ctrl.lasttarget = last;
+  for (size_t i = 0; i < backends.N; i++) {
+    std::cout << Time() << " Store Backend " << i + 1 << "\n";
+    backend_ctrls[i].d = backends.datavec(i);
+  }
+  std::cout << Time() << " Store Housekeeping\n";
+  housekeeping_ctrl.data = hk.data();
+  std::cout << Time() << " Store Frontend\n";
+  frontend_ctrl.data = frontend.data();
+
+  // If the front end contains the hot load or cold load, load those over to
+  // Housekeeping
+  if constexpr (Frontend::has_cold_load) {
+    std::cout << Time() << " Copy Frontend Cold Load\n";
+    housekeeping_ctrl.data["Cold Load Temperature"] = frontend.cold_load();
+  }
+  if constexpr (Frontend::has_hot_load) {
+    std::cout << Time() << " Copy Frontend Hot Load\n";
+    housekeeping_ctrl.data["Hot Load Temperature"] = frontend.hot_load();
+  }
+
+  // Tell the storing device that there is new data
+  std::cout << Time() << " Set all to done\n";
+  for (auto &x : backend_ctrls) x.newdata.store(true);
+  chopper_ctrl.newdata.store(true);
+  housekeeping_ctrl.newdata.store(true);
+  frontend_ctrl.newdata.store(true);
+}
+
 template <typename Chopper, typename ChopperController, typename Wobbler,
           typename WobblerController, typename Housekeeping,
           typename HousekeepingController, typename Frontend,
@@ -859,34 +964,8 @@ loop:
   }
 
   // Store the measurements in the controller
-  std::cout << Time() << " Store Chopper\n";
-  chopper_ctrl.lasttarget = chopper_ctrl.pos[pos];
-  for (size_t i = 0; i < backends.N; i++) {
-    std::cout << Time() << " Store Backend " << i + 1 << "\n";
-    backend_ctrls[i].d = backends.datavec(i);
-  }
-  std::cout << Time() << " Store Housekeeping\n";
-  housekeeping_ctrl.data = hk.data();
-  std::cout << Time() << " Store Frontend\n";
-  frontend_ctrl.data = frontend.data();
-
-  // If the front end contains the hot load or cold load, load those over to
-  // Housekeeping
-  if constexpr (frontend.has_cold_load) {
-    std::cout << Time() << " Copy Frontend Cold Load\n";
-    housekeeping_ctrl.data["Cold Load Temperature"] = frontend.cold_load();
-  }
-  if constexpr (frontend.has_hot_load) {
-    std::cout << Time() << " Copy Frontend Hot Load\n";
-    housekeeping_ctrl.data["Hot Load Temperature"] = frontend.hot_load();
-  }
-
-  // Tell the storing device that there is new data
-  std::cout << Time() << " Set all to done\n";
-  for (auto &x : backend_ctrls) x.newdata.store(true);
-  chopper_ctrl.newdata.store(true);
-  housekeeping_ctrl.newdata.store(true);
-  frontend_ctrl.newdata.store(true);
+  StoreAll(chopper_ctrl, chopper_ctrl.pos[pos], hk, housekeeping_ctrl,
+           frontend, frontend_ctrl, backends, backend_ctrls);
 
   // Finally just wait for the wobbler to be happy
   std::cout << Time() << " Wait for Wobbler\n";
@@ -936,48 +1015,48 @@ stop:
   return errors;
 }
 
-template <size_t N, typename ChopperController, typename HousekeepingController,
-          typename FrontendController, size_t CAHA_N, size_t CAHA_M>
-void ExchangeData(
-    std::array<Spectrometer::Controller, N> &backend_ctrls,
-    ChopperController &chopper_ctrl, HousekeepingController &housekeeping_ctrl,
-    FrontendController &frontend_ctrl, std::array<Data, N> &data,
-    DataSaver &saver,
-    std::array<GUI::Plotting::CAHA<CAHA_N, CAHA_M>, N> &rawplots) noexcept {
-  bool allnew = false;
-  bool quit = false;
-  Chopper::ChopperPos last;
+/** The data ExchangeData moves from the controllers to the saver and plots
+ *
+ * Kept between exchanges so that the copies can reuse their memory
+ */
+template <size_t N>
+struct ExchangeBuffer {
   std::map<std::string, double> hk_data;
   std::map<std::string, double> frontend_data;
   std::array<std::vector<std::vector<float>>, N> backends_data;
   std::array<std::string, N> backend_names;
+  std::array<std::vector<FrequencyGrid::Ptr>, N> backend_grids;
+};
 
+/** Prepares the processed data and the exchange buffer for the backends */
+template <size_t N>
+ExchangeBuffer<N> InitExchange(
+    std::array<Spectrometer::Controller, N> &backend_ctrls,
+    std::array<Data, N> &data) noexcept {
+  ExchangeBuffer<N> buf;
   for (size_t i = 0; i < N; i++) {
-    backend_names[i] = backend_ctrls[i].name;
+    buf.backend_names[i] = backend_ctrls[i].name;
+    buf.backend_grids[i] = backend_ctrls[i].f;
     data[i] = Data(backend_ctrls[i].f);
     data[i].newdata.store(false);
   }
+  return buf;
+}
 
-  if (rawplots.size() not_eq N) std::terminate();
-
-wait:
-  Sleep(0.1);
-
-loop:
-  allnew = housekeeping_ctrl.newdata.load() and frontend_ctrl.newdata.load() and
-           std::all_of(backend_ctrls.cbegin(), backend_ctrls.cend(),
-                       [](auto &x) { return x.newdata.load(); });
-  quit = housekeeping_ctrl.quit.load() and frontend_ctrl.quit.load() and
-         std::all_of(backend_ctrls.cbegin(), backend_ctrls.cend(),
-                     [](auto &x) { return x.quit.load(); });
-
-  if (quit) goto stop;
-  if (not allnew) goto wait;
-
-  last = chopper_ctrl.lasttarget;
-  hk_data = housekeeping_ctrl.data;
-  frontend_data = frontend_ctrl.data;
-  for (size_t i = 0; i < N; i++) backends_data[i] = backend_ctrls[i].d;
+/** Takes the new data of the controllers, saves it and updates the plots */
+template <size_t N, typename ChopperController, typename HousekeepingController,
+          typename FrontendController, size_t CAHA_N, size_t CAHA_M>
+void ExchangeOnce(
+    std::array<Spectrometer::Controller, N> &backend_ctrls,
+    ChopperController &chopper_ctrl, HousekeepingController &housekeeping_ctrl,
+    FrontendController &frontend_ctrl, std::array<Data, N> &data,
+    DataSaver &saver,
+    std::array<GUI::Plotting::CAHA<CAHA_N, CAHA_M>, N> &rawplots,
+    ExchangeBuffer<N> &buf) noexcept {
+  const Chopper::ChopperPos last = chopper_ctrl.lasttarget;
+  buf.hk_data = housekeeping_ctrl.data;
+  buf.frontend_data = frontend_ctrl.data;
+  for (size_t i = 0; i < N; i++) buf.backends_data[i] = backend_ctrls[i].d;
 
   chopper_ctrl.newdata.store(false);
   housekeeping_ctrl.newdata.store(false);
@@ -985,12 +1064,13 @@ loop:
   for (auto &ctrl : backend_ctrls) ctrl.newdata.store(false);
 
   // Save the raw data to file
-  saver.save(last, hk_data, frontend_data, backends_data, backend_names);
+  saver.save(last, buf.hk_data, buf.frontend_data, buf.backends_data,
+             buf.backend_names, buf.backend_grids);
 
   // Update plotting tools data
   for (size_t i = 0; i < N; i++) {
-    data[i].update(last, hk_data["Cold Load Temperature"],
-                   hk_data["Hot Load Temperature"], backends_data[i]);
+    data[i].update(last, buf.hk_data["Cold Load Temperature"],
+                   buf.hk_data["Hot Load Temperature"], buf.backends_data[i]);
 
     // Fill rawplots
     for (size_t j = 0; j < data[i].f.size(); j++) {
@@ -1007,6 +1087,39 @@ loop:
         rawplots[i].Averaging()[j].setY(data[i].avg_calib[j]);
     }
   }
+}
+
+template <size_t N, typename ChopperController, typename HousekeepingController,
+          typename FrontendController, size_t CAHA_N, size_t CAHA_M>
+void ExchangeData(
+    std::array<Spectrometer::Controller, N> &backend_ctrls,
+    ChopperController &chopper_ctrl, HousekeepingController &housekeeping_ctrl,
+    FrontendController &frontend_ctrl, std::array<Data, N> &data,
+    DataSaver &saver,
+    std::array<GUI::Plotting::CAHA<CAHA_N, CAHA_M>, N> &rawplots) noexcept {
+  bool allnew = false;
+  bool quit = false;
+  ExchangeBuffer<N> buf = InitExchange(backend_ctrls, data);
+
+  if (rawplots.size() not_eq N) std::terminate();
+
+wait:
+  Sleep(0.1);
+
+loop:
+  allnew = housekeeping_ctrl.newdata.load() and frontend_ctrl.newdata.load() and
+           std::all_of(backend_ctrls.cbegin(), backend_ctrls.cend(),
+                       [](auto &x) { return x.newdata.load(); });
+  quit = housekeeping_ctrl.quit.load() and frontend_ctrl.quit.load() and
+         std::all_of(backend_ctrls.cbegin(), backend_ctrls.cend(),
+                     [](auto &x) { return x.quit.load(); });
+
+  if (quit) goto stop;
+  if (not allnew) goto wait;
+
+  ExchangeOnce(backend_ctrls, chopper_ctrl, housekeeping_ctrl, frontend_ctrl,
+               data, saver, rawplots, buf);
+  GUI::NotifyNewData();
 
   goto loop;
 stop : {}
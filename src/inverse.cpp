@@ -179,7 +179,7 @@ Eigen::VectorXd map_input_to_x(const Atmosphere::Atm& atm,
 
 #define SHAPEVALSETTER(VAR)                                         \
   Derivative::Line::Shape##VAR##X0 : for (auto& band : bands) {     \
-    for (auto& line : band.Lines()) {                               \
+    for (auto& line : band.EditLines()) {                           \
       if (line.ID() == d.LineID()) {                                \
         for (size_t i = 0; i < line.ShapeModel().n_spec(); i++) {   \
           if (line.ShapeModel()[i].s == d.Species()) {              \
@@ -194,7 +194,7 @@ Eigen::VectorXd map_input_to_x(const Atmosphere::Atm& atm,
   break;                                                            \
   case Derivative::Line::Shape##VAR##X1:                            \
     for (auto& band : bands) {                                      \
-      for (auto& line : band.Lines()) {                             \
+      for (auto& line : band.EditLines()) {                         \
         if (line.ID() == d.LineID()) {                              \
           for (size_t i = 0; i < line.ShapeModel().n_spec(); i++) { \
             if (line.ShapeModel()[i].s == d.Species()) {            \
@@ -209,7 +209,7 @@ Eigen::VectorXd map_input_to_x(const Atmosphere::Atm& atm,
     break;                                                          \
   case Derivative::Line::Shape##VAR##X2:                            \
     for (auto& band : bands) {                                      \
-      for (auto& line : band.Lines()) {                             \
+      for (auto& line : band.EditLines()) {                         \
         if (line.ID() == d.LineID()) {                              \
           for (size_t i = 0; i < line.ShapeModel().n_spec(); i++) { \
             if (line.ShapeModel()[i].s == d.Species()) {            \
@@ -224,7 +224,7 @@ Eigen::VectorXd map_input_to_x(const Atmosphere::Atm& atm,
     break;                                                          \
   case Derivative::Line::Shape##VAR##X3:                            \
     for (auto& band : bands) {                                      \
-      for (auto& line : band.Lines()) {                             \
+      for (auto& line : band.EditLines()) {                         \
         if (line.ID() == d.LineID()) {                              \
           for (size_t i = 0; i < line.ShapeModel().n_spec(); i++) { \
             if (line.ShapeModel()[i].s == d.Species()) {            \
@@ -279,7 +279,7 @@ void set_input_from_x(Atmosphere::Atm& atm,
       switch (d.LineType()) {
         case Derivative::Line::Strength:
           for (auto& band : bands) {
-            for (auto& line : band.Lines()) {
+            for (auto& line : band.EditLines()) {
               if (line.ID() == d.LineID()) {
                 line.I0(x[i]);
                 i++;
@@ -290,7 +290,7 @@ void set_input_from_x(Atmosphere::Atm& atm,
           break;
         case Derivative::Line::Center:
           for (auto& band : bands) {
-            for (auto& line : band.Lines()) {
+            for (auto& line : band.EditLines()) {
               if (line.ID() == d.LineID()) {
                 line.F0(x[i]);
                 i++;
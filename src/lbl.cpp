@@ -1,40 +1,147 @@
 #include "lbl.h"
 
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+
 #include "hitran.h"
+#include "multithread.h"
 
 namespace Absorption {
-std::vector<Band> parse_hitran_with_qns(
-    File::File<File::Operation::Read, File::Type::Raw> &hitranfile,
-    Frequency<FrequencyType::Freq> flow,
-    Frequency<FrequencyType::Freq> fupp) noexcept {
-  std::vector<Band> database;
+void LineArrays::set(const std::vector<Line> &lines) {
+  const std::size_t n = lines.size();
+  f0.resize(n);
+  i0.resize(n);
+  e0.resize(n);
+  gl.resize(n);
+  gu.resize(n);
+  a.resize(n);
+  id.resize(n);
+  shape_offset.resize(n + 1);
+  shape.clear();
+
+  shape_offset[0] = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    f0[i] = lines[i].F0();
+    i0[i] = lines[i].I0();
+    e0[i] = lines[i].E0();
+    gl[i] = lines[i].Gl();
+    gu[i] = lines[i].Gu();
+    a[i] = lines[i].A();
+    id[i] = lines[i].ID();
+    shape.insert(shape.end(), lines[i].ShapeModel().begin(),
+                 lines[i].ShapeModel().end());
+    shape_offset[i + 1] = shape.size();
+  }
+}
 
-  // Get the HITRAN data
-  std::vector<std::vector<HITRAN::IsotopologueData>> hitrandata{
-      int(Species::Species::FINAL)};
-  for (long i = 0; i < long(Species::Species::FINAL); i++) {
-    hitrandata[i] = HITRAN::getIsotopologueData(i);
+void ZeemanArrays::set(const std::vector<Line> &lines, Species::Isotope spec,
+                       bool zeeman) {
+  const std::size_t n = lines.size();
+  for (auto p : {Polarization::SigmaMinus, Polarization::Pi,
+                 Polarization::SigmaPlus, Polarization::None}) {
+    auto &off = offset[std::size_t(p)];
+    auto &str = strength[std::size_t(p)];
+    auto &spl = splitting[std::size_t(p)];
+    off.clear();
+    str.clear();
+    spl.clear();
+    if (zeeman == (p == Polarization::None)) continue;
+
+    off.resize(n + 1);
+    off[0] = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      const auto range = lines[i].ZeemanRange(p, spec);
+      for (int iz = range.first; iz <= range.second; iz++) {
+        str.push_back(lines[i].ZeemanStrength(p, spec, iz));
+        spl.push_back(lines[i].ZeemanSplitting(p, spec, iz));
+      }
+      off[i + 1] = str.size();
+    }
   }
+}
 
-  while (not hitranfile.at_end()) {
-    std::string line = hitranfile.getline();
+namespace {
+/** Least bytes of a HITRAN catalog parsed by one task */
+constexpr std::size_t hitran_chunk = std::size_t(1) << 20;
+
+/** What makes the bands of a HITRAN catalog different */
+struct HitranBandKey {
+  Species::Isotope spec;
+  std::vector<Quantum::Number> gl;
+  std::vector<Quantum::Number> gu;
+
+  bool operator==(const HitranBandKey &k) const noexcept {
+    return spec == k.spec and gl == k.gl and gu == k.gu;
+  }
+};
+
+struct HitranBandHash {
+  std::size_t operator()(const HitranBandKey &k) const noexcept {
+    std::size_t h = k.spec.index();
+    auto mix = [&h](const Quantum::Number &n) {
+      // Text numbers all hash alike, operator== tells them apart
+      const Rational r = n.rat();
+      const double x = r.d() ? double(r.n()) / double(r.d()) : double(r.n());
+      h ^= std::hash<double>{}(x) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    };
+    for (auto &n : k.gl) mix(n);
+    for (auto &n : k.gu) mix(n);
+    return h;
+  }
+};
+
+/** The bands of the lines of (a part of) a HITRAN catalog, in the order
+ * their first lines appear */
+class HitranBands {
+  const std::vector<std::vector<HITRAN::IsotopologueData>> &hitrandata;
+  std::vector<Band> bands;
+  std::vector<HitranBandKey> keys;
+  std::unordered_map<HitranBandKey, std::size_t, HitranBandHash> index;
+
+  Band &find(const HitranBandKey &key) {
+    auto [pos, added] = index.try_emplace(key, bands.size());
+    if (added) {
+      bands.push_back(Band{key.spec, Mirroring::None, Normalization::None,
+                           Population::ByLTE, Cutoff::None, Shape::VP, false,
+                           296, -1, key.gl, key.gu});
+      keys.push_back(key);
+    }
+    return bands[pos->second];
+  }
+
+ public:
+  HitranBands(
+      const std::vector<std::vector<HITRAN::IsotopologueData>> &data) noexcept
+      : hitrandata(data) {}
+
+  /** Adds the line of a record to its band if it is inside [flow, fupp]
+   *
+   * @return false if the line is above fupp
+   */
+  bool add(const std::string &line, Frequency<FrequencyType::Freq> flow,
+           Frequency<FrequencyType::Freq> fupp) {
     auto hitpar = HITRAN::parse_parform(line, 0);
-    if (hitpar.v < flow) continue;
-    if (hitpar.v > fupp) break;
+    if (hitpar.v < flow) return true;
+    if (hitpar.v > fupp) return false;
 
     auto quantums = HITRAN::parse_quantum(line, 161);
     auto s = Species::Isotope{
         Species::Isotope(hitrandata[hitpar.M][hitpar.I - 1].spec,
                          hitrandata[hitpar.M][hitpar.I - 1].isotpos)};
-    std::vector<Quantum::Number> gu{s.globalQuantumNumberCount()};
-    std::vector<Quantum::Number> gl{s.globalQuantumNumberCount()};
+    HitranBandKey key{s,
+                      std::vector<Quantum::Number>(
+                          s.globalQuantumNumberCount()),
+                      std::vector<Quantum::Number>(
+                          s.globalQuantumNumberCount())};
     std::vector<Quantum::Number> lu{s.localQuantumNumberCount()};
     std::vector<Quantum::Number> ll{s.localQuantumNumberCount()};
 
     for (size_t i = 0; i < quantums[0].size(); i++) {
-      s.set_global(gu, quantums[0][i],
+      s.set_global(key.gu, quantums[0][i],
                    HITRAN::toQuantumType(HITRAN::QuantumTypes(i)));
-      s.set_global(gl, quantums[1][i],
+      s.set_global(key.gl, quantums[1][i],
                    HITRAN::toQuantumType(HITRAN::QuantumTypes(i)));
       s.set_local(lu, quantums[0][i],
                   HITRAN::toQuantumType(HITRAN::QuantumTypes(i)));
@@ -42,23 +149,6 @@ std::vector<Band> parse_hitran_with_qns(
                   HITRAN::toQuantumType(HITRAN::QuantumTypes(i)));
     }
 
-    Band b{s,
-           Mirroring::None,
-           Normalization::None,
-           Population::ByLTE,
-           Cutoff::None,
-           Shape::VP,
-           false,
-           296,
-           -1,
-           gl,
-           gu};
-    auto band = std::find(database.begin(), database.end(), b);
-    if (band == database.end()) {
-      database.push_back(b);
-      band = database.end() - 1;
-    }
-
     Line l{s,
            hitpar.v,
            hitpar.S,
@@ -72,9 +162,91 @@ std::vector<Band> parse_hitran_with_qns(
            LineShape::Model{s.Spec(), hitpar.gamma_air, hitpar.gamma_self,
                             hitpar.delta_air, hitpar.n_air}};
 
-    band->appendLine(l);
+    find(key).appendLine(l);
+    return true;
+  }
+
+  /** Adds the bands of x, which come after these in the catalog */
+  void merge(HitranBands &&x) {
+    for (std::size_t i = 0; i < x.bands.size(); i++) {
+      auto &band = find(x.keys[i]);
+      for (auto &line : x.bands[i].EditLines())
+        band.appendLine(std::move(line));
+    }
   }
-  return database;
+
+  std::vector<Band> release() && { return std::move(bands); }
+};
+
+/** Isotopologue data of all HITRAN molecule numbers, made once */
+const std::vector<std::vector<HITRAN::IsotopologueData>> &hitran_data() {
+  static const std::vector<std::vector<HITRAN::IsotopologueData>> out = [] {
+    std::vector<std::vector<HITRAN::IsotopologueData>> data{
+        int(Species::Species::FINAL)};
+    for (long i = 0; i < long(Species::Species::FINAL); i++) {
+      data[i] = HITRAN::getIsotopologueData(i);
+    }
+    return data;
+  }();
+  return out;
+}
+}  // namespace
+
+std::vector<Band> parse_hitran_with_qns(
+    File::File<File::Operation::Read, File::Type::Raw> &hitranfile,
+    Frequency<FrequencyType::Freq> flow,
+    Frequency<FrequencyType::Freq> fupp) noexcept {
+  const auto &hitrandata = hitran_data();
+  HitranBands database(hitrandata);
+
+  while (not hitranfile.at_end()) {
+    std::string line = hitranfile.getline();
+    if (line.empty()) continue;
+    if (not database.add(line, flow, fupp)) break;
+  }
+  return std::move(database).release();
+}
+
+std::vector<Band> parse_hitran_with_qns(const std::string &path,
+                                        Frequency<FrequencyType::Freq> flow,
+                                        Frequency<FrequencyType::Freq> fupp) {
+  const File::Mapped file(path, File::Access::Sequential);
+  const char *const begin = file.data();
+  const char *const end = begin + file.size();
+
+  // Chunks of whole records, starting after the end of a line
+  std::vector<const char *> bounds{begin};
+  const std::size_t nchunks = std::max<std::size_t>(
+      1, std::min(file.size() / hitran_chunk,
+                  std::size_t(4 * Multithread::Concurrency(
+                                      Multithread::Arena::Compute))));
+  for (std::size_t i = 1; i < nchunks; i++) {
+    const char *pos = begin + i * file.size() / nchunks;
+    pos = std::find(std::max(pos, bounds.back()), end, '\n');
+    bounds.push_back(pos == end ? end : pos + 1);
+  }
+  bounds.push_back(end);
+
+  const auto &hitrandata = hitran_data();
+  std::vector<HitranBands> parts(nchunks, HitranBands(hitrandata));
+  Multithread::parallel_for(Multithread::Arena::Compute, 0, nchunks,
+                            [&](std::size_t i) {
+                              std::string line;
+                              for (const char *pos = bounds[i];
+                                   pos < bounds[i + 1];) {
+                                const char *eol =
+                                    std::find(pos, bounds[i + 1], '\n');
+                                line.assign(pos, eol);
+                                if (not line.empty())
+                                  parts[i].add(line, flow, fupp);
+                                pos = eol + 1;
+                              }
+                            })
+      .get();
+
+  for (std::size_t i = 1; i < nchunks; i++)
+    parts.front().merge(std::move(parts[i]));
+  return std::move(parts.front()).release();
 }
 
 void saveBand(File::File<File::Operation::Write, File::Type::Xml> &file,
@@ -193,6 +365,7 @@ void readBand(File::File<File::Operation::Read, File::Type::Xml> &file,
   std::stringstream is{c.text().as_string()};
   band.lines =
       std::vector<Line>(file.get_attribute("N").as_ullong(), {band.spec});
+  band.generation++;
   for (auto &line : band.lines) {
     line.lineshape = model;
     is >> line.f0 >> line.i0 >> line.e0 >> line.zeeman >> line.gl >> line.gu >>
@@ -311,6 +484,7 @@ void readBand(File::File<File::Operation::ReadBinary, File::Type::Xml> &file,
 
   band.lines =
       std::vector<Line>(file.get_attribute("N").as_ullong(), {band.spec});
+  band.generation++;
   for (Line &line : band.lines) {
     file.read(line.f0);
     file.read(line.i0);
@@ -331,4 +505,493 @@ void readBand(File::File<File::Operation::ReadBinary, File::Type::Xml> &file,
   }
   file.leave_child();
 }
+
+namespace {
+constexpr std::array<char, 8> catalog_magic{'R', 'C', 'L', 'B',
+                                            'L', 'C', 'A', 'T'};
+
+/** Changes whenever the layout of a catalog changes */
+constexpr std::uint64_t catalog_version = 2;
+
+struct CatalogHeader {
+  std::array<char, 8> magic;
+  std::uint64_t version;
+  std::uint64_t nbands;
+  std::uint64_t nlines;
+};
+
+struct CatalogBand {
+  double fmin;
+  double fmax;
+  std::uint64_t nlines;
+  std::uint64_t offset;  // From the start of the file
+};
+
+static_assert(sizeof(CatalogHeader) == 32 and sizeof(CatalogBand) == 32 and
+                  sizeof(CatalogLine) == 24,
+              "The records of a catalog are written as they are in memory");
+
+/** The values of a band that come before the arrays of its lines */
+struct CatalogBandInfo {
+  Species::Isotope spec;
+  Mirroring mirroring;
+  Normalization normalization;
+  Population population;
+  Cutoff cutoff;
+  Shape shape;
+  bool do_zeeman;
+  double t0;
+  double fcut;
+  std::uint64_t nglobal;
+  std::uint64_t nlocal;
+  std::uint64_t nshape;  // Broadening species per line
+};
+
+/** Integers of a Quantum::Number, whether it is text and its rational, and
+ * its characters */
+constexpr std::size_t number_ints = 3;
+constexpr std::size_t number_chars = Quantum::Number().chars().size();
+
+/** Integers of a LineShape::AllSingleParameters, the species and the
+ * temperature and pressure models of each parameter, and its doubles, X0 to
+ * X3 of each parameter */
+constexpr std::size_t nparams = std::size_t(LineShape::Parameter::FINAL);
+constexpr std::size_t shape_ints = 1 + 2 * nparams;
+constexpr std::size_t shape_doubles = 4 * nparams;
+
+/** Every section of a catalog starts at a multiple of this */
+constexpr std::size_t catalog_align = 8;
+
+constexpr std::size_t padded(std::size_t n) noexcept {
+  return (n + catalog_align - 1) / catalog_align * catalog_align;
+}
+
+template <typename T>
+void put(std::string &buf, const T *x, std::size_t n) {
+  static_assert(std::is_arithmetic_v<T> and alignof(T) <= catalog_align);
+  buf.append(reinterpret_cast<const char *>(x), n * sizeof(T));
+  buf.resize(padded(buf.size()));
+}
+
+/** The n values at pos and moves pos past them */
+template <typename T>
+const char *section(const char *&pos, std::size_t n) noexcept {
+  static_assert(std::is_arithmetic_v<T> and alignof(T) <= catalog_align);
+  const char *out = pos;
+  pos += padded(n * sizeof(T));
+  return out;
+}
+
+/** Value k of a section */
+template <typename T>
+T at(const char *x, std::size_t k) noexcept {
+  T out;
+  std::memcpy(&out, x + k * sizeof(T), sizeof(T));
+  return out;
+}
+
+/** Integers and doubles of a CatalogBandInfo, and the bytes of them */
+constexpr std::size_t info_ints = 11;
+constexpr std::size_t info_doubles = 2;
+constexpr std::size_t info_size =
+    padded(info_ints * sizeof(std::int64_t)) +
+    padded(info_doubles * sizeof(double));
+
+/** Bytes of the sections of n quantum numbers */
+constexpr std::size_t numbers_size(std::size_t n) noexcept {
+  return padded(n * number_ints * sizeof(std::int64_t)) +
+         padded(n * number_chars);
+}
+
+std::size_t payload_size(const CatalogBandInfo &info, std::size_t n) noexcept {
+  return info_size + 2 * numbers_size(info.nglobal) +
+         8 * padded(n * sizeof(double)) +
+         padded(n * info.nshape * shape_ints * sizeof(std::int64_t)) +
+         padded(n * info.nshape * shape_doubles * sizeof(double)) +
+         2 * numbers_size(n * info.nlocal);
+}
+
+const CatalogBand &catalog_band(const File::Mapped &map,
+                                std::size_t i) noexcept {
+  return reinterpret_cast<const CatalogBand *>(map.data() +
+                                               sizeof(CatalogHeader))[i];
+}
+
+/** Value x of a catalog as an E, throws if it is not one */
+template <typename E>
+E catalog_value(std::int64_t x, const char *name) {
+  if (x < 0 or x >= std::int64_t(E::FINAL)) {
+    std::ostringstream os;
+    os << "Line catalog has " << x << " as " << name << ", which is not one";
+    throw std::runtime_error(os.str());
+  }
+  return E(x);
+}
+
+void put_info(std::string &buf, const CatalogBandInfo &info) {
+  const std::array<std::int64_t, info_ints> ints{
+      std::int64_t(info.spec.Spec()),   std::int64_t(info.spec.Num()),
+      std::int64_t(info.mirroring),     std::int64_t(info.normalization),
+      std::int64_t(info.population),    std::int64_t(info.cutoff),
+      std::int64_t(info.shape),         std::int64_t(info.do_zeeman),
+      std::int64_t(info.nglobal),       std::int64_t(info.nlocal),
+      std::int64_t(info.nshape)};
+  const std::array<double, info_doubles> doubles{info.t0, info.fcut};
+  put(buf, ints.data(), ints.size());
+  put(buf, doubles.data(), doubles.size());
+}
+
+/** The CatalogBandInfo at pos, moving pos past it, throws if a value of it
+ * is out of range */
+CatalogBandInfo read_info(const char *&pos) {
+  const char *ints = section<std::int64_t>(pos, info_ints);
+  const char *doubles = section<double>(pos, info_doubles);
+  auto i = [ints](std::size_t k) { return at<std::int64_t>(ints, k); };
+  if (i(1) < 0 or i(1) > std::numeric_limits<unsigned char>::max() or
+      i(7) < 0 or i(7) > 1 or i(8) < 0 or i(9) < 0 or i(10) < 0) {
+    std::ostringstream os;
+    os << "Line catalog has an isotope number " << i(1) << ", Zeeman flag "
+       << i(7) << " or quantum number and broadening counts " << i(8) << ", "
+       << i(9) << " and " << i(10) << " out of range";
+    throw std::runtime_error(os.str());
+  }
+  return {Species::Isotope(catalog_value<Species::Species>(i(0), "species"),
+                           static_cast<unsigned char>(i(1))),
+          catalog_value<Mirroring>(i(2), "mirroring"),
+          catalog_value<Normalization>(i(3), "normalization"),
+          catalog_value<Population>(i(4), "population"),
+          catalog_value<Cutoff>(i(5), "cutoff"),
+          catalog_value<Shape>(i(6), "line shape"),
+          i(7) == 1,
+          at<double>(doubles, 0),
+          at<double>(doubles, 1),
+          std::uint64_t(i(8)),
+          std::uint64_t(i(9)),
+          std::uint64_t(i(10))};
+}
+
+void put_numbers(std::string &buf, const std::vector<Quantum::Number> &qn) {
+  std::vector<std::int64_t> ints;
+  std::vector<char> chars;
+  ints.reserve(qn.size() * number_ints);
+  chars.reserve(qn.size() * number_chars);
+  for (auto &q : qn) {
+    ints.push_back(q.isText());
+    ints.push_back(q.rat().n());
+    ints.push_back(q.rat().d());
+    for (char c : q.chars()) chars.push_back(c);
+  }
+  put(buf, ints.data(), ints.size());
+  put(buf, chars.data(), chars.size());
+}
+
+/** Sections of n quantum numbers at pos, moving pos past them */
+std::pair<const char *, const char *> number_sections(const char *&pos,
+                                                      std::size_t n) noexcept {
+  const char *ints = section<std::int64_t>(pos, n * number_ints);
+  return {ints, section<char>(pos, n * number_chars)};
+}
+
+/** Quantum number k of sections x, throws if it is neither text nor a
+ * rational */
+Quantum::Number read_number(std::pair<const char *, const char *> x,
+                            std::size_t k) {
+  const auto text = at<std::int64_t>(x.first, k * number_ints);
+  const auto n = at<std::int64_t>(x.first, k * number_ints + 1);
+  const auto d = at<std::int64_t>(x.first, k * number_ints + 2);
+  if (text == 1) {
+    std::array<char, number_chars> c;
+    std::memcpy(c.data(), x.second + k * number_chars, number_chars);
+    return Quantum::Number(c);
+  }
+  if (text not_eq 0 or n < std::numeric_limits<int>::min() or
+      n > std::numeric_limits<int>::max() or d < 0 or
+      d > std::numeric_limits<int>::max()) {
+    std::ostringstream os;
+    os << "Line catalog has a quantum number of kind " << text << " and "
+       << n << '/' << d << ", which is not one";
+    throw std::runtime_error(os.str());
+  }
+  return Quantum::Number(Rational(int(n), int(d)));
+}
+}  // namespace
+
+Catalog::Catalog(const std::string &path) : map(path), nbands(0), nlines(0) {
+  CatalogHeader head{};
+  if (map.size() >= sizeof head) std::memcpy(&head, map.data(), sizeof head);
+  if (head.magic not_eq catalog_magic or head.version not_eq catalog_version) {
+    std::ostringstream os;
+    os << '"' << path << '"' << " is not a line catalog of version "
+       << catalog_version;
+    throw std::runtime_error(os.str());
+  }
+
+  auto bad = [&path](const char *what) {
+    std::ostringstream os;
+    os << '"' << path << '"' << " is a broken line catalog: " << what;
+    throw std::runtime_error(os.str());
+  };
+
+  nbands = head.nbands;
+  nlines = head.nlines;
+  if (sizeof head + nbands * sizeof(CatalogBand) +
+          nlines * sizeof(CatalogLine) >
+      map.size())
+    bad("too short for its index");
+
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < nbands; i++) {
+    const auto &entry = catalog_band(map, i);
+    if (entry.offset % catalog_align or
+        entry.offset + info_size > map.size())
+      bad("band out of the file");
+    const char *pos = map.data() + entry.offset;
+    const CatalogBandInfo info = read_info(pos);
+    if (info.spec.index() >= Species::getIsotopeCount() or
+        info.nglobal not_eq info.spec.globalQuantumNumberCount() or
+        info.nlocal not_eq info.spec.localQuantumNumberCount())
+      bad("band of unknown isotopologue or quantum numbers");
+    if (entry.offset + payload_size(info, entry.nlines) > map.size())
+      bad("lines out of the file");
+    total += entry.nlines;
+  }
+  if (total not_eq nlines) bad("index not of all lines");
+}
+
+std::size_t Catalog::n_lines(std::size_t i) const noexcept {
+  return catalog_band(map, i).nlines;
+}
+
+std::pair<Frequency<FrequencyType::Freq>, Frequency<FrequencyType::Freq>>
+Catalog::Range(std::size_t i) const noexcept {
+  const auto &entry = catalog_band(map, i);
+  return {entry.fmin, entry.fmax};
+}
+
+std::vector<std::size_t> Catalog::overlapping(
+    Frequency<FrequencyType::Freq> fmin,
+    Frequency<FrequencyType::Freq> fmax) const noexcept {
+  std::vector<std::size_t> out;
+  for (std::size_t i = 0; i < nbands; i++) {
+    const auto &entry = catalog_band(map, i);
+    if (entry.nlines and entry.fmax >= fmin.value() and
+        entry.fmin <= fmax.value())
+      out.push_back(i);
+  }
+  return out;
+}
+
+std::pair<const CatalogLine *, const CatalogLine *> Catalog::lines(
+    Frequency<FrequencyType::Freq> fmin,
+    Frequency<FrequencyType::Freq> fmax) const noexcept {
+  const auto *first = reinterpret_cast<const CatalogLine *>(
+      map.data() + sizeof(CatalogHeader) + nbands * sizeof(CatalogBand));
+  const auto *last = first + nlines;
+  first = std::lower_bound(
+      first, last, fmin.value(),
+      [](const CatalogLine &l, double f) { return l.f0 < f; });
+  last = std::upper_bound(
+      first, last, fmax.value(),
+      [](double f, const CatalogLine &l) { return f < l.f0; });
+  return {first, last};
+}
+
+Band Catalog::band(std::size_t i) const {
+  const auto &entry = catalog_band(map, i);
+  const std::size_t n = entry.nlines;
+  const char *pos = map.data() + entry.offset;
+
+  const CatalogBandInfo info = read_info(pos);
+  const auto gl = number_sections(pos, info.nglobal);
+  const auto gu = number_sections(pos, info.nglobal);
+  const char *f0 = section<double>(pos, n);
+  const char *i0 = section<double>(pos, n);
+  const char *e0 = section<double>(pos, n);
+  const char *glow = section<double>(pos, n);
+  const char *gupp = section<double>(pos, n);
+  const char *a = section<double>(pos, n);
+  const char *zu = section<double>(pos, n);
+  const char *zl = section<double>(pos, n);
+  const char *si = section<std::int64_t>(pos, n * info.nshape * shape_ints);
+  const char *sd = section<double>(pos, n * info.nshape * shape_doubles);
+  const auto ll = number_sections(pos, n * info.nlocal);
+  const auto lu = number_sections(pos, n * info.nlocal);
+
+  std::vector<Quantum::Number> global_lower(info.nglobal);
+  std::vector<Quantum::Number> global_upper(info.nglobal);
+  for (std::size_t k = 0; k < info.nglobal; k++) {
+    global_lower[k] = read_number(gl, k);
+    global_upper[k] = read_number(gu, k);
+  }
+
+  Band band(info.spec, info.mirroring, info.normalization, info.population,
+            info.cutoff, info.shape, info.do_zeeman, info.t0, info.fcut,
+            global_lower, global_upper);
+
+  {
+    auto lines = band.EditLines();
+    lines->reserve(n);
+    std::vector<Quantum::Number> local_lower(info.nlocal);
+    std::vector<Quantum::Number> local_upper(info.nlocal);
+    std::vector<LineShape::AllSingleParameters> model(info.nshape);
+    for (std::size_t k = 0; k < n; k++) {
+      for (std::size_t q = 0; q < info.nlocal; q++) {
+        local_lower[q] = read_number(ll, k * info.nlocal + q);
+        local_upper[q] = read_number(lu, k * info.nlocal + q);
+      }
+      for (std::size_t s = 0; s < info.nshape; s++) {
+        const std::size_t is = (k * info.nshape + s) * shape_ints;
+        const std::size_t id = (k * info.nshape + s) * shape_doubles;
+        model[s].s = catalog_value<Species::Species>(
+            at<std::int64_t>(si, is), "broadening species");
+        for (std::size_t m = 0; m < nparams; m++) {
+          auto &x = model[s][LineShape::Parameter(m)];
+          x.temp = catalog_value<LineShape::TemperatureModel>(
+              at<std::int64_t>(si, is + 1 + 2 * m), "temperature model");
+          const auto pres = at<std::int64_t>(si, is + 2 + 2 * m);
+          if (pres < 0 or pres > std::numeric_limits<unsigned char>::max()) {
+            std::ostringstream os;
+            os << "Line catalog has " << pres
+               << " as pressure model, which is not one";
+            throw std::runtime_error(os.str());
+          }
+          x.pres = static_cast<unsigned char>(pres);
+          x.X0 = at<double>(sd, id + 4 * m);
+          x.X1 = at<double>(sd, id + 4 * m + 1);
+          x.X2 = at<double>(sd, id + 4 * m + 2);
+          x.X3 = at<double>(sd, id + 4 * m + 3);
+        }
+      }
+
+      lines->emplace_back(
+          info.spec, at<double>(f0, k), at<double>(i0, k), at<double>(e0, k),
+          Zeeman::Model(at<double>(zu, k), at<double>(zl, k)),
+          at<double>(gupp, k), at<double>(glow, k), at<double>(a, k),
+          local_lower, local_upper, LineShape::Model(model));
+    }
+  }
+  return band;
+}
+
+void saveCatalog(const std::string &path, const std::vector<Band> &bands) {
+  const std::size_t nlines = std::accumulate(
+      bands.cbegin(), bands.cend(), std::size_t(0),
+      [](std::size_t n, const Band &b) { return n + b.n_lines(); });
+  const std::size_t start = sizeof(CatalogHeader) +
+                            bands.size() * sizeof(CatalogBand) +
+                            nlines * sizeof(CatalogLine);
+
+  std::vector<CatalogBand> entries(bands.size());
+  std::vector<CatalogLine> index;
+  index.reserve(nlines);
+  std::string payload;
+  for (std::size_t ib = 0; ib < bands.size(); ib++) {
+    const Band &band = bands[ib];
+    const auto &lines = band.Lines();
+    const std::size_t n = lines.size();
+
+    const CatalogBandInfo info{band.Isotopologue(), band.MirrorType(),
+                               band.NormType(),     band.PopType(),
+                               band.CutType(),      band.ShapeType(),
+                               band.doZeeman(),     band.T0().value(),
+                               band.FCut().value(), band.n_global(),
+                               band.n_local(),      band.n_broadspec()};
+    entries[ib] = {std::numeric_limits<double>::infinity(),
+                   -std::numeric_limits<double>::infinity(), n,
+                   start + payload.size()};
+    put_info(payload, info);
+
+    std::vector<Quantum::Number> qn(info.nglobal);
+    for (std::size_t k = 0; k < info.nglobal; k++)
+      qn[k] = band.globalLowerQuantumNumber(k);
+    put_numbers(payload, qn);
+    for (std::size_t k = 0; k < info.nglobal; k++)
+      qn[k] = band.globalUpperQuantumNumber(k);
+    put_numbers(payload, qn);
+
+    std::vector<double> x(n);
+    auto put_values = [&](auto value) {
+      std::transform(lines.cbegin(), lines.cend(), x.begin(), value);
+      put(payload, x.data(), n);
+    };
+    put_values([](const Line &l) { return l.F0().value(); });
+    put_values([](const Line &l) { return l.I0().value(); });
+    put_values([](const Line &l) { return l.E0().value(); });
+    put_values([](const Line &l) { return l.Gl(); });
+    put_values([](const Line &l) { return l.Gu(); });
+    put_values([](const Line &l) { return l.A().value(); });
+    put_values([](const Line &l) { return l.Ze().gu; });
+    put_values([](const Line &l) { return l.Ze().gl; });
+
+    std::vector<std::int64_t> shape_i;
+    std::vector<double> shape_d;
+    shape_i.reserve(n * info.nshape * shape_ints);
+    shape_d.reserve(n * info.nshape * shape_doubles);
+    for (auto &line : lines) {
+      const auto &model = line.ShapeModel();
+      if (model.n_spec() not_eq info.nshape) {
+        std::ostringstream os;
+        os << "Lines of a band with " << model.n_spec() << " and "
+           << info.nshape << " broadening species cannot be in a catalog";
+        throw std::runtime_error(os.str());
+      }
+      for (std::size_t s = 0; s < info.nshape; s++) {
+        shape_i.push_back(std::int64_t(model[s].s));
+        for (std::size_t m = 0; m < nparams; m++) {
+          const auto &p = model[s][LineShape::Parameter(m)];
+          shape_i.push_back(std::int64_t(p.temp));
+          shape_i.push_back(std::int64_t(p.pres));
+          shape_d.insert(shape_d.end(), {p.X0, p.X1, p.X2, p.X3});
+        }
+      }
+    }
+    put(payload, shape_i.data(), shape_i.size());
+    put(payload, shape_d.data(), shape_d.size());
+
+    std::vector<Quantum::Number> local(n * info.nlocal);
+    for (std::size_t k = 0; k < n; k++)
+      for (std::size_t q = 0; q < info.nlocal; q++)
+        local[k * info.nlocal + q] = lines[k].localLowerQuantumNumber(q);
+    put_numbers(payload, local);
+    for (std::size_t k = 0; k < n; k++)
+      for (std::size_t q = 0; q < info.nlocal; q++)
+        local[k * info.nlocal + q] = lines[k].localUpperQuantumNumber(q);
+    put_numbers(payload, local);
+
+    for (std::size_t k = 0; k < n; k++) {
+      const double f = lines[k].F0().value();
+      entries[ib].fmin = std::min(entries[ib].fmin, f);
+      entries[ib].fmax = std::max(entries[ib].fmax, f);
+      index.push_back({f, ib, k});
+    }
+  }
+
+  std::stable_sort(
+      index.begin(), index.end(),
+      [](const CatalogLine &a, const CatalogLine &b) { return a.f0 < b.f0; });
+
+  const CatalogHeader head{catalog_magic, catalog_version, bands.size(),
+                           nlines};
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&head), sizeof head);
+  out.write(reinterpret_cast<const char *>(entries.data()),
+            entries.size() * sizeof(CatalogBand));
+  out.write(reinterpret_cast<const char *>(index.data()),
+            index.size() * sizeof(CatalogLine));
+  out.write(payload.data(), payload.size());
+  if (not out) {
+    std::ostringstream os;
+    os << '"' << path << '"' << " cannot be written.  Cannot save catalog.";
+    throw std::runtime_error(os.str());
+  }
+}
+
+std::vector<Band> readBands(const std::string &path,
+                            Frequency<FrequencyType::Freq> fmin,
+                            Frequency<FrequencyType::Freq> fmax) {
+  const Catalog catalog(path);
+  std::vector<Band> out;
+  for (auto i : catalog.overlapping(fmin, fmax)) out.push_back(catalog.band(i));
+  return out;
+}
 }  // namespace Absorption
@@ -1,8 +1,13 @@
 #ifndef lbl_h
 #define lbl_h
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
 #include <vector>
 
 #include "enums.h"
@@ -93,22 +98,28 @@ class Line {
   }
   Energy<EnergyType::Joule> E0() const noexcept { return e0; }
   Zeeman::Model Ze() const noexcept { return zeeman; }
+  /** The first and last index of the Zeeman components, for the i of
+   * ZeemanSplitting and ZeemanStrength */
   std::pair<int, int> ZeemanRange(Polarization p, Species::Isotope s) const {
     auto l = s.get_local(local_lower, Quantum::Type::F).rat();
     auto u = s.get_local(local_upper, Quantum::Type::F).rat();
     if (l.ok() and u.ok())
-      return std::pair<int, int>{Zeeman::start(u, l, p), Zeeman::end(u, l, p)};
+      return std::pair<int, int>{
+          0, int(Zeeman::end(u, l, p) - Zeeman::start(u, l, p))};
 
     l = s.get_local(local_lower, Quantum::Type::J).rat();
     u = s.get_local(local_upper, Quantum::Type::J).rat();
     if (l.ok() and u.ok())
-      return std::pair<int, int>{Zeeman::start(u, l, p), Zeeman::end(u, l, p)};
+      return std::pair<int, int>{
+          0, int(Zeeman::end(u, l, p) - Zeeman::start(u, l, p))};
 
     return std::pair<int, int>{0, 0};  // No Zeeman effect means one line!
   }
   Frequency<FrequencyType::Freq> ZeemanSplitting(Polarization p,
                                                  Species::Isotope s,
                                                  int i) const {
+    if (p == Polarization::None) return 0.0;
+
     auto l = s.get_local(local_lower, Quantum::Type::F).rat();
     auto u = s.get_local(local_upper, Quantum::Type::F).rat();
     if (l.ok() and u.ok()) return zeeman.Splitting(u, l, p, i);
@@ -120,6 +131,8 @@ class Line {
     return 0.0;  // No Zeeman effect means no splitting!
   }
   double ZeemanStrength(Polarization p, Species::Isotope s, int i) const {
+    if (p == Polarization::None) return 1.0;
+
     auto l = s.get_local(local_lower, Quantum::Type::F).rat();
     auto u = s.get_local(local_upper, Quantum::Type::F).rat();
     if (l.ok() and u.ok()) return zeeman.Strength(u, l, p, i);
@@ -151,6 +164,82 @@ class Line {
   std::size_t ID() const noexcept { return line_id; }
 };  // Line
 
+/** The values of all lines of a band that the cross-sections are computed from
+ *
+ * One array per value, so that a pass over the lines of a band reads memory in
+ * order rather than the full Line with its quantum numbers and the line shape
+ * model behind a pointer.  The line shape models of all lines are in one array
+ * with line i using [shape_offset[i], shape_offset[i + 1]).  The line-by-line
+ * computations read only these arrays, never the Line
+ */
+struct LineArrays {
+  std::vector<Frequency<FrequencyType::Freq>> f0;
+  std::vector<LineStrength<FrequencyType::Freq, AreaType::m2>> i0;
+  std::vector<Energy<EnergyType::Joule>> e0;
+  std::vector<double> gl;
+  std::vector<double> gu;
+  std::vector<Decay<DecayType::ExponentialPerSecond>> a;
+  std::vector<std::size_t> id;
+  std::vector<std::size_t> shape_offset;
+  std::vector<LineShape::AllSingleParameters> shape;
+
+  /** Copies the values of the lines */
+  void set(const std::vector<Line> &lines);
+
+  /** The line shape parameters of line i, as Line::ShapeModel()(...) */
+  LineShape::Output ShapeModel(
+      std::size_t i, Temperature<TemperatureType::K> T,
+      Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
+      const VMRs &vmr) const noexcept {
+    return LineShape::Model::Evaluate(shape.data() + shape_offset[i],
+                                      shape.data() + shape_offset[i + 1], T, T0,
+                                      P, vmr);
+  }
+
+  /** The line shape parameters of all lines into X and, unless it is
+   * nullptr, their temperature derivatives into dXdT
+   */
+  void ShapeModels(const LineShape::State &state, const VMRs &vmr,
+                   LineShape::Output *X,
+                   LineShape::Output *dXdT) const noexcept {
+    LineShape::Model::Evaluate(shape.data(), shape_offset.data(), f0.size(),
+                               state, vmr, X, dXdT);
+  }
+
+  /** As ShapeModels above but only of the lines with the given indices */
+  void ShapeModels(const std::vector<std::size_t> &lines,
+                   const LineShape::State &state, const VMRs &vmr,
+                   LineShape::Output *X,
+                   LineShape::Output *dXdT) const noexcept {
+    LineShape::Model::Evaluate(shape.data(), shape_offset.data(), lines.data(),
+                               lines.size(), state, vmr, X, dXdT);
+  }
+};
+
+/** Zeeman components of all lines of a band for the polarizations of the band
+ *
+ * For polarization p, line i has the components [offset[p][i],
+ * offset[p][i + 1]) with their relative strengths and splittings as
+ * Line::ZeemanStrength and Line::ZeemanSplitting.  Empty for polarizations
+ * that the band is not computed for
+ */
+struct ZeemanArrays {
+  std::array<std::vector<std::size_t>, 4> offset;
+  std::array<std::vector<double>, 4> strength;
+  std::array<std::vector<Frequency<FrequencyType::Freq>>, 4> splitting;
+
+  /** Computes the Zeeman components of the lines
+   *
+   * Throws if the Wigner symbols of a line cannot be computed
+   *
+   * @param[in] lines The lines
+   * @param[in] spec The isotopologue of the lines
+   * @param[in] zeeman If the Zeeman components are needed, otherwise only
+   * Polarization::None is set
+   */
+  void set(const std::vector<Line> &lines, Species::Isotope spec, bool zeeman);
+};
+
 class Band {
   Species::Isotope spec;
   Mirroring mirroring;
@@ -165,8 +254,78 @@ class Band {
   std::vector<Quantum::Number> global_upper;
   std::vector<Line> lines;
 
+  // Counts the times the lines may have changed, starts at 1
+  std::size_t generation;
+
+  /** Values derived from the lines, recomputed when first used after a change
+   *
+   * Copies start out empty as the values belong to the lines of another band.
+   * Recomputing is locked so that a const band can be shared by threads.  The
+   * Zeeman components have their own generation, as only the line-by-line
+   * computations need them
+   */
+  struct Derived {
+    mutable std::mutex mtx;
+    mutable std::atomic<std::size_t> generation{0};
+    mutable std::atomic<std::size_t> zeeman_generation{0};
+    mutable Frequency<FrequencyType::Freq> mean_freq{0};
+    mutable std::vector<std::size_t> order;
+    mutable LineArrays arrays;
+    mutable ZeemanArrays zeeman;
+
+    Derived() noexcept = default;
+    Derived(const Derived &) noexcept {}
+    Derived &operator=(const Derived &) noexcept {
+      generation = 0;
+      zeeman_generation = 0;
+      return *this;
+    }
+  } derived;
+
+  const Derived &update_zeeman() const {
+    if (derived.zeeman_generation.load(std::memory_order_acquire) not_eq
+        generation) {
+      std::lock_guard lock{derived.mtx};
+      if (derived.zeeman_generation.load(std::memory_order_relaxed) not_eq
+          generation) {
+        derived.zeeman.set(lines, spec, do_zeeman);
+        derived.zeeman_generation.store(generation, std::memory_order_release);
+      }
+    }
+    return derived;
+  }
+
+  const Derived &update_derived() const {
+    if (derived.generation.load(std::memory_order_acquire) not_eq generation) {
+      std::lock_guard lock{derived.mtx};
+      if (derived.generation.load(std::memory_order_relaxed) not_eq
+          generation) {
+        const double val = std::inner_product(
+            lines.cbegin(), lines.cend(), lines.cbegin(), 0.0,
+            std::plus<double>(),
+            [](const auto &a, const auto &b) { return a.F0() * b.I0(); });
+        const double div = std::accumulate(
+            lines.cbegin(), lines.cend(), 0.0,
+            [](const auto &a, const auto &b) { return a + b.I0(); });
+        derived.mean_freq = val / div;
+
+        derived.order.resize(lines.size());
+        std::iota(derived.order.begin(), derived.order.end(), 0);
+        std::stable_sort(derived.order.begin(), derived.order.end(),
+                         [this](std::size_t a, std::size_t b) {
+                           return lines[a].F0() < lines[b].F0();
+                         });
+
+        derived.arrays.set(lines);
+
+        derived.generation.store(generation, std::memory_order_release);
+      }
+    }
+    return derived;
+  }
+
  public:
-  Band() noexcept : spec(Species::Species::FINAL, 0) {}
+  Band() noexcept : spec(Species::Species::FINAL, 0), generation(1) {}
 
   // Init band
   Band(Species::Isotope s, Mirroring m, Normalization n, Population p, Cutoff c,
@@ -185,7 +344,8 @@ class Band {
         fcut(FCut),
         global_lower(gl),
         global_upper(gu),
-        lines(N, Line{s}) {
+        lines(N, Line{s}),
+        generation(1) {
     size_t size = s.globalQuantumNumberCount();
     if (size not_eq gl.size() or size not_eq gu.size()) {
       std::cerr << "Bad quantum number sizes\n";
@@ -201,7 +361,10 @@ class Band {
            global_lower == b.global_lower and global_upper == b.global_upper;
   }
 
-  void appendLine(Line line) noexcept { lines.push_back(std::move(line)); }
+  void appendLine(Line line) noexcept {
+    lines.push_back(std::move(line));
+    generation++;
+  }
 
   Species::Isotope Isotopologue() const noexcept { return spec; }
   Species::Species Species() const noexcept { return spec.Spec(); }
@@ -243,41 +406,79 @@ class Band {
     return spec.get_localquantumnumbers();
   }
   const std::vector<Line> &Lines() const noexcept { return lines; }
-  std::vector<Line> &Lines() noexcept { return lines; }
+
+  /** Access to change the lines of a band, see Band::EditLines() */
+  class LinesEditor {
+    Band &band;
+
+   public:
+    explicit LinesEditor(Band &b) noexcept : band(b) {}
+    LinesEditor(const LinesEditor &) = delete;
+    LinesEditor &operator=(const LinesEditor &) = delete;
+    ~LinesEditor() noexcept { band.generation++; }
+
+    std::vector<Line> &operator*() const noexcept { return band.lines; }
+    std::vector<Line> *operator->() const noexcept { return &band.lines; }
+    Line &operator[](std::size_t i) const noexcept { return band.lines[i]; }
+    std::vector<Line>::iterator begin() const noexcept {
+      return band.lines.begin();
+    }
+    std::vector<Line>::iterator end() const noexcept {
+      return band.lines.end();
+    }
+  };
+
+  /** The lines for editing
+   *
+   * Values derived from the lines are computed again when first used after
+   * the editor is gone, so do not use them, nor the references of Arrays() and
+   * LineOrder(), while it exists.  Only the editor changes the lines, reading
+   * them through Lines() keeps the derived values
+   */
+  LinesEditor EditLines() noexcept { return LinesEditor{*this}; }
+
+  /** Changes whenever the lines may have changed */
+  std::size_t Generation() const noexcept { return generation; }
+
+  /** The lines as arrays of their values */
+  const LineArrays &Arrays() const { return update_derived().arrays; }
+
+  /** The Zeeman components of the lines, throws if they cannot be computed */
+  const ZeemanArrays &Zeeman() const { return update_zeeman().zeeman; }
+
+  /** Indices of the lines ordered by increasing F0 */
+  const std::vector<std::size_t> &LineOrder() const {
+    return update_derived().order;
+  }
   double GD_giv_F0(Temperature<TemperatureType::K> T) const {
     return std::sqrt(Constant::doppler_broadening_const_squared * T /
                      spec.mass());
   }
-  Frequency<FrequencyType::Freq> CutoffUpper(size_t iline) const noexcept {
+  Frequency<FrequencyType::Freq> CutoffUpper(size_t iline) const {
     switch (cutoff) {
       case Cutoff::None:
         return std::numeric_limits<double>::max();
       case Cutoff::ByFixedFrequency:
         return fcut;
       case Cutoff::ByLineOffset:
-        return lines[iline].F0() + fcut;
+        return Arrays().f0[iline] + fcut;
       case Cutoff::FINAL: { /*leave last*/
       }
     }
     return {};
   }
-  Frequency<FrequencyType::Freq> MeanFreq() const noexcept {
-    const double val = std::inner_product(
-        lines.cbegin(), lines.cend(), lines.cbegin(), 0.0, std::plus<double>(),
-        [](const auto &a, const auto &b) { return a.F0() * b.I0(); });
-    const double div = std::accumulate(
-        lines.cbegin(), lines.cend(), 0.0,
-        [](const auto &a, const auto &b) { return a + b.I0(); });
-    return val / div;
+  /** The line strength weighted mean of F0 */
+  Frequency<FrequencyType::Freq> MeanFreq() const {
+    return update_derived().mean_freq;
   }
-  Frequency<FrequencyType::Freq> CutoffLower(size_t iline) const noexcept {
+  Frequency<FrequencyType::Freq> CutoffLower(size_t iline) const {
     switch (cutoff) {
       case Cutoff::None:
         return -std::numeric_limits<double>::max();
       case Cutoff::ByFixedFrequency:
         return fcut - 2 * MeanFreq();
       case Cutoff::ByLineOffset:
-        return lines[iline].F0() - fcut;
+        return Arrays().f0[iline] - fcut;
       case Cutoff::FINAL: { /*leave last*/
       }
     }
@@ -290,6 +491,10 @@ class Band {
   double dQT(Temperature<TemperatureType::K> T) const noexcept {
     return spec.dQT(T);
   }
+  Species::PartitionValue Partition(
+      Temperature<TemperatureType::K> T) const noexcept {
+    return spec.Partition(T);
+  }
   bool doZeeman() const noexcept { return do_zeeman; }
 
   friend void readBand(File::File<File::Operation::Read, File::Type::Xml> &file,
@@ -304,6 +509,21 @@ std::vector<Band> parse_hitran_with_qns(
     Frequency<FrequencyType::Freq> flow,
     Frequency<FrequencyType::Freq> fupp) noexcept;
 
+/** Reads the lines inside [flow, fupp] of a HITRAN catalog into bands
+ *
+ * The file is mapped to memory and parsed in chunks of whole records on the
+ * compute arena.  The bands are the same, and in the same order, as from
+ * reading the file line by line, except that the catalog need not be sorted
+ * by frequency
+ *
+ * @param[in] path Path to a .par file with quantum numbers
+ * @param[in] flow Lowest frequency to keep
+ * @param[in] fupp Highest frequency to keep
+ */
+std::vector<Band> parse_hitran_with_qns(const std::string &path,
+                                        Frequency<FrequencyType::Freq> flow,
+                                        Frequency<FrequencyType::Freq> fupp);
+
 void saveBand(File::File<File::Operation::Write, File::Type::Xml> &file,
               const Band &band, const std::string &key = "Band");
 void saveBand(File::File<File::Operation::WriteBinary, File::Type::Xml> &file,
@@ -320,6 +540,66 @@ void saveBands(File::File<X, File::Type::Xml> &file,
   for (size_t i = 0; i < bands.size(); i++)
     saveBand(file, bands[i], std::string{"Band"} + std::to_string(i + 1));
 }
+
+/** A line of a Catalog, in the index of all lines by frequency */
+struct CatalogLine {
+  double f0;
+  std::uint64_t band;
+  std::uint64_t line;
+};
+
+/** A binary line catalog mapped to memory
+ *
+ * The file starts with a header, then the frequency range and the number of
+ * lines of each band, then the index of all lines sorted by F0.  The bands
+ * follow with their lines as one array per value, so a band is read without
+ * parsing any other part of the file.  Write it with saveCatalog
+ */
+class Catalog {
+  File::Mapped map;
+  std::size_t nbands;
+  std::size_t nlines;
+
+ public:
+  /** Maps the catalog at path, throws if it is not a catalog of this version
+   */
+  explicit Catalog(const std::string &path);
+
+  /** Number of bands */
+  std::size_t size() const noexcept { return nbands; }
+
+  /** Number of lines of band i */
+  std::size_t n_lines(std::size_t i) const noexcept;
+
+  /** Lowest and highest F0 of the lines of band i */
+  std::pair<Frequency<FrequencyType::Freq>, Frequency<FrequencyType::Freq>>
+  Range(std::size_t i) const noexcept;
+
+  /** Indices of the bands with lines from fmin to fmax, in catalog order */
+  std::vector<std::size_t> overlapping(
+      Frequency<FrequencyType::Freq> fmin,
+      Frequency<FrequencyType::Freq> fmax) const noexcept;
+
+  /** The lines with F0 from fmin to fmax, sorted by F0, in the mapped file */
+  std::pair<const CatalogLine *, const CatalogLine *> lines(
+      Frequency<FrequencyType::Freq> fmin,
+      Frequency<FrequencyType::Freq> fmax) const noexcept;
+
+  /** Reads band i */
+  Band band(std::size_t i) const;
+};  // Catalog
+
+/** Writes the bands as a Catalog */
+void saveCatalog(const std::string &path, const std::vector<Band> &bands);
+
+/** Reads only the bands of a Catalog that have lines from fmin to fmax
+ *
+ * The lines of a band outside the range are read with it, as are bands that
+ * span the range without a line in it.  Widen the range for line wings
+ */
+std::vector<Band> readBands(const std::string &path,
+                            Frequency<FrequencyType::Freq> fmin,
+                            Frequency<FrequencyType::Freq> fmax);
 }  // namespace Absorption
 
 #endif  // lbl_h
@@ -1,13 +1,14 @@
 #ifndef lineshapes_h
 #define lineshapes_h
 
-#include <Faddeeva.hh>
 #include <array>
+#include <cmath>
 #include <vector>
 
 #include "complex.h"
 #include "constants.h"
 #include "enums.h"
+#include "faddeeva.h"
 #include "units.h"
 
 namespace Absorption {
@@ -16,6 +17,23 @@ namespace LineShape {
 ENUMCLASS(TemperatureModel, unsigned char, None, T0, T1, T2, T3, T4, T5, LM_AER,
           DPL)
 
+/** The terms of the temperature models that do not depend on the line
+ *
+ * Computed once for all lines of a band at one atmospheric state, so that
+ * pow(T0 / T, n) becomes exp(n log(T0 / T)) with the logarithm shared
+ */
+struct State {
+  double T;
+  double T0;
+  double P;
+  double ratio;
+  double log_ratio;
+
+  State(Temperature<TemperatureType::K> t, Temperature<TemperatureType::K> t0,
+        Pressure<PressureType::Pa> p) noexcept
+      : T(t), T0(t0), P(p), ratio(t0 / t), log_ratio(std::log(t0 / t)) {}
+};
+
 struct SingleParameter {
   TemperatureModel temp;
   unsigned char pres;
@@ -34,6 +52,13 @@ struct SingleParameter {
       return X1 + (T - 250) * (X2 - X1) / (296 - 250);
   }
 
+  /** pow(P, pres) without the call for the usual powers */
+  double pressure(double P) const noexcept {
+    if (pres == 0) return 1;
+    if (pres == 1) return P;
+    return std::pow(P, pres);
+  }
+
   constexpr double special_linemixing_aer_dT(double T) const noexcept {
     if (T < 250)
       return (X1 - X0) / (250 - 200);
@@ -460,6 +485,88 @@ struct SingleParameter {
     return pres * pow(P, pres - 1) * out;
   }
 
+  /** As operator(), with the shared terms of the state */
+  double at(const State &s) const noexcept {
+    using std::exp;
+
+    double out = std::numeric_limits<double>::quiet_NaN();
+    switch (temp) {
+      case TemperatureModel::None:
+        out = 0;
+        break;
+      case TemperatureModel::T0:
+        out = X0;
+        break;
+      case TemperatureModel::T1:
+        out = X0 * exp(X1 * s.log_ratio);
+        break;
+      case TemperatureModel::T2:
+        out = X0 * exp(X1 * s.log_ratio) * (1 - X2 * s.log_ratio);
+        break;
+      case TemperatureModel::T3:
+        out = X0 + X1 * (s.T - s.T0);
+        break;
+      case TemperatureModel::T4:
+        out = (X0 + X1 * (s.ratio - 1.)) * exp(X2 * s.log_ratio);
+        break;
+      case TemperatureModel::T5:
+        out = X0 * exp((0.25 + 1.5 * X1) * s.log_ratio);
+        break;
+      case TemperatureModel::LM_AER:
+        out = special_linemixing_aer(s.T);
+        break;
+      case TemperatureModel::DPL:
+        out = X0 * exp(X1 * s.log_ratio) + X2 * exp(X3 * s.log_ratio);
+        break;
+      case TemperatureModel::FINAL: {
+      }
+    }
+    return pressure(s.P) * out;
+  }
+
+  /** As dT(), with the shared terms of the state */
+  double dT_at(const State &s) const noexcept {
+    using std::exp;
+
+    double out = std::numeric_limits<double>::quiet_NaN();
+    switch (temp) {
+      case TemperatureModel::None:
+        out = 0;
+        break;
+      case TemperatureModel::T0:
+        out = 0;
+        break;
+      case TemperatureModel::T1:
+        out = -X0 * X1 * exp(X1 * s.log_ratio) / s.T;
+        break;
+      case TemperatureModel::T2:
+        out = -X0 * X1 * exp(X1 * s.log_ratio) * (1 - X2 * s.log_ratio) / s.T +
+              X0 * X2 * exp(X1 * s.log_ratio) / s.T;
+        break;
+      case TemperatureModel::T3:
+        out = X1;
+        break;
+      case TemperatureModel::T4:
+        out = -X2 * exp(X2 * s.log_ratio) * (X0 + X1 * (s.ratio - 1.)) / s.T -
+              s.T0 * X1 * exp(X2 * s.log_ratio) / (s.T * s.T);
+        break;
+      case TemperatureModel::T5:
+        out = -X0 * exp((1.5 * X1 + 0.25) * s.log_ratio) * (1.5 * X1 + 0.25) /
+              s.T;
+        break;
+      case TemperatureModel::LM_AER:
+        out = special_linemixing_aer_dT(s.T);
+        break;
+      case TemperatureModel::DPL:
+        out = -X0 * X1 * exp(X1 * s.log_ratio) / s.T +
+              -X2 * X3 * exp(X3 * s.log_ratio) / s.T;
+        break;
+      case TemperatureModel::FINAL: {
+      }
+    }
+    return pressure(s.P) * out;
+  }
+
   void Temperature(TemperatureModel x) noexcept { temp = x; }
   void Pressure(unsigned char x) noexcept { pres = x; }
   constexpr TemperatureModel Temperature() const noexcept { return temp; }
@@ -712,11 +819,13 @@ class Model {
   }
 
  private:
-  double sum_of_vmr(const std::vector<VMR<VMRType::ratio>> &vmr) const {
+  static double sum_of_vmr(const AllSingleParameters *first,
+                           const AllSingleParameters *last,
+                           const VMRs &vmr) noexcept {
     double vmrsum = 0;
-    for (auto &params : data) {
+    for (auto *params = first; params not_eq last; ++params) {
       for (auto &v : vmr) {
-        if (v.Species() == params.s) {
+        if (v.Species() == params->s) {
           vmrsum += v.value();
           break;
         }
@@ -725,19 +834,28 @@ class Model {
     return vmrsum;
   }
 
+  double sum_of_vmr(const VMRs &vmr) const {
+    return sum_of_vmr(data.data(), data.data() + data.size(), vmr);
+  }
+
  public:
-  Output operator()(
+  /** The parameters of the model made of the species [first, last)
+   *
+   * For models stored elsewhere than in a Model, like the line arrays of a
+   * band
+   */
+  static Output Evaluate(
+      const AllSingleParameters *first, const AllSingleParameters *last,
       Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
-      Pressure<PressureType::Pa> P,
-      const std::vector<VMR<VMRType::ratio>> &vmr) const noexcept {
+      Pressure<PressureType::Pa> P, const VMRs &vmr) noexcept {
     Output out;
-    const double vmrsum = sum_of_vmr(vmr);
+    const double vmrsum = sum_of_vmr(first, last, vmr);
 
-    for (auto &params : data) {
+    for (auto *params = first; params not_eq last; ++params) {
       for (auto &v : vmr) {
-        if (v.Species() == params.s) {
+        if (v.Species() == params->s) {
           for (unsigned char i = 0; i < N; i++) {
-            out[Parameter(i)] += params[i](T, T0, P) * v.value();
+            out[Parameter(i)] += (*params)[i](T, T0, P) * v.value();
           }
           break;
         }
@@ -753,17 +871,96 @@ class Model {
     return out;
   }
 
-  double dX0(Temperature<TemperatureType::K> T,
-             Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-             const std::vector<VMR<VMRType::ratio>> &vmr, Species::Species spec,
-             Parameter target) const noexcept {
-    const double vmrsum = sum_of_vmr(vmr);
+  /** Evaluate, and optionally dT, of n models at one atmospheric state
+   *
+   * Model i is made of the species [params + offset[i], params + offset[i + 1])
+   * and its output goes to X[i] and, unless it is nullptr, dXdT[i]
+   */
+  static void Evaluate(const AllSingleParameters *params,
+                       const std::size_t *offset, std::size_t n,
+                       const State &state, const VMRs &vmr, Output *X,
+                       Output *dXdT) noexcept {
+    for (std::size_t iline = 0; iline < n; iline++)
+      evaluate(params + offset[iline], params + offset[iline + 1], state, vmr,
+               X[iline], dXdT ? dXdT + iline : nullptr);
+  }
+
+  /** As above but only of the n models lines[0] to lines[n - 1]
+   *
+   * The outputs of the other models are left as they are
+   */
+  static void Evaluate(const AllSingleParameters *params,
+                       const std::size_t *offset, const std::size_t *lines,
+                       std::size_t n, const State &state, const VMRs &vmr,
+                       Output *X, Output *dXdT) noexcept {
+    for (std::size_t k = 0; k < n; k++) {
+      const std::size_t iline = lines[k];
+      evaluate(params + offset[iline], params + offset[iline + 1], state, vmr,
+               X[iline], dXdT ? dXdT + iline : nullptr);
+    }
+  }
+
+ private:
+  /** Evaluate, and dT unless dXdT is nullptr, of the model [first, last) */
+  static void evaluate(const AllSingleParameters *first,
+                       const AllSingleParameters *last, const State &state,
+                       const VMRs &vmr, Output &X, Output *dXdT) noexcept {
+    Output x, dx;
+    double vmrsum = 0;
+    for (auto *p = first; p not_eq last; ++p) {
+      for (auto &v : vmr) {
+        if (v.Species() == p->s) {
+          vmrsum += v.value();
+          for (unsigned char i = 0; i < N; i++) {
+            x[Parameter(i)] += (*p)[i].at(state) * v.value();
+          }
+          if (dXdT) {
+            for (unsigned char i = 0; i < N; i++) {
+              dx[Parameter(i)] += (*p)[i].dT_at(state) * v.value();
+            }
+          }
+          break;
+        }
+      }
+    }
+
+    if (vmrsum not_eq 0) {
+      for (unsigned char i = 0; i < N; i++) {
+        x[Parameter(i)] /= vmrsum;
+        dx[Parameter(i)] /= vmrsum;
+      }
+    }
+
+    X = x;
+    if (dXdT) *dXdT = dx;
+  }
+
+ public:
+  const AllSingleParameters *begin() const noexcept { return data.data(); }
+  const AllSingleParameters *end() const noexcept {
+    return data.data() + data.size();
+  }
+
+  Output operator()(
+      Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
+      Pressure<PressureType::Pa> P, const VMRs &vmr) const noexcept {
+    return Evaluate(begin(), end(), T, T0, P, vmr);
+  }
+
+  /** As dX0() for the model made of the species [first, last) */
+  static double dX0(
+      const AllSingleParameters *first, const AllSingleParameters *last,
+      Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
+      Pressure<PressureType::Pa> P, const VMRs &vmr, Species::Species spec,
+      Parameter target) noexcept {
+    const double vmrsum = sum_of_vmr(first, last, vmr);
     if (vmrsum > 0) {
-      for (auto &params : data) {
+      for (auto *params = first; params not_eq last; ++params) {
         for (auto &v : vmr) {
-          if (v.Species() == params.s) {
+          if (v.Species() == params->s) {
             if (spec == v.Species()) {
-              return params[size_t(target)].dX0(T, T0, P) * v.value() / vmrsum;
+              return (*params)[size_t(target)].dX0(T, T0, P) * v.value() /
+                     vmrsum;
             }
           }
         }
@@ -772,17 +969,27 @@ class Model {
     return 0;
   }
 
-  double dX1(Temperature<TemperatureType::K> T,
+  double dX0(Temperature<TemperatureType::K> T,
              Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-             const std::vector<VMR<VMRType::ratio>> &vmr, Species::Species spec,
+             const VMRs &vmr, Species::Species spec,
              Parameter target) const noexcept {
-    const double vmrsum = sum_of_vmr(vmr);
+    return dX0(begin(), end(), T, T0, P, vmr, spec, target);
+  }
+
+  /** As dX1() for the model made of the species [first, last) */
+  static double dX1(
+      const AllSingleParameters *first, const AllSingleParameters *last,
+      Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
+      Pressure<PressureType::Pa> P, const VMRs &vmr, Species::Species spec,
+      Parameter target) noexcept {
+    const double vmrsum = sum_of_vmr(first, last, vmr);
     if (vmrsum > 0) {
-      for (auto &params : data) {
+      for (auto *params = first; params not_eq last; ++params) {
         for (auto &v : vmr) {
-          if (v.Species() == params.s) {
+          if (v.Species() == params->s) {
             if (spec == v.Species()) {
-              return params[size_t(target)].dX1(T, T0, P) * v.value() / vmrsum;
+              return (*params)[size_t(target)].dX1(T, T0, P) * v.value() /
+                     vmrsum;
             }
           }
         }
@@ -791,17 +998,27 @@ class Model {
     return 0;
   }
 
-  double dX2(Temperature<TemperatureType::K> T,
+  double dX1(Temperature<TemperatureType::K> T,
              Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-             const std::vector<VMR<VMRType::ratio>> &vmr, Species::Species spec,
+             const VMRs &vmr, Species::Species spec,
              Parameter target) const noexcept {
-    const double vmrsum = sum_of_vmr(vmr);
+    return dX1(begin(), end(), T, T0, P, vmr, spec, target);
+  }
+
+  /** As dX2() for the model made of the species [first, last) */
+  static double dX2(
+      const AllSingleParameters *first, const AllSingleParameters *last,
+      Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
+      Pressure<PressureType::Pa> P, const VMRs &vmr, Species::Species spec,
+      Parameter target) noexcept {
+    const double vmrsum = sum_of_vmr(first, last, vmr);
     if (vmrsum > 0) {
-      for (auto &params : data) {
+      for (auto *params = first; params not_eq last; ++params) {
         for (auto &v : vmr) {
-          if (v.Species() == params.s) {
+          if (v.Species() == params->s) {
             if (spec == v.Species()) {
-              return params[size_t(target)].dX2(T, T0, P) * v.value() / vmrsum;
+              return (*params)[size_t(target)].dX2(T, T0, P) * v.value() /
+                     vmrsum;
             }
           }
         }
@@ -810,17 +1027,27 @@ class Model {
     return 0;
   }
 
-  double dX3(Temperature<TemperatureType::K> T,
+  double dX2(Temperature<TemperatureType::K> T,
              Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-             const std::vector<VMR<VMRType::ratio>> &vmr, Species::Species spec,
+             const VMRs &vmr, Species::Species spec,
              Parameter target) const noexcept {
-    const double vmrsum = sum_of_vmr(vmr);
+    return dX2(begin(), end(), T, T0, P, vmr, spec, target);
+  }
+
+  /** As dX3() for the model made of the species [first, last) */
+  static double dX3(
+      const AllSingleParameters *first, const AllSingleParameters *last,
+      Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
+      Pressure<PressureType::Pa> P, const VMRs &vmr, Species::Species spec,
+      Parameter target) noexcept {
+    const double vmrsum = sum_of_vmr(first, last, vmr);
     if (vmrsum > 0) {
-      for (auto &params : data) {
+      for (auto *params = first; params not_eq last; ++params) {
         for (auto &v : vmr) {
-          if (v.Species() == params.s) {
+          if (v.Species() == params->s) {
             if (spec == v.Species()) {
-              return params[size_t(target)].dX1(T, T0, P) * v.value() / vmrsum;
+              return (*params)[size_t(target)].dX1(T, T0, P) * v.value() /
+                     vmrsum;
             }
           }
         }
@@ -829,9 +1056,16 @@ class Model {
     return 0;
   }
 
+  double dX3(Temperature<TemperatureType::K> T,
+             Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
+             const VMRs &vmr, Species::Species spec,
+             Parameter target) const noexcept {
+    return dX3(begin(), end(), T, T0, P, vmr, spec, target);
+  }
+
   Output dT(Temperature<TemperatureType::K> T,
             Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-            const std::vector<VMR<VMRType::ratio>> &vmr) const noexcept {
+            const VMRs &vmr) const noexcept {
     Output out;
     const double vmrsum = sum_of_vmr(vmr);
 
@@ -857,7 +1091,7 @@ class Model {
 
   Output dT0(Temperature<TemperatureType::K> T,
              Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-             const std::vector<VMR<VMRType::ratio>> &vmr) const noexcept {
+             const VMRs &vmr) const noexcept {
     Output out;
     const double vmrsum = sum_of_vmr(vmr);
 
@@ -883,7 +1117,7 @@ class Model {
 
   Output dP(Temperature<TemperatureType::K> T,
             Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-            const std::vector<VMR<VMRType::ratio>> &vmr) const noexcept {
+            const VMRs &vmr) const noexcept {
     Output out;
     const double vmrsum = sum_of_vmr(vmr);
 
@@ -907,18 +1141,20 @@ class Model {
     return out;
   }
 
-  Output dVMR(Temperature<TemperatureType::K> T,
-              Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
-              const std::vector<VMR<VMRType::ratio>> &vmr,
-              const Species::Species s) const noexcept {
+  /** As dVMR() for the model made of the species [first, last) */
+  static Output dVMR(
+      const AllSingleParameters *first, const AllSingleParameters *last,
+      Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
+      Pressure<PressureType::Pa> P, const VMRs &vmr,
+      const Species::Species s) noexcept {
     Output out;
-    const double vmrsum = sum_of_vmr(vmr);
+    const double vmrsum = sum_of_vmr(first, last, vmr);
 
-    for (auto &params : data) {
+    for (auto *params = first; params not_eq last; ++params) {
       for (auto &v : vmr) {
-        if (v.Species() == params.s and v.Species() == s) {
+        if (v.Species() == params->s and v.Species() == s) {
           for (unsigned char i = 0; i < N; i++) {
-            out[Parameter(i)] += params[i].dP(T, T0, P) * v.value();
+            out[Parameter(i)] += (*params)[i].dP(T, T0, P) * v.value();
           }
           break;
         }
@@ -933,6 +1169,12 @@ class Model {
 
     return out;
   }
+
+  Output dVMR(Temperature<TemperatureType::K> T,
+              Temperature<TemperatureType::K> T0, Pressure<PressureType::Pa> P,
+              const VMRs &vmr, const Species::Species s) const noexcept {
+    return dVMR(begin(), end(), T, T0, P, vmr, s);
+  }
 };  // Model
 
 namespace Base {
@@ -2439,11 +2681,50 @@ class HartmannTran {
 
   double F0() const noexcept { return mF0; }
 
+  /** Most Faddeeva function evaluations per frequency */
+  static constexpr std::size_t nw = 2;
+
+  /** The frequency dependent part of the line shape */
+  struct State {
+    Complex deltax;
+    Complex x;
+    Complex sqrtxy;
+    Complex sqrtx;
+    Complex z1;
+    Complex z2;
+    CalcType calcs;
+    std::size_t n;  // Number of Faddeeva function arguments
+  };
+
+  /** Writes the arguments of the Faddeeva function at f to w, returns s.n */
+  std::size_t w_args(double f, Complex *w, State &s) noexcept {
+    at(f);
+    s.n = args(w);
+    s.deltax = deltax;
+    s.x = x;
+    s.sqrtxy = sqrtxy;
+    s.sqrtx = sqrtx;
+    s.z1 = z1;
+    s.z2 = z2;
+    s.calcs = calcs;
+    return s.n;
+  }
+
+  /** As operator()(f) with the s.n values of w at the arguments of w_args */
+  Complex &operator()(const State &s, const Complex *w) noexcept {
+    deltax = s.deltax;
+    x = s.x;
+    sqrtxy = s.sqrtxy;
+    sqrtx = s.sqrtx;
+    z1 = s.z1;
+    z2 = s.z2;
+    calcs = s.calcs;
+    calc(w);
+    return F;
+  }
+
   Complex &operator()(double f) noexcept {
-    reinterpret_cast<double(&)[2]>(deltax)[1] = mF0 - f;
-    x = deltax / ((1 - ETA) * Complex(G2, D2));
-    sqrtxy = std::sqrt(x + sqrty * sqrty);
-    update_calcs();
+    at(f);
     calc();
     return F;
   }
@@ -2465,13 +2746,59 @@ class HartmannTran {
 
   void update_calcs() noexcept { calcs = init((1 - ETA) * Complex(G2, D2)); }
 
-  void calc() noexcept {
+  void at(double f) noexcept {
+    reinterpret_cast<double(&)[2]>(deltax)[1] = mF0 - f;
+    x = deltax / ((1 - ETA) * Complex(G2, D2));
+    sqrtxy = std::sqrt(x + sqrty * sqrty);
+    update_calcs();
+  }
+
+  /** The arguments of w for the current calculation, returns how many */
+  std::size_t args(Complex *z) noexcept {
     switch (calcs) {
       case CalcType::Full:
         z1 = sqrtxy - sqrty;
         z2 = sqrtxy + sqrty;
-        w1 = Faddeeva::w(Complex(0, 1) * z1);
-        w2 = Faddeeva::w(Complex(0, 1) * z2);
+        break;
+      case CalcType::Noc2tLowZ:
+      case CalcType::Noc2tHighZ:
+        z1 = deltax * invGD;
+        calcs = abs_squared(z1) < 16e6 ? CalcType::Noc2tLowZ
+                                       : CalcType::Noc2tHighZ;
+        z[0] = Complex(0, 1) * z1;
+        return 1;
+      case CalcType::LowXandHighY:
+        z1 = deltax * invGD;
+        z2 = sqrtxy + sqrty;
+        break;
+      case CalcType::LowYandLowX:
+        sqrtx = std::sqrt(x);
+        z1 = sqrtxy;
+        z2 = sqrtx;
+        break;
+      case CalcType::LowYandHighX:
+        z1 = sqrtxy;
+        z[0] = Complex(0, 1) * z1;
+        return 1;
+    }
+    z[0] = Complex(0, 1) * z1;
+    z[1] = Complex(0, 1) * z2;
+    return 2;
+  }
+
+  void calc() noexcept {
+    Complex w[nw];
+    const std::size_t n = args(w);
+    for (std::size_t i = 0; i < n; i++) w[i] = Faddeeva::w(w[i]);
+    calc(w);
+  }
+
+  /** Computes the line shape from w of args() */
+  void calc(const Complex *w) noexcept {
+    switch (calcs) {
+      case CalcType::Full:
+        w1 = w[0];
+        w2 = w[1];
         A = Constant::sqrt_pi * invGD * (w1 - w2);
         B = (-1 +
              Constant::sqrt_pi / (2 * sqrty) * (1 - Constant::pow2(z1)) * w1 -
@@ -2479,35 +2806,27 @@ class HartmannTran {
             ((1 - ETA) * Complex(G2, D2));
         break;
       case CalcType::Noc2tLowZ:
+        w1 = w[0];
+        A = Constant::sqrt_pi * invGD * w1;
+        B = Constant::sqrt_pi * invGD *
+            ((1 - Constant::pow2(z1)) * w1 + z1 / Constant::sqrt_pi);
+        break;
       case CalcType::Noc2tHighZ:
-        z1 = deltax * invGD;
-        w1 = Faddeeva::w(Complex(0, 1) * z1);
+        w1 = w[0];
         A = Constant::sqrt_pi * invGD * w1;
-        if (abs_squared(z1) < 16e6) {
-          calcs = CalcType::Noc2tLowZ;
-          B = Constant::sqrt_pi * invGD *
-              ((1 - Constant::pow2(z1)) * w1 + z1 / Constant::sqrt_pi);
-        } else {
-          calcs = CalcType::Noc2tHighZ;
-          B = invGD * (Constant::sqrt_pi * w1 + 1 / z1 / 2 -
-                       3 / Constant::pow3(z1) / 4);
-        }
+        B = invGD * (Constant::sqrt_pi * w1 + 1 / z1 / 2 -
+                     3 / Constant::pow3(z1) / 4);
         break;
       case CalcType::LowXandHighY:
-        z1 = deltax * invGD;
-        z2 = sqrtxy + sqrty;
-        w1 = Faddeeva::w(Complex(0, 1) * z1);
-        w2 = Faddeeva::w(Complex(0, 1) * z2);
+        w1 = w[0];
+        w2 = w[1];
         A = Constant::sqrt_pi * invGD * (w1 - w2);
         B = invGD *
             (Constant::sqrt_pi * w1 + 1 / z1 / 2 - 3 / Constant::pow3(z1) / 4);
         break;
       case CalcType::LowYandLowX:
-        sqrtx = std::sqrt(x);
-        z1 = sqrtxy;
-        z2 = sqrtx;
-        w1 = Faddeeva::w(Complex(0, 1) * z1);
-        w2 = Faddeeva::w(Complex(0, 1) * z2);
+        w1 = w[0];
+        w2 = w[1];
         A = (2 * Constant::sqrt_pi / ((1 - ETA) * Complex(G2, D2))) *
             (Constant::inv_sqrt_pi - z2 * w2);
         B = (1 / ((1 - ETA) * Complex(G2, D2))) *
@@ -2517,8 +2836,7 @@ class HartmannTran {
              2 * Constant::sqrt_pi * z1 * w1);
         break;
       case CalcType::LowYandHighX:
-        z1 = sqrtxy;
-        w1 = Faddeeva::w(Complex(0, 1) * z1);
+        w1 = w[0];
         A = (1 / ((1 - ETA) * Complex(G2, D2))) *
             (1 / x - 3 / Constant::pow2(x) / 2);
         B = (1 / ((1 - ETA) * Complex(G2, D2))) *
@@ -3102,10 +3420,41 @@ class SpeedDependentHardCollisionVoigt {
 
   double F0() const noexcept { return mF0; }
 
+  /** Most Faddeeva function evaluations per frequency */
+  static constexpr std::size_t nw = 2;
+
+  /** The frequency dependent part of the line shape */
+  struct State {
+    Complex dx;
+    Complex x;
+    Sq sq;
+    CalcType calcs;
+    std::size_t n;  // Number of Faddeeva function arguments
+  };
+
+  /** Writes the arguments of the Faddeeva function at f to w, returns s.n */
+  std::size_t w_args(double f, Complex *w, State &s) noexcept {
+    at(f);
+    s.n = args(w);
+    s.dx = dx;
+    s.x = x;
+    s.sq = sq;
+    s.calcs = calcs;
+    return s.n;
+  }
+
+  /** As operator()(f) with the s.n values of w at the arguments of w_args */
+  Complex &operator()(const State &s, const Complex *w) noexcept {
+    dx = s.dx;
+    x = s.x;
+    sq = s.sq;
+    calcs = s.calcs;
+    calc(w);
+    return F;
+  }
+
   Complex &operator()(double f) noexcept {
-    reinterpret_cast<double(&)[2]>(dx)[1] = mF0 - f;
-    x = dx * invc2;
-    update_calcs();
+    at(f);
     calc();
     return F;
   }
@@ -3129,35 +3478,72 @@ class SpeedDependentHardCollisionVoigt {
     if (calcs not_eq CalcType::Voigt) calcs = init(Complex(1, 1));
   }
 
-  void calc() noexcept {
+  void at(double f) noexcept {
+    reinterpret_cast<double(&)[2]>(dx)[1] = mF0 - f;
+    x = dx * invc2;
+    update_calcs();
+  }
+
+  /** The arguments of w for the current calculation, returns how many */
+  std::size_t args(Complex *z) noexcept {
     switch (calcs) {
       case CalcType::Full:
         sq.xy = std::sqrt(x + sqrty * sqrty);
-        w1 = Faddeeva::w(Complex(0, 1) * (sq.xy - sqrty));
-        w2 = Faddeeva::w(Complex(0, 1) * (sq.xy + sqrty));
+        z[0] = Complex(0, 1) * (sq.xy - sqrty);
+        z[1] = Complex(0, 1) * (sq.xy + sqrty);
+        return 2;
+      case CalcType::Voigt:
+        z[0] = Complex(0, 1) * dx * invGD;
+        return 1;
+      case CalcType::LowXandHighY:
+        sq.xy = std::sqrt(x + sqrty * sqrty);
+        z[0] = Complex(0, 1) * dx * invGD;
+        z[1] = Complex(0, 1) * (sq.xy + sqrty);
+        return 2;
+      case CalcType::LowYandLowX:
+        sq.x = std::sqrt(x);
+        z[0] = Complex(0, 1) * sq.x;
+        return 1;
+      case CalcType::LowYandHighX:
+        return 0;
+    }
+    return 0;
+  }
+
+  void calc() noexcept {
+    Complex w[nw];
+    const std::size_t n = args(w);
+    for (std::size_t i = 0; i < n; i++) w[i] = Faddeeva::w(w[i]);
+    calc(w);
+  }
+
+  /** Computes the line shape from w of args() */
+  void calc(const Complex *w) noexcept {
+    switch (calcs) {
+      case CalcType::Full:
+        w1 = w[0];
+        w2 = w[1];
         A = Constant::sqrt_pi * invGD * (w1 - w2);
         F = Constant::inv_pi * A / (1 - FVC * A);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - (sq.xy - sqrty) * w1);
         dw2 = Complex(0, 2) * (Constant::inv_sqrt_pi - (sq.xy + sqrty) * w2);
         break;
       case CalcType::Voigt:
-        w1 = Faddeeva::w(Complex(0, 1) * dx * invGD);
+        w1 = w[0];
         A = Constant::sqrt_pi * invGD * w1;
         F = Constant::inv_pi * A / (1 - FVC * A);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - dx * invGD * w1);
         break;
       case CalcType::LowXandHighY:
-        sq.xy = std::sqrt(x + sqrty * sqrty);
-        w1 = Faddeeva::w(Complex(0, 1) * dx * invGD);
-        w2 = Faddeeva::w(Complex(0, 1) * (sq.xy + sqrty));
+        w1 = w[0];
+        w2 = w[1];
         A = Constant::sqrt_pi * invGD * (w1 - w2);
         F = Constant::inv_pi * A / (1 - FVC * A);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - dx * invGD * w1);
         dw2 = Complex(0, 2) * (Constant::inv_sqrt_pi - (sq.xy + sqrty) * w2);
         break;
       case CalcType::LowYandLowX:
-        sq.x = std::sqrt(x);
-        w1 = Faddeeva::w(Complex(0, 1) * sq.x);
+        w1 = w[0];
         A = 2 * invc2 * (1 - Constant::sqrt_pi * sq.x * w1);
         F = Constant::inv_pi * A / (1 - FVC * A);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - sq.x * w1);
@@ -3636,10 +4022,41 @@ class SpeedDependentVoigt {
 
   double F0() const noexcept { return mF0; }
 
+  /** Most Faddeeva function evaluations per frequency */
+  static constexpr std::size_t nw = 2;
+
+  /** The frequency dependent part of the line shape */
+  struct State {
+    Complex dx;
+    Complex x;
+    Sq sq;
+    CalcType calcs;
+    std::size_t n;  // Number of Faddeeva function arguments
+  };
+
+  /** Writes the arguments of the Faddeeva function at f to w, returns s.n */
+  std::size_t w_args(double f, Complex *w, State &s) noexcept {
+    at(f);
+    s.n = args(w);
+    s.dx = dx;
+    s.x = x;
+    s.sq = sq;
+    s.calcs = calcs;
+    return s.n;
+  }
+
+  /** As operator()(f) with the s.n values of w at the arguments of w_args */
+  Complex &operator()(const State &s, const Complex *w) noexcept {
+    dx = s.dx;
+    x = s.x;
+    sq = s.sq;
+    calcs = s.calcs;
+    calc(w);
+    return F;
+  }
+
   Complex &operator()(double f) noexcept {
-    reinterpret_cast<double(&)[2]>(dx)[1] = mF0 - f;
-    x = dx * invc2;
-    update_calcs();
+    at(f);
     calc();
     return F;
   }
@@ -3663,32 +4080,69 @@ class SpeedDependentVoigt {
     if (calcs not_eq CalcType::Voigt) calcs = init(Complex(1, 1));
   }
 
-  void calc() noexcept {
+  void at(double f) noexcept {
+    reinterpret_cast<double(&)[2]>(dx)[1] = mF0 - f;
+    x = dx * invc2;
+    update_calcs();
+  }
+
+  /** The arguments of w for the current calculation, returns how many */
+  std::size_t args(Complex *z) noexcept {
     switch (calcs) {
       case CalcType::Full:
         sq.xy = std::sqrt(x + sqrty * sqrty);
-        w1 = Faddeeva::w(Complex(0, 1) * (sq.xy - sqrty));
-        w2 = Faddeeva::w(Complex(0, 1) * (sq.xy + sqrty));
+        z[0] = Complex(0, 1) * (sq.xy - sqrty);
+        z[1] = Complex(0, 1) * (sq.xy + sqrty);
+        return 2;
+      case CalcType::Voigt:
+        z[0] = Complex(0, 1) * dx * invGD;
+        return 1;
+      case CalcType::LowXandHighY:
+        sq.xy = std::sqrt(x + sqrty * sqrty);
+        z[0] = Complex(0, 1) * dx * invGD;
+        z[1] = Complex(0, 1) * (sq.xy + sqrty);
+        return 2;
+      case CalcType::LowYandLowX:
+        sq.x = std::sqrt(x);
+        z[0] = Complex(0, 1) * sq.x;
+        return 1;
+      case CalcType::LowYandHighX:
+        return 0;
+    }
+    return 0;
+  }
+
+  void calc() noexcept {
+    Complex w[nw];
+    const std::size_t n = args(w);
+    for (std::size_t i = 0; i < n; i++) w[i] = Faddeeva::w(w[i]);
+    calc(w);
+  }
+
+  /** Computes the line shape from w of args() */
+  void calc(const Complex *w) noexcept {
+    switch (calcs) {
+      case CalcType::Full:
+        w1 = w[0];
+        w2 = w[1];
         F = Constant::inv_sqrt_pi * invGD * (w1 - w2);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - (sq.xy - sqrty) * w1);
         dw2 = Complex(0, 2) * (Constant::inv_sqrt_pi - (sq.xy + sqrty) * w2);
         break;
       case CalcType::Voigt:
-        w1 = Faddeeva::w(Complex(0, 1) * dx * invGD);
+        w1 = w[0];
         F = Constant::inv_sqrt_pi * invGD * w1;
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - dx * invGD * w1);
         break;
       case CalcType::LowXandHighY:
-        sq.xy = std::sqrt(x + sqrty * sqrty);
-        w1 = Faddeeva::w(Complex(0, 1) * dx * invGD);
-        w2 = Faddeeva::w(Complex(0, 1) * (sq.xy + sqrty));
+        w1 = w[0];
+        w2 = w[1];
         F = Constant::inv_sqrt_pi * invGD * (w1 - w2);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - dx * invGD * w1);
         dw2 = Complex(0, 2) * (Constant::inv_sqrt_pi - (sq.xy + sqrty) * w2);
         break;
       case CalcType::LowYandLowX:
-        sq.x = std::sqrt(x);
-        w1 = Faddeeva::w(Complex(0, 1) * sq.x);
+        w1 = w[0];
         F = 2 * Constant::inv_pi * invc2 * (1 - Constant::sqrt_pi * sq.x * w1);
         dw1 = Complex(0, 2) * (Constant::inv_sqrt_pi - sq.x * w1);
         break;
@@ -3744,12 +4198,37 @@ class Voigt {
 
   double F0() const noexcept { return mF0; }
 
-  Complex &operator()(double f) noexcept {
+  /** Most Faddeeva function evaluations per frequency */
+  static constexpr std::size_t nw = 1;
+
+  /** The frequency dependent part of the line shape */
+  struct State {
+    Complex z;
+    static constexpr std::size_t n = 1;
+  };
+
+  /** Writes the argument of the Faddeeva function at f to w, returns s.n */
+  std::size_t w_args(double f, Complex *w, State &s) noexcept {
     reinterpret_cast<double(&)[2]>(z)[0] = invGD * (f - mF0);
-    F = Constant::inv_sqrt_pi * invGD * Faddeeva::w(z);
+    w[0] = s.z = z;
+    return s.n;
+  }
+
+  /** As operator()(f) with w[0] at the argument of w_args */
+  Complex &operator()(const State &s, const Complex *w) noexcept {
+    z = s.z;
+    F = Constant::inv_sqrt_pi * invGD * w[0];
     dF = 2 * invGD * (Complex(0, Constant::inv_pi * invGD) - z * F);
     return F;
   }
+
+  Complex &operator()(double f) noexcept {
+    State s;
+    Complex w;
+    w_args(f, &w, s);
+    w = Faddeeva::w(w);
+    return operator()(s, &w);
+  }
 };  // Voigt
 
 class Lorentz {
@@ -3795,6 +4274,9 @@ class Lorentz {
 
   constexpr double F0() const noexcept { return mF0; }
 
+  /** Number of Faddeeva function evaluations per frequency */
+  static constexpr std::size_t nw = 0;
+
   Complex &operator()(double f) noexcept {
     reinterpret_cast<double(&)[2]>(z)[1] = Constant::pi * (mF0 - f);
     F = 1.0 / z;
@@ -3841,6 +4323,9 @@ class Doppler {
 
   double F0() const noexcept { return mF0; }
 
+  /** Number of Faddeeva function evaluations per frequency */
+  static constexpr std::size_t nw = 0;
+
   double &operator()(double f) noexcept {
     x = (f - mF0) * invGD;
     F = invGD * Constant::inv_sqrt_pi * std::exp(-Constant::pow2(x));
@@ -1,6 +1,7 @@
 #ifndef mathhelpers_h
 #define mathhelpers_h
 
+#include <algorithm>
 #include <array>
 #include <numeric>
 #include <ostream>
@@ -110,4 +111,46 @@ class LinearInterpPoint {
   constexpr std::size_t index() const noexcept { return i; }
 };
 
+namespace Interp {
+/** Position of the first element of x for which before is false
+ *
+ * x must be partitioned by before, as a sorted grid is by being before a
+ * value.  Steps that double from hint bracket the position before bisecting,
+ * so a position d elements from hint takes O(log d) comparisons
+ *
+ * @param[in] x A grid
+ * @param[in] hint A guess of the position, clamped to x
+ * @param[in] before Whether an element of x comes before the position
+ * @return Position in [0, x.size()]
+ */
+template <typename T, typename Before>
+std::size_t gallop(const std::vector<T>& x, std::size_t hint,
+                   Before before) noexcept {
+  const std::size_t n = x.size();
+  if (n == 0) return 0;
+  hint = std::min(hint, n - 1);
+
+  // The position is in [lo, hi]
+  std::size_t lo, hi;
+  if (before(x[hint])) {
+    lo = hint + 1;
+    hi = lo;
+    for (std::size_t step = 1; hi < n and before(x[hi]); step *= 2) {
+      lo = hi + 1;
+      hi = std::min(n, lo + step);
+    }
+  } else {
+    hi = hint;
+    lo = hi;
+    for (std::size_t step = 1; lo > 0 and not before(x[lo - 1]); step *= 2) {
+      hi = lo - 1;
+      lo = hi > step ? hi - step : 0;
+    }
+  }
+  return std::size_t(std::partition_point(x.cbegin() + lo, x.cbegin() + hi,
+                                          before) -
+                     x.cbegin());
+}
+}  // namespace Interp
+
 #endif  // mathhelpers_h
@@ -1 +1,75 @@
 #include "multithread.h"
+
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace Multithread {
+namespace {
+std::mutex mtx;
+bool started = false;
+std::array<int, long(Arena::FINAL)> threads{1, 0, 1};
+
+// Only created when first used so that Configure can come first
+std::array<tbb::task_arena, long(Arena::FINAL)> &arenas() {
+  // TBB otherwise limits its workers to the number of cores minus one
+  static tbb::global_control limit(
+      tbb::global_control::max_allowed_parallelism,
+      Concurrency(Arena::Acquisition) + Concurrency(Arena::Compute) +
+          Concurrency(Arena::Background) + 1);
+  static std::array<tbb::task_arena, long(Arena::FINAL)> out{
+      tbb::task_arena(Concurrency(Arena::Acquisition), 0,
+                      tbb::task_arena::priority::high),
+      tbb::task_arena(Concurrency(Arena::Compute), 0,
+                      tbb::task_arena::priority::normal),
+      tbb::task_arena(Concurrency(Arena::Background), 0,
+                      tbb::task_arena::priority::low)};
+  return out;
+}
+}  // namespace
+
+void Configure(int acquisition, int compute, int background) {
+  std::lock_guard lock{mtx};
+  if (started) {
+    std::ostringstream os;
+    os << "Cannot configure the executor after it has been used\n";
+    throw std::runtime_error(os.str());
+  }
+  if (acquisition < 1 or compute < 0 or background < 1) {
+    std::ostringstream os;
+    os << "Bad executor configuration, need at least one acquisition ("
+       << acquisition << ") and one background (" << background
+       << ") thread and a non-negative number of compute (" << compute
+       << ") threads\n";
+    throw std::runtime_error(os.str());
+  }
+  threads = {acquisition, compute, background};
+}
+
+int Concurrency(Arena a) {
+  std::lock_guard lock{mtx};
+  if (a == Arena::Compute and threads[long(a)] == 0)
+    return std::max(int(std::thread::hardware_concurrency()) -
+                        threads[long(Arena::Acquisition)],
+                    1);
+  return threads[long(a)];
+}
+
+tbb::task_arena &GetArena(Arena a) {
+  if (not good_enum(a)) {
+    std::ostringstream os;
+    os << "Bad arena: " << long(a) << '\n';
+    throw std::runtime_error(os.str());
+  }
+
+  {
+    std::lock_guard lock{mtx};
+    started = true;
+  }
+  return arenas()[long(a)];
+}
+}  // namespace Multithread
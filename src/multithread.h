@@ -1,7 +1,26 @@
 #ifndef multithread_h
 #define multithread_h
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
+#include <atomic>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "enums.h"
+
+/* The Async functions start a new thread for work that lives as long as the
+ * program, like the instrument loops.  Any finite work should instead go to
+ * the executor below so that all of it shares a fixed set of threads
+ */
 
 template <class Function, class... Args>
 auto AsyncConstRef(Function &&f, const Args &... args) {
@@ -18,4 +37,201 @@ auto Async(Function &&f, Args... args) {
   return std::async(std::launch::async, f, args...);
 }
 
+namespace Multithread {
+/** The separate groups of threads of the executor
+ *
+ * Acquisition work runs at high priority on its own threads, Compute gets
+ * the remaining cores and Background (saving, reading, etc.) runs at low
+ * priority on its own threads
+ */
+ENUMCLASS(Arena, char, Acquisition, Compute, Background)
+
+/** Sets the number of threads of each arena
+ *
+ * Must be called before the first use of the executor, it throws otherwise.
+ * A compute count of 0 means all cores not used for acquisition
+ *
+ * @param[in] acquisition Threads for acquisition-critical work
+ * @param[in] compute Threads for computations
+ * @param[in] background Threads for background I/O
+ */
+void Configure(int acquisition, int compute, int background);
+
+/** The number of threads of an arena */
+int Concurrency(Arena a);
+
+/** The arena itself, created on first use */
+tbb::task_arena &GetArena(Arena a);
+
+/** Error stored in the future of cancelled work */
+struct Cancelled : std::runtime_error {
+  Cancelled() : std::runtime_error("Work was cancelled before it finished") {}
+};
+
+/** Shared cancellation state of a single piece of submitted work */
+struct CancelState {
+  std::atomic<bool> cancelled{false};
+  tbb::task_group_context context;
+};
+
+/** The result of work given to the executor
+ *
+ * Works like a std::future but can also cancel the work.  Cancelled work that
+ * has not started never starts, and parallel loops stop as soon as possible.
+ * Either way get() then throws Cancelled
+ */
+template <class T>
+class Future {
+  std::future<T> fut;
+  std::shared_ptr<CancelState> state;
+
+ public:
+  Future(std::future<T> &&f, std::shared_ptr<CancelState> s) noexcept
+      : fut(std::move(f)), state(std::move(s)) {}
+
+  void cancel() noexcept {
+    state->cancelled = true;
+    state->context.cancel_group_execution();
+  }
+  bool cancelled() const noexcept { return state->cancelled.load(); }
+
+  bool valid() const noexcept { return fut.valid(); }
+  bool ready() const {
+    return fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }
+  void wait() const { fut.wait(); }
+  T get() { return fut.get(); }
+};  // Future
+
+/** Runs f() in the arena and returns its future result */
+template <class Function>
+auto submit(Arena a, Function &&f) {
+  using T = std::invoke_result_t<std::decay_t<Function>>;
+  auto state = std::make_shared<CancelState>();
+  auto task = std::make_shared<std::packaged_task<T()>>(
+      [state, f = std::forward<Function>(f)]() mutable -> T {
+        if (state->cancelled) throw Cancelled{};
+        return f();
+      });
+
+  Future<T> out(task->get_future(), state);
+  GetArena(a).enqueue([task] { (*task)(); });
+  return out;
+}
+
+/** Runs f(i) for all i in [first, last) in the arena
+ *
+ * The range is split in chunks of at least grain indices
+ */
+template <class Function>
+Future<void> parallel_for(Arena a, std::size_t first, std::size_t last,
+                          Function &&f, std::size_t grain = 1) {
+  auto state = std::make_shared<CancelState>();
+  auto task = std::make_shared<std::packaged_task<void()>>(
+      [state, first, last, grain, f = std::forward<Function>(f)]() {
+        if (state->cancelled) throw Cancelled{};
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(first, last, grain),
+            [&f](const tbb::blocked_range<std::size_t> &r) {
+              for (std::size_t i = r.begin(); i not_eq r.end(); ++i) f(i);
+            },
+            state->context);
+        if (state->context.is_group_execution_cancelled()) throw Cancelled{};
+      });
+
+  Future<void> out(task->get_future(), state);
+  GetArena(a).enqueue([task] { (*task)(); });
+  return out;
+}
+
+/** Reduces map(i) for all i in [first, last) with reduce in the arena
+ *
+ * The split of the range only depends on the range and grain, so the order
+ * of the reduction, and thus the floating point result, is the same for any
+ * number of threads
+ *
+ * @param[in] identity The value that does not change the result of reduce
+ * @param[in] map Function of the index returning a T
+ * @param[in] reduce Associative function of two T returning a T
+ */
+template <class T, class Map, class Reduce>
+Future<T> parallel_reduce(Arena a, std::size_t first, std::size_t last,
+                          T identity, Map &&map, Reduce &&reduce,
+                          std::size_t grain = 1) {
+  auto state = std::make_shared<CancelState>();
+  auto task = std::make_shared<std::packaged_task<T()>>(
+      [state, first, last, grain, identity, map = std::forward<Map>(map),
+       reduce = std::forward<Reduce>(reduce)]() -> T {
+        if (state->cancelled) throw Cancelled{};
+        T out = tbb::parallel_deterministic_reduce(
+            tbb::blocked_range<std::size_t>(first, last, grain), identity,
+            [&map, &reduce](const tbb::blocked_range<std::size_t> &r, T x) {
+              for (std::size_t i = r.begin(); i not_eq r.end(); ++i)
+                x = reduce(x, map(i));
+              return x;
+            },
+            reduce, state->context);
+        if (state->context.is_group_execution_cancelled()) throw Cancelled{};
+        return out;
+      });
+
+  Future<T> out(task->get_future(), state);
+  GetArena(a).enqueue([task] { (*task)(); });
+  return out;
+}
+
+/** Objects that are taken and given back rather than created each time
+ *
+ * For the scratch space of the bodies of a reduction: bodies alive at the same
+ * time get different objects, and the objects are kept for the next reduction.
+ * A thread waiting for a nested reduction may run another body, so per-thread
+ * storage is not enough
+ */
+template <class T>
+class Pool {
+  std::mutex mtx;
+  std::vector<std::unique_ptr<T>> free;
+
+ public:
+  /** A free object, or a new one if there is none */
+  std::unique_ptr<T> take() {
+    {
+      std::lock_guard lock{mtx};
+      if (not free.empty()) {
+        auto out = std::move(free.back());
+        free.pop_back();
+        return out;
+      }
+    }
+    return std::make_unique<T>();
+  }
+
+  /** Gives back an object from take() */
+  void give(std::unique_ptr<T> x) {
+    if (not x) return;
+    std::lock_guard lock{mtx};
+    free.push_back(std::move(x));
+  }
+};
+
+/** Reduces [first, last) into body in the arena and waits for it
+ *
+ * For work that is itself part of a computation, so it blocks instead of
+ * returning a Future.  Body is a TBB reduction body: it sums a range with
+ * operator()(const tbb::blocked_range<std::size_t> &), has a splitting
+ * constructor Body(Body &, tbb::split) giving an empty sum, and adds another
+ * body with join(const Body &).  As for parallel_reduce, the split only
+ * depends on the range and grain so the result is the same for any number of
+ * threads
+ */
+template <class Body>
+void deterministic_reduce(Arena a, std::size_t first, std::size_t last,
+                          Body &body, std::size_t grain = 1) {
+  GetArena(a).execute([&] {
+    tbb::parallel_deterministic_reduce(
+        tbb::blocked_range<std::size_t>(first, last, grain), body);
+  });
+}
+}  // namespace Multithread
+
 #endif  // multithread_h
@@ -90,6 +90,10 @@ class Number {
   }
 
   constexpr Rational rat() const noexcept { return value; }
+
+  constexpr bool isText() const noexcept { return istext; }
+
+  constexpr std::array<char, N> chars() const noexcept { return text; }
 };  // Number
 }  // namespace Quantum
 
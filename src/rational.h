@@ -9,7 +9,7 @@
 
 constexpr int gcd(int a, int b) {
   if (b == 0)
-    return a;
+    return a < 0 ? -a : a;
   else
     return gcd(b, a % b);
 }
@@ -21,7 +21,8 @@ class Rational {
 
  public:
   constexpr Rational(int n = 0, int d = 1)
-      : mn(d ? n / gcd(n, d) : 0), md(d ? d / gcd(n, d) : 0) {}
+      : mn(d ? (d < 0 ? -n : n) / gcd(n, d) : 0),
+        md(d ? (d < 0 ? -d : d) / gcd(n, d) : 0) {}
 
   Rational(const std::string &s);
 
@@ -73,7 +74,7 @@ class Rational {
   }
 
   friend constexpr Rational operator*(int one, Rational two) {
-    return Rational(one * two.d(), two.d());
+    return Rational(one * two.n(), two.d());
   }
 
   friend constexpr Rational operator*(Rational one, int two) {
@@ -0,0 +1,105 @@
+#include "replay.h"
+
+#include "file.h"
+
+namespace Instrument {
+namespace Replay {
+std::vector<double> comma_separated(const std::string &x) {
+  std::vector<double> out;
+  std::istringstream is(x);
+  for (std::string y; std::getline(is, y, ',');) out.push_back(std::stod(y));
+  return out;
+}
+
+Recording::Recording(const std::filesystem::path &path) {
+  File::File<File::Operation::ReadBinary, File::Type::Xml> file(path.string());
+
+  if (auto time = file.get_child("Time");
+      time.attribute("Version").as_llong() not_eq Time::Version()) {
+    std::ostringstream os;
+    os << "Recording " << path << " has time version "
+       << time.attribute("Version").as_llong() << ", can only replay version "
+       << Time::Version() << '\n';
+    throw std::runtime_error(os.str());
+  }
+  file.leave_child();
+
+  auto hk = file.get_child("Housekeeping");
+  for (size_t i = 0; i < hk.attribute("size").as_ullong(); i++)
+    hk_keys.push_back(
+        hk.attribute((std::string{"Data"} + std::to_string(i)).c_str())
+            .as_string());
+  file.leave_child();
+
+  auto fe = file.get_child("Frontend");
+  for (size_t i = 0; i < fe.attribute("size").as_ullong(); i++)
+    frontend_keys.push_back(
+        fe.attribute((std::string{"Data"} + std::to_string(i)).c_str())
+            .as_string());
+  file.leave_child();
+
+  auto be = file.get_child("Backends");
+  for (size_t i = 0; i < be.attribute("NumberOfBackends").as_ullong(); i++) {
+    auto spec = be.child((std::string{"Data"} + std::to_string(i)).c_str());
+    backend_names.push_back(spec.attribute("Name").as_string());
+    backend_shapes.push_back({spec.attribute("NumberOfBoards").as_ullong(),
+                              spec.attribute("ChannelsPerBoard").as_ullong()});
+
+    const auto &shape = backend_shapes.back();
+    const auto fstart =
+        comma_separated(spec.attribute("FrequencyStart").as_string());
+    const auto fend =
+        comma_separated(spec.attribute("FrequencyEnd").as_string());
+    std::vector<FrequencyGrid::Ptr> grids;
+    for (size_t j = 0; j < shape.first; j++) {
+      const std::string name = std::string{"Frequency"} + std::to_string(j);
+      if (auto irregular = spec.attribute(name.c_str()))
+        grids.push_back(
+            FrequencyGrid::Irregular(comma_separated(irregular.as_string())));
+      else if (j < fstart.size() and j < fend.size())
+        grids.push_back(
+            FrequencyGrid::Linear(fstart[j], fend[j], shape.second));
+      else
+        grids.push_back(FrequencyGrid::Linear(0, 1e9, shape.second));
+    }
+    backend_grids.push_back(grids);
+  }
+  file.leave_child();
+
+  // A record is [Time, int, double..., double..., float...]
+  size_t record_size = sizeof(Time) + sizeof(int) +
+                       sizeof(double) * (hk_keys.size() + frontend_keys.size());
+  for (auto &shape : backend_shapes)
+    record_size += sizeof(float) * shape.first * shape.second;
+
+  // An incomplete last record is from a measurement that was cut short
+  const std::filesystem::path binpath{path.string() + std::string{".bin"}};
+  const size_t n = std::filesystem::file_size(binpath) / record_size;
+  if (n == 0) {
+    std::ostringstream os;
+    os << "Recording " << path << " has no complete records\n";
+    throw std::runtime_error(os.str());
+  }
+
+  records.resize(n);
+  for (auto &rec : records) {
+    int chopper;
+    file.read(rec.time);
+    file.read(chopper);
+    rec.chopper = Chopper::ChopperPos(chopper);
+
+    rec.hk.resize(hk_keys.size());
+    rec.frontend.resize(frontend_keys.size());
+    file.read(rec.hk);
+    file.read(rec.frontend);
+
+    rec.backends.resize(backend_shapes.size());
+    for (size_t i = 0; i < backend_shapes.size(); i++) {
+      rec.backends[i].resize(backend_shapes[i].first,
+                             std::vector<float>(backend_shapes[i].second));
+      for (auto &board : rec.backends[i]) file.read(board);
+    }
+  }
+}
+}  // namespace Replay
+}  // namespace Instrument
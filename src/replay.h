@@ -0,0 +1,278 @@
+#ifndef replay_h
+#define replay_h
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chopper.h"
+#include "frequency_grid.h"
+#include "frontend.h"
+#include "timeclass.h"
+
+namespace Instrument {
+namespace Replay {
+/** A single record as written by DataSaver::save */
+struct Record {
+  Time time;
+  Chopper::ChopperPos chopper;
+  std::vector<double> hk;
+  std::vector<double> frontend;
+  std::vector<std::vector<std::vector<float>>> backends;
+};  // Record
+
+/** How fast a recording is replayed */
+enum class Cadence {
+  Recorded,  // Sleep so records come at the times they were recorded
+  Fast       // Emit records as fast as they are asked for
+};
+
+/** All records of a DataSaver file held in memory
+ *
+ * The records are read when constructed so that a replay does not measure
+ * the reading of the file
+ */
+class Recording {
+  std::vector<std::string> hk_keys;
+  std::vector<std::string> frontend_keys;
+  std::vector<std::string> backend_names;
+  std::vector<std::pair<size_t, size_t>> backend_shapes;
+  std::vector<std::vector<FrequencyGrid::Ptr>> backend_grids;
+  std::vector<Record> records;
+
+ public:
+  /** Reads a recording
+   *
+   * @param[in] path The metadata file of DataSaver, the records are read from
+   * the binary file next to it
+   */
+  Recording(const std::filesystem::path &path);
+
+  size_t size() const noexcept { return records.size(); }
+  const Record &operator[](size_t i) const noexcept { return records[i]; }
+
+  const std::vector<std::string> &housekeeping_keys() const noexcept {
+    return hk_keys;
+  }
+  const std::vector<std::string> &frontend_names() const noexcept {
+    return frontend_keys;
+  }
+  size_t number_of_backends() const noexcept { return backend_names.size(); }
+  const std::string &backend_name(size_t i) const noexcept {
+    return backend_names[i];
+  }
+
+  /** Number of boards and channels per board of a backend */
+  const std::pair<size_t, size_t> &backend_shape(size_t i) const noexcept {
+    return backend_shapes[i];
+  }
+
+  /** Frequency grids of the boards of a backend
+   *
+   * Recordings from before the grids were saved get 0 to 1 GHz grids
+   */
+  const std::vector<FrequencyGrid::Ptr> &backend_grid(size_t i) const noexcept {
+    return backend_grids[i];
+  }
+};  // Recording
+
+/** Position of a device in the recording
+ *
+ * Every run() of a device moves it to the next record, restarting at the
+ * beginning after the last record
+ */
+class Cursor {
+  std::shared_ptr<const Recording> rec;
+  size_t pos;
+
+ public:
+  Cursor(std::shared_ptr<const Recording> recording) noexcept
+      : rec(std::move(recording)), pos(rec->size() - 1) {}
+
+  size_t next() noexcept {
+    pos = (pos + 1) % rec->size();
+    return pos;
+  }
+  const Record &record() const noexcept { return (*rec)[pos]; }
+  const Recording &recording() const noexcept { return *rec; }
+};  // Cursor
+}  // namespace Replay
+
+namespace Chopper {
+/** Replays the recorded chopper positions
+ *
+ * The chopper is the first device to run in a cycle so it keeps the cadence
+ * of the replay.  The target given to run is ignored in favor of the recorded
+ * position
+ */
+class Replay {
+  Instrument::Replay::Cursor cursor;
+  Instrument::Replay::Cadence cadence;
+  Time start;
+  bool manual;
+  bool error_found;
+  std::string error;
+
+ public:
+  using DataType = ChopperPos;
+  Replay(std::shared_ptr<const Instrument::Replay::Recording> recording,
+         Instrument::Replay::Cadence c)
+      : cursor(std::move(recording)),
+        cadence(c),
+        manual(false),
+        error_found(false),
+        error("") {}
+  void startup(const std::string &, int, double) {}
+  void init(bool manual_press) { manual = manual_press; }
+  void close() {}
+  void run(ChopperPos) {
+    if (cursor.next() == 0) start = Time();
+    if (cadence == Instrument::Replay::Cadence::Recorded)
+      Sleep(start + (cursor.record().time - cursor.recording()[0].time));
+  }
+  DataType get_data_raw() { return cursor.record().chopper; }
+  DataType get_data() { return cursor.record().chopper; }
+  bool manual_run() { return manual; }
+  const std::string &error_string() const { return error; }
+  bool has_error() { return error_found; }
+  void delete_error() {
+    error_found = false;
+    error = "";
+  }
+};  // Replay
+}  // namespace Chopper
+
+namespace Housekeeping {
+/** Replays the recorded housekeeping data */
+class Replay {
+  Instrument::Replay::Cursor cursor;
+  bool manual;
+  bool error_found;
+  std::map<std::string, double> database;
+  std::string error;
+
+ public:
+  using DataType = std::map<std::string, double>;
+  Replay(std::shared_ptr<const Instrument::Replay::Recording> recording)
+      : cursor(std::move(recording)),
+        manual(false),
+        error_found(false),
+        error("") {}
+  void startup(const std::string &, int) {}
+  void init(bool manual_press = false) { manual = manual_press; }
+  void run() { cursor.next(); }
+  void close() {}
+  bool manual_run() { return manual; }
+  const std::string &error_string() const { return error; }
+  bool has_error() { return error_found; }
+  void delete_error() {
+    error_found = false;
+    error = "";
+  }
+  void get_data() {
+    const auto &keys = cursor.recording().housekeeping_keys();
+    for (size_t i = 0; i < keys.size(); i++)
+      database[keys[i]] = cursor.record().hk[i];
+  }
+  DataType data() const { return database; }
+};  // Replay
+}  // namespace Housekeeping
+
+namespace Frontend {
+/** Replays the recorded frontend data */
+class Replay {
+  Instrument::Replay::Cursor cursor;
+  bool manual;
+  std::string mname;
+  std::map<std::string, double> database;
+  bool error_found;
+  std::string error;
+
+ public:
+  static constexpr bool has_cold_load = false;
+  static constexpr bool has_hot_load = false;
+  using DataType = std::map<std::string, double>;
+
+  Replay(std::shared_ptr<const Instrument::Replay::Recording> recording)
+      : cursor(std::move(recording)),
+        manual(false),
+        mname("FrontendReplay"),
+        error_found(false),
+        error("") {}
+  template <typename... Whatever>
+  void startup(Whatever...) {}
+  void init(bool manual_press) { manual = manual_press; }
+  void close() {}
+  void run() { cursor.next(); }
+  void get_data() {
+    const auto &keys = cursor.recording().frontend_names();
+    for (size_t i = 0; i < keys.size(); i++)
+      database[keys[i]] = cursor.record().frontend[i];
+  }
+  DataType data() const { return database; }
+  bool manual_run() { return manual; }
+  const std::string &error_string() const { return error; }
+  bool has_error() { return error_found; }
+  void delete_error() {
+    error_found = false;
+    error = "";
+  }
+  void gui_setup(Controller &) {
+    ImGui::Text("There is no setup, this is a replay class");
+  }
+  const std::string &name() const { return mname; }
+};  // Replay
+}  // namespace Frontend
+
+namespace Spectrometer {
+/** Replays the recorded data of one of the backends */
+class Replay {
+  Instrument::Replay::Cursor cursor;
+  size_t backend;
+  std::string mname;
+  bool manual;
+  bool error_found;
+  std::string error;
+  std::vector<std::vector<float>> data;
+
+ public:
+  Replay(std::shared_ptr<const Instrument::Replay::Recording> recording,
+         size_t i)
+      : cursor(std::move(recording)),
+        backend(i),
+        mname(cursor.recording().backend_name(i)),
+        manual(false),
+        error_found(false),
+        error(""),
+        data(cursor.recording().backend_shape(i).first,
+             std::vector<float>(cursor.recording().backend_shape(i).second)) {}
+
+  void startup(const std::string &, int, int, Eigen::Ref<Eigen::MatrixXd>,
+               Eigen::Ref<Eigen::VectorXi>, int, int, bool) {}
+  void init(bool manual_init) { manual = manual_init; }
+  void close() {}
+  void run() { cursor.next(); }
+  std::vector<std::vector<float>> datavec() { return data; }
+  std::string name() const { return mname; }
+
+  void get_data(int) {
+    const auto &rec = cursor.record().backends[backend];
+    for (size_t i = 0; i < data.size(); i++)
+      std::copy(rec[i].cbegin(), rec[i].cend(), data[i].begin());
+  }
+  bool manual_run() { return manual; }
+  const std::string &error_string() const { return error; }
+  bool has_error() { return error_found; }
+  void delete_error() {
+    error_found = false;
+    error = "";
+  }
+};  // Replay
+}  // namespace Spectrometer
+}  // namespace Instrument
+
+#endif  // replay_h
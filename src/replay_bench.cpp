@@ -0,0 +1,189 @@
+#include <chrono>
+#include <ctime>
+#include <utility>
+
+#include "allocations.h"
+#include "cli_parsing.h"
+#include "housekeeping.h"
+#include "instrument.h"
+#include "replay.h"
+
+Instrument::Spectrometer::Controller controller(
+    const Instrument::Replay::Recording &rec, size_t i) {
+  const auto &grids = rec.backend_grid(i);
+  Eigen::MatrixXd fl(grids.size(), 2);
+  Eigen::VectorXi fc(grids.size());
+  for (size_t j = 0; j < grids.size(); j++) {
+    fl(j, 0) = (*grids[j])[0];
+    fl(j, 1) = (*grids[j])[grids[j]->size() - 1];
+    fc[j] = int(grids[j]->size());
+  }
+  return Instrument::Spectrometer::Controller(rec.backend_name(i), "replay", 0,
+                                              0, fl, fc, 0, 0, false);
+}
+
+// What the GUI asks of the lines of a frame every time it is drawn
+double draw_frame(GUI::Plotting::Frame &frame) {
+  double sum = 0;
+  for (auto &line : frame) {
+    auto getter = line.getter();
+    for (int i = 0; i < line.size(); i++) {
+      const ImPlotPoint p = getter(static_cast<void *>(&line), i);
+      sum += p.x + p.y;
+    }
+  }
+  return sum;
+}
+
+template <size_t... I>
+void bench(std::shared_ptr<const Instrument::Replay::Recording> rec,
+           Instrument::Replay::Cadence cadence, size_t n,
+           const std::filesystem::path &savedir, size_t downsample,
+           std::index_sequence<I...>) {
+  constexpr size_t N = sizeof...(I);
+  constexpr size_t height_of_window = 7;
+  constexpr size_t part_for_plot = 6;
+
+  Instrument::Chopper::Replay chop{rec, cadence};
+  Instrument::Chopper::Controller<Instrument::Chopper::ChopperPos::Cold,
+                                  Instrument::Chopper::ChopperPos::Antenna,
+                                  Instrument::Chopper::ChopperPos::Hot,
+                                  Instrument::Chopper::ChopperPos::Antenna>
+      chopper_ctrl{"replay", 0, 0.0};
+
+  Instrument::Housekeeping::Replay hk{rec};
+  Instrument::Housekeeping::Controller housekeeping_ctrl{"replay", 0};
+
+  Instrument::Frontend::Replay frontend{rec};
+  Instrument::Frontend::Controller frontend_ctrl{"replay", 0};
+
+  Instrument::Spectrometer::Backends backends{
+      Instrument::Spectrometer::Replay(rec, I)...};
+  std::array<Instrument::Spectrometer::Controller, N> backend_ctrls{
+      controller(*rec, I)...};
+  std::array<Instrument::Data, N> backend_data;
+  std::array<GUI::Plotting::CAHA<height_of_window, part_for_plot>, N>
+      backend_frames{GUI::Plotting::CAHA<height_of_window, part_for_plot>{
+          backend_ctrls[I].name, backend_ctrls[I].f}...};
+
+  std::filesystem::create_directories(savedir);
+  Instrument::DataSaver datasaver((savedir / "").string(), "REPLAY",
+                                  downsample);
+  auto buf = Instrument::InitExchange(backend_ctrls, backend_data);
+
+  // The instrument loop logs every step, which is not what is measured here
+  std::cout.setstate(std::ios::badbit);
+
+  double plotsum = 0;
+  const size_t start_allocations = allocations;
+  const std::clock_t start_cpu = std::clock();
+  const auto start_wall = std::chrono::steady_clock::now();
+
+  for (size_t r = 0; r < n; r++) {
+    const size_t pos = r % chopper_ctrl.N;
+
+    // The device part of RunExperiment without the wobbler
+    chop.run(chopper_ctrl.pos[pos]);
+    frontend.run();
+    for (size_t i = 0; i < N; i++) backends.run(i);
+    hk.run();
+    for (size_t i = 0; i < N; i++) backends.get_data(i, pos);
+    hk.get_data();
+    frontend.get_data();
+    Instrument::StoreAll(chopper_ctrl, chop.get_data(), hk, housekeeping_ctrl,
+                         frontend, frontend_ctrl, backends, backend_ctrls);
+
+    // A single loop of ExchangeData
+    Instrument::ExchangeOnce(backend_ctrls, chopper_ctrl, housekeeping_ctrl,
+                             frontend_ctrl, backend_data, datasaver,
+                             backend_frames, buf);
+
+    // A single frame of the plots
+    for (auto &caha : backend_frames)
+      plotsum += draw_frame(caha.Raw()) + draw_frame(caha.Noise()) +
+                 draw_frame(caha.Integration()) + draw_frame(caha.Averaging());
+  }
+
+  const auto end_wall = std::chrono::steady_clock::now();
+  const std::clock_t end_cpu = std::clock();
+  const size_t end_allocations = allocations;
+
+  std::cout.clear();
+
+  const double wall =
+      std::chrono::duration_cast<TimeStep>(end_wall - start_wall).count();
+  const double cpu = double(end_cpu - start_cpu) / CLOCKS_PER_SEC;
+  std::cout << "Records:                " << n << '\n';
+  std::cout << "Backends:               " << N << '\n';
+  std::cout << "Wall time [s]:          " << wall << '\n';
+  std::cout << "Records/s:              " << double(n) / wall << '\n';
+  std::cout << "CPU per record [ms]:    " << 1e3 * cpu / double(n) << '\n';
+  std::cout << "Allocations per record: "
+            << double(end_allocations - start_allocations) / double(n) << '\n';
+  std::cout << "Plot checksum:          " << plotsum << '\n';
+}
+
+int main(int argc, char **argv) try {
+  CommandLine::App replay("Replay a DataSaver recording through the data "
+                          "handling of the instrument and time it");
+
+  std::string file;
+  replay.NewRequiredOption("-f,--file", file,
+                           "The recording (the .xml file of DataSaver)");
+  size_t n = 0;
+  replay.NewDefaultOption("-n,--records", n,
+                          "Number of records to replay, the recording is "
+                          "repeated as needed (0 replays it once)");
+  bool realtime = false;
+  replay.NewDefaultOption("--realtime", realtime,
+                          "Cadence of the replay\n\t0: As fast as possible\n\t"
+                          "1: At the recorded times");
+  std::string savedir =
+      (std::filesystem::temp_directory_path() / "replay_bench").string();
+  replay.NewDefaultOption("-o,--output", savedir,
+                          "Directory the replayed data is saved to");
+  size_t downsample = 0;
+  replay.NewDefaultOption("--downsample", downsample,
+                          "Spectral downsampling of the archive (0 stores no "
+                          "spectra)");
+
+  // Parse input options
+  replay.Parse(argc, argv);
+
+  const auto rec = std::make_shared<const Instrument::Replay::Recording>(file);
+  if (n == 0) n = rec->size();
+  const auto cadence = realtime ? Instrument::Replay::Cadence::Recorded
+                                : Instrument::Replay::Cadence::Fast;
+
+  switch (rec->number_of_backends()) {
+    case 1:
+      bench(rec, cadence, n, savedir, downsample,
+            std::make_index_sequence<1>{});
+      break;
+    case 2:
+      bench(rec, cadence, n, savedir, downsample,
+            std::make_index_sequence<2>{});
+      break;
+    case 3:
+      bench(rec, cadence, n, savedir, downsample,
+            std::make_index_sequence<3>{});
+      break;
+    case 4:
+      bench(rec, cadence, n, savedir, downsample,
+            std::make_index_sequence<4>{});
+      break;
+    default: {
+      std::ostringstream os;
+      os << "Can only replay 1 to 4 backends, the recording has "
+         << rec->number_of_backends() << '\n';
+      throw std::runtime_error(os.str());
+    }
+  }
+
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  std::ostringstream os;
+  os << "Terminated with errors:\n" << e.what() << '\n';
+  std::cerr << os.str();
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,108 @@
+#ifndef smallvector_h
+#define smallvector_h
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+/** A vector that keeps up to N elements inline and more on the heap
+ *
+ * Copies of up to N elements do not allocate, for small values that are made
+ * and copied often like the species of an atmospheric point
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+  std::size_t n;
+  std::array<T, N> local;
+  std::vector<T> heap;
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  SmallVector(size_type count = 0) : n(0) { resize(count); }
+
+  SmallVector(std::initializer_list<T> x) : n(0) { assign(x.begin(), x.end()); }
+
+  SmallVector(const std::vector<T> &x) : n(0) { assign(x.cbegin(), x.cend()); }
+
+  SmallVector(const SmallVector &x) : n(0) { assign(x.cbegin(), x.cend()); }
+
+  SmallVector &operator=(const SmallVector &x) {
+    if (this not_eq &x) assign(x.cbegin(), x.cend());
+    return *this;
+  }
+
+  /** Takes the heap buffer of x, so only inline elements are moved one by one
+   *
+   * x is left empty
+   */
+  SmallVector(SmallVector &&x) noexcept : n(x.n), heap(std::move(x.heap)) {
+    if (n <= N) std::move(x.local.begin(), x.local.begin() + n, local.begin());
+    x.n = 0;
+    x.heap.clear();
+  }
+
+  SmallVector &operator=(SmallVector &&x) noexcept {
+    if (this not_eq &x) {
+      heap = std::move(x.heap);
+      if (x.n <= N)
+        std::move(x.local.begin(), x.local.begin() + x.n, local.begin());
+      n = x.n;
+      x.n = 0;
+      x.heap.clear();
+    }
+    return *this;
+  }
+
+  template <typename Iter>
+  void assign(Iter first, Iter last) {
+    const auto m = size_type(std::distance(first, last));
+    if (m > N) {
+      heap.assign(first, last);
+    } else {
+      heap.clear();
+      std::copy(first, last, local.begin());
+    }
+    n = m;
+  }
+
+  /** Resizes to count elements, new elements value-initialized */
+  void resize(size_type count) {
+    if (count > N) {
+      if (n <= N) heap.assign(local.begin(), local.begin() + n);
+      heap.resize(count);
+    } else {
+      if (n > N) {
+        std::copy(heap.cbegin(), heap.cbegin() + count, local.begin());
+        heap.clear();
+      } else {
+        std::fill(local.begin() + std::min(n, count), local.begin() + count,
+                  T{});
+      }
+    }
+    n = count;
+  }
+
+  size_type size() const noexcept { return n; }
+  bool empty() const noexcept { return n == 0; }
+
+  T *data() noexcept { return n > N ? heap.data() : local.data(); }
+  const T *data() const noexcept { return n > N ? heap.data() : local.data(); }
+
+  T &operator[](size_type i) noexcept { return data()[i]; }
+  const T &operator[](size_type i) const noexcept { return data()[i]; }
+
+  iterator begin() noexcept { return data(); }
+  iterator end() noexcept { return data() + n; }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator end() const noexcept { return data() + n; }
+  const_iterator cbegin() const noexcept { return data(); }
+  const_iterator cend() const noexcept { return data() + n; }
+};  // SmallVector
+
+#endif  // smallvector_h
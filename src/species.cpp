@@ -1,6 +1,69 @@
 #include "species.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 namespace Species {
+namespace {
+/** Temperatures of the partition function tables [K] */
+constexpr double table_t0 = 1;
+constexpr double table_t1 = 3000;
+constexpr size_t table_size = size_t(table_t1 - table_t0);
+
+/** The cubic Q = c[0] + c[1] t + c[2] t^2 + c[3] t^3 of one 1 K step, with t
+ * the fraction of the step */
+struct alignas(32) PartitionCubic {
+  std::array<double, 4> c;
+};
+
+/** The steps of the table of each isotope, built once */
+struct PartitionTable {
+  std::once_flag built;
+  std::unique_ptr<PartitionCubic[]> steps;
+  std::atomic<const PartitionCubic *> ready{nullptr};
+};
+
+std::array<PartitionTable, getIsotopeCount()> partition_tables;
+
+/** The cubic Hermite polynomials of each step, from QT and dQT at its ends */
+const PartitionCubic *partition_steps(Isotope x, size_t index) {
+  auto &table = partition_tables[index];
+  std::call_once(table.built, [&table, x] {
+    table.steps = std::make_unique<PartitionCubic[]>(table_size);
+    double p0 = x.QT(table_t0), m0 = x.dQT(table_t0);
+    for (size_t i = 0; i < table_size; i++) {
+      const double T = table_t0 + double(i + 1);
+      const double p1 = x.QT(T), m1 = x.dQT(T);
+      table.steps[i].c = {p0, m0, 3 * (p1 - p0) - 2 * m0 - m1,
+                          2 * (p0 - p1) + m0 + m1};
+      p0 = p1;
+      m0 = m1;
+    }
+    table.ready.store(table.steps.get(), std::memory_order_release);
+  });
+  return table.steps.get();
+}
+}  // namespace
+
+PartitionValue Isotope::Partition(double T) const noexcept {
+  const size_t i = index();
+  if (i == getIsotopeCount() or not(T >= table_t0 and T < table_t1))
+    return {QT(T), dQT(T)};
+
+  const PartitionCubic *steps =
+      partition_tables[i].ready.load(std::memory_order_acquire);
+  if (not steps) steps = partition_steps(*this, i);
+
+  // T >= table_t0, so truncation is the floor
+  const double pos = T - table_t0;
+  const size_t k = size_t(pos);
+  const double t = pos - double(k);
+  const auto &c = steps[k].c;
+  return {c[0] + t * (c[1] + t * (c[2] + t * c[3])),
+          c[1] + t * (2 * c[2] + t * 3 * c[3])};
+}
+
 AtomInfo getAtomInfo(Atom x) noexcept {
   switch (x) {
     case Atom::H:
@@ -1,6 +1,8 @@
 #ifndef species_h
 #define species_h
 
+#include <limits>
+#include <utility>
 #include <vector>
 
 #include "enums.h"
@@ -272,6 +274,20 @@ constexpr unsigned char getIsotopologueCount(Species s) {
   return std::numeric_limits<unsigned char>::max();
 }
 
+/** Position of the first isotope of each species when all isotopes of all
+ * species are counted in order, with the total count last */
+constexpr std::array<size_t, size_t(Species::FINAL) + 1> isotope_offsets = [] {
+  std::array<size_t, size_t(Species::FINAL) + 1> out{};
+  for (size_t i = 0; i < size_t(Species::FINAL); i++)
+    out[i + 1] = out[i] + getIsotopologueCount(Species(i));
+  return out;
+}();
+
+/** Number of isotopes of all species */
+constexpr size_t getIsotopeCount() noexcept {
+  return isotope_offsets[size_t(Species::FINAL)];
+}
+
 /** Number of global quantum numbers considered for a species */
 constexpr unsigned char getGlobalQuantumNumberCount(Species s) {
   switch (s) {
@@ -2631,6 +2647,61 @@ class Isotopologue {
   }
 };
 
+/** Static data of an isotope, an entry of isotope_table */
+struct IsotopeData {
+  double mass;
+  double gi;
+  double (*QT)(double);
+  double (*dQT)(double);
+};
+
+namespace detail {
+template <Species S, unsigned char N, bool TemperatureDerivative>
+constexpr double partition_function(double T) noexcept {
+  return Isotopologue<S>().template QT<TemperatureDerivative>(T, N);
+}
+
+constexpr double no_partition_function(double) noexcept { return 0; }
+
+template <Species S, size_t... N>
+constexpr void fill_isotope_table(
+    std::array<IsotopeData, getIsotopeCount() + 1> &table,
+    std::index_sequence<N...>) noexcept {
+  constexpr Isotopologue<S> x{};
+  ((table[isotope_offsets[size_t(S)] + N] =
+        IsotopeData{x.Mass(N), double(x.G(N)),
+                    &partition_function<S, N, false>,
+                    &partition_function<S, N, true>}),
+   ...);
+}
+
+template <size_t... S>
+constexpr std::array<IsotopeData, getIsotopeCount() + 1> make_isotope_table(
+    std::index_sequence<S...>) noexcept {
+  std::array<IsotopeData, getIsotopeCount() + 1> out{};
+  (fill_isotope_table<Species(S)>(
+       out, std::make_index_sequence<getIsotopologueCount(Species(S))>{}),
+   ...);
+  out.back() = {std::numeric_limits<double>::quiet_NaN(),
+                std::numeric_limits<double>::quiet_NaN(),
+                &no_partition_function, &no_partition_function};
+  return out;
+}
+}  // namespace detail
+
+/** Static data of all isotopes of all species in the order of
+ * isotope_offsets, built at compile time from the Isotopologue records, with
+ * a last entry for unknown isotopes */
+constexpr std::array<IsotopeData, getIsotopeCount() + 1> isotope_table =
+    detail::make_isotope_table(
+        std::make_index_sequence<size_t(Species::FINAL)>{});
+
+/** The partition function and its temperature derivative at a temperature */
+struct PartitionValue {
+  double Q;
+  double dQdT;
+};
+
 class Isotope {
   Species s;
   unsigned char num;
@@ -2820,434 +2891,38 @@ class Isotope {
 
   constexpr Species Spec() const noexcept { return s; }
 
+  /** Number of the isotope among those of its species */
+  constexpr unsigned char Num() const noexcept { return num; }
+
+  /** Position of the isotope among all isotopes of all species, or
+   * getIsotopeCount() if it is not a known isotope */
+  constexpr size_t index() const noexcept {
+    const size_t i = size_t(s);
+    if (i >= size_t(Species::FINAL) or
+        num >= isotope_offsets[i + 1] - isotope_offsets[i])
+      return getIsotopeCount();
+    return isotope_offsets[i] + num;
+  }
+
+  /** Mass of the isotope, NaN if it is not a known isotope */
   constexpr double mass() const noexcept {
-    switch (s) {
-      case Species::Bath:
-        return std::numeric_limits<double>::quiet_NaN();
-      case Species::Water:
-        return Isotopologue<Species::Water>().Mass(long(num));
-      case Species::CarbonDioxide:
-        return Isotopologue<Species::CarbonDioxide>().Mass(long(num));
-      case Species::Ozone:
-        return Isotopologue<Species::Ozone>().Mass(long(num));
-      case Species::NitrogenOxide:
-        return Isotopologue<Species::NitrogenOxide>().Mass(long(num));
-      case Species::CarbonMonoxide:
-        return Isotopologue<Species::CarbonMonoxide>().Mass(long(num));
-      case Species::Methane:
-        return Isotopologue<Species::Methane>().Mass(long(num));
-      case Species::Oxygen:
-        return Isotopologue<Species::Oxygen>().Mass(long(num));
-      case Species::NitricOxide:
-        return Isotopologue<Species::NitricOxide>().Mass(long(num));
-      case Species::SulfurDioxide:
-        return Isotopologue<Species::SulfurDioxide>().Mass(long(num));
-      case Species::NitrogenDioxide:
-        return Isotopologue<Species::NitrogenDioxide>().Mass(long(num));
-      case Species::Ammonia:
-        return Isotopologue<Species::Ammonia>().Mass(long(num));
-      case Species::NitricAcid:
-        return Isotopologue<Species::NitricAcid>().Mass(long(num));
-      case Species::Hydroxyl:
-        return Isotopologue<Species::Hydroxyl>().Mass(long(num));
-      case Species::HydrogenFluoride:
-        return Isotopologue<Species::HydrogenFluoride>().Mass(long(num));
-      case Species::HydrogenChloride:
-        return Isotopologue<Species::HydrogenChloride>().Mass(long(num));
-      case Species::HydrogenBromide:
-        return Isotopologue<Species::HydrogenBromide>().Mass(long(num));
-      case Species::HydrogenIodide:
-        return Isotopologue<Species::HydrogenIodide>().Mass(long(num));
-      case Species::ChlorineMonoxide:
-        return Isotopologue<Species::ChlorineMonoxide>().Mass(long(num));
-      case Species::CarbonylSulfide:
-        return Isotopologue<Species::CarbonylSulfide>().Mass(long(num));
-      case Species::Formaldehyde:
-        return Isotopologue<Species::Formaldehyde>().Mass(long(num));
-      case Species::HypochlorousAcid:
-        return Isotopologue<Species::HypochlorousAcid>().Mass(long(num));
-      case Species::Nitrogen:
-        return Isotopologue<Species::Nitrogen>().Mass(long(num));
-      case Species::HydrogenCyanide:
-        return Isotopologue<Species::HydrogenCyanide>().Mass(long(num));
-      case Species::MethylChloride:
-        return Isotopologue<Species::MethylChloride>().Mass(long(num));
-      case Species::HydrogenPeroxide:
-        return Isotopologue<Species::HydrogenPeroxide>().Mass(long(num));
-      case Species::Acetylene:
-        return Isotopologue<Species::Acetylene>().Mass(long(num));
-      case Species::Ethane:
-        return Isotopologue<Species::Ethane>().Mass(long(num));
-      case Species::Phosphine:
-        return Isotopologue<Species::Phosphine>().Mass(long(num));
-      case Species::CarbonylFluoride:
-        return Isotopologue<Species::CarbonylFluoride>().Mass(long(num));
-      case Species::SulfurHexafluoride:
-        return Isotopologue<Species::SulfurHexafluoride>().Mass(long(num));
-      case Species::HydrogenSulfide:
-        return Isotopologue<Species::HydrogenSulfide>().Mass(long(num));
-      case Species::FormicAcid:
-        return Isotopologue<Species::FormicAcid>().Mass(long(num));
-      case Species::Hydroperoxyl:
-        return Isotopologue<Species::Hydroperoxyl>().Mass(long(num));
-      case Species::OxygenAtom:
-        return Isotopologue<Species::OxygenAtom>().Mass(long(num));
-      case Species::ChlorineNitrate:
-        return Isotopologue<Species::ChlorineNitrate>().Mass(long(num));
-      case Species::NitricOxideCation:
-        return Isotopologue<Species::NitricOxideCation>().Mass(long(num));
-      case Species::HypobromousAcid:
-        return Isotopologue<Species::HypobromousAcid>().Mass(long(num));
-      case Species::Ethylene:
-        return Isotopologue<Species::Ethylene>().Mass(long(num));
-      case Species::Methanol:
-        return Isotopologue<Species::Methanol>().Mass(long(num));
-      case Species::MethylBromide:
-        return Isotopologue<Species::MethylBromide>().Mass(long(num));
-      case Species::Acetonitrile:
-        return Isotopologue<Species::Acetonitrile>().Mass(long(num));
-      case Species::Pfc14:
-        return Isotopologue<Species::Pfc14>().Mass(long(num));
-      case Species::Diacetylene:
-        return Isotopologue<Species::Diacetylene>().Mass(long(num));
-      case Species::Cyanoacetylene:
-        return Isotopologue<Species::Cyanoacetylene>().Mass(long(num));
-      case Species::Hydrogen:
-        return Isotopologue<Species::Hydrogen>().Mass(long(num));
-      case Species::CarbonMonosulfide:
-        return Isotopologue<Species::CarbonMonosulfide>().Mass(long(num));
-      case Species::SulfurTrioxide:
-        return Isotopologue<Species::SulfurTrioxide>().Mass(long(num));
-      case Species::Cyanogen:
-        return Isotopologue<Species::Cyanogen>().Mass(long(num));
-      case Species::Phosgene:
-        return Isotopologue<Species::Phosgene>().Mass(long(num));
-      case Species::FINAL: { /*leave last*/
-      }
-    }
-    return {};
+    return isotope_table[index()].mass;
   }
 
+  /** Degeneracy of the isotope, NaN if it is not a known isotope */
   constexpr double gi() const noexcept {
-    switch (s) {
-      case Species::Bath:
-        return std::numeric_limits<double>::quiet_NaN();
-      case Species::Water:
-        return Isotopologue<Species::Water>().G(long(num));
-      case Species::CarbonDioxide:
-        return Isotopologue<Species::CarbonDioxide>().G(long(num));
-      case Species::Ozone:
-        return Isotopologue<Species::Ozone>().G(long(num));
-      case Species::NitrogenOxide:
-        return Isotopologue<Species::NitrogenOxide>().G(long(num));
-      case Species::CarbonMonoxide:
-        return Isotopologue<Species::CarbonMonoxide>().G(long(num));
-      case Species::Methane:
-        return Isotopologue<Species::Methane>().G(long(num));
-      case Species::Oxygen:
-        return Isotopologue<Species::Oxygen>().G(long(num));
-      case Species::NitricOxide:
-        return Isotopologue<Species::NitricOxide>().G(long(num));
-      case Species::SulfurDioxide:
-        return Isotopologue<Species::SulfurDioxide>().G(long(num));
-      case Species::NitrogenDioxide:
-        return Isotopologue<Species::NitrogenDioxide>().G(long(num));
-      case Species::Ammonia:
-        return Isotopologue<Species::Ammonia>().G(long(num));
-      case Species::NitricAcid:
-        return Isotopologue<Species::NitricAcid>().G(long(num));
-      case Species::Hydroxyl:
-        return Isotopologue<Species::Hydroxyl>().G(long(num));
-      case Species::HydrogenFluoride:
-        return Isotopologue<Species::HydrogenFluoride>().G(long(num));
-      case Species::HydrogenChloride:
-        return Isotopologue<Species::HydrogenChloride>().G(long(num));
-      case Species::HydrogenBromide:
-        return Isotopologue<Species::HydrogenBromide>().G(long(num));
-      case Species::HydrogenIodide:
-        return Isotopologue<Species::HydrogenIodide>().G(long(num));
-      case Species::ChlorineMonoxide:
-        return Isotopologue<Species::ChlorineMonoxide>().G(long(num));
-      case Species::CarbonylSulfide:
-        return Isotopologue<Species::CarbonylSulfide>().G(long(num));
-      case Species::Formaldehyde:
-        return Isotopologue<Species::Formaldehyde>().G(long(num));
-      case Species::HypochlorousAcid:
-        return Isotopologue<Species::HypochlorousAcid>().G(long(num));
-      case Species::Nitrogen:
-        return Isotopologue<Species::Nitrogen>().G(long(num));
-      case Species::HydrogenCyanide:
-        return Isotopologue<Species::HydrogenCyanide>().G(long(num));
-      case Species::MethylChloride:
-        return Isotopologue<Species::MethylChloride>().G(long(num));
-      case Species::HydrogenPeroxide:
-        return Isotopologue<Species::HydrogenPeroxide>().G(long(num));
-      case Species::Acetylene:
-        return Isotopologue<Species::Acetylene>().G(long(num));
-      case Species::Ethane:
-        return Isotopologue<Species::Ethane>().G(long(num));
-      case Species::Phosphine:
-        return Isotopologue<Species::Phosphine>().G(long(num));
-      case Species::CarbonylFluoride:
-        return Isotopologue<Species::CarbonylFluoride>().G(long(num));
-      case Species::SulfurHexafluoride:
-        return Isotopologue<Species::SulfurHexafluoride>().G(long(num));
-      case Species::HydrogenSulfide:
-        return Isotopologue<Species::HydrogenSulfide>().G(long(num));
-      case Species::FormicAcid:
-        return Isotopologue<Species::FormicAcid>().G(long(num));
-      case Species::Hydroperoxyl:
-        return Isotopologue<Species::Hydroperoxyl>().G(long(num));
-      case Species::OxygenAtom:
-        return Isotopologue<Species::OxygenAtom>().G(long(num));
-      case Species::ChlorineNitrate:
-        return Isotopologue<Species::ChlorineNitrate>().G(long(num));
-      case Species::NitricOxideCation:
-        return Isotopologue<Species::NitricOxideCation>().G(long(num));
-      case Species::HypobromousAcid:
-        return Isotopologue<Species::HypobromousAcid>().G(long(num));
-      case Species::Ethylene:
-        return Isotopologue<Species::Ethylene>().G(long(num));
-      case Species::Methanol:
-        return Isotopologue<Species::Methanol>().G(long(num));
-      case Species::MethylBromide:
-        return Isotopologue<Species::MethylBromide>().G(long(num));
-      case Species::Acetonitrile:
-        return Isotopologue<Species::Acetonitrile>().G(long(num));
-      case Species::Pfc14:
-        return Isotopologue<Species::Pfc14>().G(long(num));
-      case Species::Diacetylene:
-        return Isotopologue<Species::Diacetylene>().G(long(num));
-      case Species::Cyanoacetylene:
-        return Isotopologue<Species::Cyanoacetylene>().G(long(num));
-      case Species::Hydrogen:
-        return Isotopologue<Species::Hydrogen>().G(long(num));
-      case Species::CarbonMonosulfide:
-        return Isotopologue<Species::CarbonMonosulfide>().G(long(num));
-      case Species::SulfurTrioxide:
-        return Isotopologue<Species::SulfurTrioxide>().G(long(num));
-      case Species::Cyanogen:
-        return Isotopologue<Species::Cyanogen>().G(long(num));
-      case Species::Phosgene:
-        return Isotopologue<Species::Phosgene>().G(long(num));
-      case Species::FINAL: { /*leave last*/
-      }
-    }
-    return {};
+    return isotope_table[index()].gi;
   }
 
+  /** Partition function, 0 if it is not a known isotope */
   constexpr double QT(double T) const noexcept {
-    switch (s) {
-      case Species::Water:
-        return Isotopologue<Species::Water>().QT<false>(T, num);
-      case Species::CarbonDioxide:
-        return Isotopologue<Species::CarbonDioxide>().QT<false>(T, num);
-      case Species::Ozone:
-        return Isotopologue<Species::Ozone>().QT<false>(T, num);
-      case Species::NitrogenOxide:
-        return Isotopologue<Species::NitrogenOxide>().QT<false>(T, num);
-      case Species::CarbonMonoxide:
-        return Isotopologue<Species::CarbonMonoxide>().QT<false>(T, num);
-      case Species::Methane:
-        return Isotopologue<Species::Methane>().QT<false>(T, num);
-      case Species::Oxygen:
-        return Isotopologue<Species::Oxygen>().QT<false>(T, num);
-      case Species::NitricOxide:
-        return Isotopologue<Species::NitricOxide>().QT<false>(T, num);
-      case Species::SulfurDioxide:
-        return Isotopologue<Species::SulfurDioxide>().QT<false>(T, num);
-      case Species::NitrogenDioxide:
-        return Isotopologue<Species::NitrogenDioxide>().QT<false>(T, num);
-      case Species::Ammonia:
-        return Isotopologue<Species::Ammonia>().QT<false>(T, num);
-      case Species::NitricAcid:
-        return Isotopologue<Species::NitricAcid>().QT<false>(T, num);
-      case Species::Hydroxyl:
-        return Isotopologue<Species::Hydroxyl>().QT<false>(T, num);
-      case Species::HydrogenFluoride:
-        return Isotopologue<Species::HydrogenFluoride>().QT<false>(T, num);
-      case Species::HydrogenChloride:
-        return Isotopologue<Species::HydrogenChloride>().QT<false>(T, num);
-      case Species::HydrogenBromide:
-        return Isotopologue<Species::HydrogenBromide>().QT<false>(T, num);
-      case Species::HydrogenIodide:
-        return Isotopologue<Species::HydrogenIodide>().QT<false>(T, num);
-      case Species::ChlorineMonoxide:
-        return Isotopologue<Species::ChlorineMonoxide>().QT<false>(T, num);
-      case Species::CarbonylSulfide:
-        return Isotopologue<Species::CarbonylSulfide>().QT<false>(T, num);
-      case Species::Formaldehyde:
-        return Isotopologue<Species::Formaldehyde>().QT<false>(T, num);
-      case Species::HypochlorousAcid:
-        return Isotopologue<Species::HypochlorousAcid>().QT<false>(T, num);
-      case Species::Nitrogen:
-        return Isotopologue<Species::Nitrogen>().QT<false>(T, num);
-      case Species::HydrogenCyanide:
-        return Isotopologue<Species::HydrogenCyanide>().QT<false>(T, num);
-      case Species::MethylChloride:
-        return Isotopologue<Species::MethylChloride>().QT<false>(T, num);
-      case Species::HydrogenPeroxide:
-        return Isotopologue<Species::HydrogenPeroxide>().QT<false>(T, num);
-      case Species::Acetylene:
-        return Isotopologue<Species::Acetylene>().QT<false>(T, num);
-      case Species::Ethane:
-        return Isotopologue<Species::Ethane>().QT<false>(T, num);
-      case Species::Phosphine:
-        return Isotopologue<Species::Phosphine>().QT<false>(T, num);
-      case Species::CarbonylFluoride:
-        return Isotopologue<Species::CarbonylFluoride>().QT<false>(T, num);
-      case Species::SulfurHexafluoride:
-        return Isotopologue<Species::SulfurHexafluoride>().QT<false>(T, num);
-      case Species::HydrogenSulfide:
-        return Isotopologue<Species::HydrogenSulfide>().QT<false>(T, num);
-      case Species::FormicAcid:
-        return Isotopologue<Species::FormicAcid>().QT<false>(T, num);
-      case Species::Hydroperoxyl:
-        return Isotopologue<Species::Hydroperoxyl>().QT<false>(T, num);
-      case Species::OxygenAtom:
-        return Isotopologue<Species::OxygenAtom>().QT<false>(T, num);
-      case Species::ChlorineNitrate:
-        return Isotopologue<Species::ChlorineNitrate>().QT<false>(T, num);
-      case Species::NitricOxideCation:
-        return Isotopologue<Species::NitricOxideCation>().QT<false>(T, num);
-      case Species::HypobromousAcid:
-        return Isotopologue<Species::HypobromousAcid>().QT<false>(T, num);
-      case Species::Ethylene:
-        return Isotopologue<Species::Ethylene>().QT<false>(T, num);
-      case Species::Methanol:
-        return Isotopologue<Species::Methanol>().QT<false>(T, num);
-      case Species::MethylBromide:
-        return Isotopologue<Species::MethylBromide>().QT<false>(T, num);
-      case Species::Acetonitrile:
-        return Isotopologue<Species::Acetonitrile>().QT<false>(T, num);
-      case Species::Pfc14:
-        return Isotopologue<Species::Pfc14>().QT<false>(T, num);
-      case Species::Diacetylene:
-        return Isotopologue<Species::Diacetylene>().QT<false>(T, num);
-      case Species::Cyanoacetylene:
-        return Isotopologue<Species::Cyanoacetylene>().QT<false>(T, num);
-      case Species::Hydrogen:
-        return Isotopologue<Species::Hydrogen>().QT<false>(T, num);
-      case Species::CarbonMonosulfide:
-        return Isotopologue<Species::CarbonMonosulfide>().QT<false>(T, num);
-      case Species::SulfurTrioxide:
-        return Isotopologue<Species::SulfurTrioxide>().QT<false>(T, num);
-      case Species::Cyanogen:
-        return Isotopologue<Species::Cyanogen>().QT<false>(T, num);
-      case Species::Phosgene:
-        return Isotopologue<Species::Phosgene>().QT<false>(T, num);
-      case Species::Bath:
-      case Species::FINAL: { /* leave last */
-      }
-    }
-    return {};
+    return isotope_table[index()].QT(T);
   }
 
+  /** Temperature derivative of the partition function, 0 if it is not a
+   * known isotope */
   constexpr double dQT(double T) const noexcept {
-    switch (s) {
-      case Species::Water:
-        return Isotopologue<Species::Water>().QT<true>(T, num);
-      case Species::CarbonDioxide:
-        return Isotopologue<Species::CarbonDioxide>().QT<true>(T, num);
-      case Species::Ozone:
-        return Isotopologue<Species::Ozone>().QT<true>(T, num);
-      case Species::NitrogenOxide:
-        return Isotopologue<Species::NitrogenOxide>().QT<true>(T, num);
-      case Species::CarbonMonoxide:
-        return Isotopologue<Species::CarbonMonoxide>().QT<true>(T, num);
-      case Species::Methane:
-        return Isotopologue<Species::Methane>().QT<true>(T, num);
-      case Species::Oxygen:
-        return Isotopologue<Species::Oxygen>().QT<true>(T, num);
-      case Species::NitricOxide:
-        return Isotopologue<Species::NitricOxide>().QT<true>(T, num);
-      case Species::SulfurDioxide:
-        return Isotopologue<Species::SulfurDioxide>().QT<true>(T, num);
-      case Species::NitrogenDioxide:
-        return Isotopologue<Species::NitrogenDioxide>().QT<true>(T, num);
-      case Species::Ammonia:
-        return Isotopologue<Species::Ammonia>().QT<true>(T, num);
-      case Species::NitricAcid:
-        return Isotopologue<Species::NitricAcid>().QT<true>(T, num);
-      case Species::Hydroxyl:
-        return Isotopologue<Species::Hydroxyl>().QT<true>(T, num);
-      case Species::HydrogenFluoride:
-        return Isotopologue<Species::HydrogenFluoride>().QT<true>(T, num);
-      case Species::HydrogenChloride:
-        return Isotopologue<Species::HydrogenChloride>().QT<true>(T, num);
-      case Species::HydrogenBromide:
-        return Isotopologue<Species::HydrogenBromide>().QT<true>(T, num);
-      case Species::HydrogenIodide:
-        return Isotopologue<Species::HydrogenIodide>().QT<true>(T, num);
-      case Species::ChlorineMonoxide:
-        return Isotopologue<Species::ChlorineMonoxide>().QT<true>(T, num);
-      case Species::CarbonylSulfide:
-        return Isotopologue<Species::CarbonylSulfide>().QT<true>(T, num);
-      case Species::Formaldehyde:
-        return Isotopologue<Species::Formaldehyde>().QT<true>(T, num);
-      case Species::HypochlorousAcid:
-        return Isotopologue<Species::HypochlorousAcid>().QT<true>(T, num);
-      case Species::Nitrogen:
-        return Isotopologue<Species::Nitrogen>().QT<true>(T, num);
-      case Species::HydrogenCyanide:
-        return Isotopologue<Species::HydrogenCyanide>().QT<true>(T, num);
-      case Species::MethylChloride:
-        return Isotopologue<Species::MethylChloride>().QT<true>(T, num);
-      case Species::HydrogenPeroxide:
-        return Isotopologue<Species::HydrogenPeroxide>().QT<true>(T, num);
-      case Species::Acetylene:
-        return Isotopologue<Species::Acetylene>().QT<true>(T, num);
-      case Species::Ethane:
-        return Isotopologue<Species::Ethane>().QT<true>(T, num);
-      case Species::Phosphine:
-        return Isotopologue<Species::Phosphine>().QT<true>(T, num);
-      case Species::CarbonylFluoride:
-        return Isotopologue<Species::CarbonylFluoride>().QT<true>(T, num);
-      case Species::SulfurHexafluoride:
-        return Isotopologue<Species::SulfurHexafluoride>().QT<true>(T, num);
-      case Species::HydrogenSulfide:
-        return Isotopologue<Species::HydrogenSulfide>().QT<true>(T, num);
-      case Species::FormicAcid:
-        return Isotopologue<Species::FormicAcid>().QT<true>(T, num);
-      case Species::Hydroperoxyl:
-        return Isotopologue<Species::Hydroperoxyl>().QT<true>(T, num);
-      case Species::OxygenAtom:
-        return Isotopologue<Species::OxygenAtom>().QT<true>(T, num);
-      case Species::ChlorineNitrate:
-        return Isotopologue<Species::ChlorineNitrate>().QT<true>(T, num);
-      case Species::NitricOxideCation:
-        return Isotopologue<Species::NitricOxideCation>().QT<true>(T, num);
-      case Species::HypobromousAcid:
-        return Isotopologue<Species::HypobromousAcid>().QT<true>(T, num);
-      case Species::Ethylene:
-        return Isotopologue<Species::Ethylene>().QT<true>(T, num);
-      case Species::Methanol:
-        return Isotopologue<Species::Methanol>().QT<true>(T, num);
-      case Species::MethylBromide:
-        return Isotopologue<Species::MethylBromide>().QT<true>(T, num);
-      case Species::Acetonitrile:
-        return Isotopologue<Species::Acetonitrile>().QT<true>(T, num);
-      case Species::Pfc14:
-        return Isotopologue<Species::Pfc14>().QT<true>(T, num);
-      case Species::Diacetylene:
-        return Isotopologue<Species::Diacetylene>().QT<true>(T, num);
-      case Species::Cyanoacetylene:
-        return Isotopologue<Species::Cyanoacetylene>().QT<true>(T, num);
-      case Species::Hydrogen:
-        return Isotopologue<Species::Hydrogen>().QT<true>(T, num);
-      case Species::CarbonMonosulfide:
-        return Isotopologue<Species::CarbonMonosulfide>().QT<true>(T, num);
-      case Species::SulfurTrioxide:
-        return Isotopologue<Species::SulfurTrioxide>().QT<true>(T, num);
-      case Species::Cyanogen:
-        return Isotopologue<Species::Cyanogen>().QT<true>(T, num);
-      case Species::Phosgene:
-        return Isotopologue<Species::Phosgene>().QT<true>(T, num);
-      case Species::Bath:
-      case Species::FINAL: { /* leave last */
-      }
-    }
-    return {};
+    return isotope_table[index()].dQT(T);
   }
 
   std::vector<ChargedAtom> atoms() const noexcept {
@@ -4129,6 +3804,18 @@ class Isotope {
     return {};
   }
 
+  /** The partition function and its temperature derivative together
+   *
+   * Interpolated in a table of QT and dQT for 1 K to 3000 K in 1 K steps,
+   * built for each isotope when it is first used.  The cubic Hermite
+   * interpolation is exact at the nodes and keeps dQ/dT the derivative of Q.
+   * Outside the table, and for unknown isotopes, QT and dQT are used
+   *
+   * @param[in] T Temperature [K]
+   * @return Q and dQ/dT
+   */
+  PartitionValue Partition(double T) const noexcept;
+
   operator Species() const noexcept { return s; }
 };  // Isotope
 
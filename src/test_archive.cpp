@@ -0,0 +1,55 @@
+#include "archive.h"
+
+void test001() {
+  const std::filesystem::path dir{"test_archive_test001"};
+  std::filesystem::remove_all(dir);
+
+  const Time start;
+  {
+    Instrument::Archive::Writer w(dir, 100, 4);
+    for (int i = 0; i < 1000; i++) {
+      const Time t = start + TimeStep(i);
+      w.save<1>(t, {{"Cold Load Temperature", 20 + 0.001 * i}}, {},
+                {std::vector<std::vector<float>>{std::vector<float>(10, i)}},
+                {"Dummy"});
+    }
+  }
+
+  // Reopening appends to the same columns
+  {
+    Instrument::Archive::Writer w(dir, 100);
+    w.append(start + TimeStep(1000), "Housekeeping/Cold Load Temperature", 21);
+  }
+
+  Instrument::Archive::Reader r(dir);
+  std::cout << "keys:\n";
+  for (auto &k : r.keys()) std::cout << '\t' << k << '\n';
+
+  const Time t0 = start + TimeStep(250.5);
+  const Time t1 = start + TimeStep(260);
+  std::cout << "chunks touched for 250.5-260 s (expects 1):\n";
+  for (auto &c : r.chunks("Housekeeping/Cold Load Temperature", t0, t1))
+    std::cout << '\t' << c << '\n';
+
+  auto hk = r.read("Housekeeping/Cold Load Temperature", t0, t1);
+  std::cout << "records (expects 10 from 20.251 to 20.26): " << hk.size()
+            << '\n';
+  for (std::size_t i = 0; i < hk.size(); i++)
+    std::cout << '\t' << hk.time[i] - start.Seconds() << ' ' << hk.value[i]
+              << '\n';
+
+  auto spec = r.read("Spectrometer/Dummy/0", t0, t1);
+  std::cout << "downsampled width (expects 3): " << spec.width << '\n';
+
+  auto last = r.read("Housekeeping/Cold Load Temperature",
+                     start + TimeStep(999), start + TimeStep(1001));
+  std::cout << "appended records (expects 20.999 21): ";
+  for (auto &v : last.value) std::cout << v << ' ';
+  std::cout << '\n';
+}
+
+int main() {
+  std::cout << "---------------------------------------Archive\n";
+  test001();  // Test writing and reading of the archive
+  std::cout << "---------------------------------------\n";
+}
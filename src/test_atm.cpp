@@ -1,3 +1,7 @@
+#include <fstream>
+#include <iterator>
+
+#include "allocations.h"
 #include "atm.h"
 
 void test001() {
@@ -271,6 +275,407 @@ void test008() {
     std::cout << alt << ' ' << atm(t, alt, 0, 0) << '\n';
 }
 
+/** The grid point search of Atm::interpPoints before it used bisection */
+template <typename T>
+LinearInterpPoint scan(const std::vector<T> &x, const T v) {
+  if (x.size() < 2) return {1, 0};
+  auto pos = std::find_if(x.cbegin(), x.cend(), [v](auto a) { return v <= a; });
+  auto low = (pos == x.cbegin()) ? x.cbegin() : pos - 1;
+  auto w = (pos == x.cend()) ? 1.0
+                             : Interp::weight(v, low->value(), pos->value());
+  return LinearInterpPoint(w, size_t(low - x.cbegin()));
+}
+
+bool same(LinearInterpPoint a, LinearInterpPoint b) {
+  return a.weight() == b.weight() and a.index() == b.index();
+}
+
+void test009() {
+  constexpr size_t nalt = 20'000, nlat = 19, npos = 200'000;
+  Atmosphere::Point a(
+      100e3, 296., std::array<double, 3>{11e-6, 11e-6, 31e-6},
+      std::array<double, 3>{10., 1., 0.1},
+      std::vector<VMR<VMRType::ratio>>{VMR<VMRType::ratio>{
+          Species::Isotope(Species::Species::Oxygen, 0), 0.2095}});
+  std::vector<Altitude<AltitudeType::meter>> uniform_alt, alt;
+  for (size_t i = 0; i < nalt; i++) {
+    uniform_alt.push_back(5.0 * double(i));
+    alt.push_back(100e3 * std::pow(double(i) / double(nalt - 1), 1.5));
+  }
+  std::vector<Coordinate<CoordinateType::lat>> lat;
+  for (size_t i = 0; i < nlat; i++) lat.push_back(-90.0 + 10.0 * double(i));
+  const Time t;
+
+  // Positions along a path from the top down, and some outside the grids
+  std::vector<std::array<double, 2>> pos;
+  for (size_t i = 0; i < npos; i++)
+    pos.push_back({110e3 - 120e3 * double(i) / double(npos - 1),
+                   -95 + 190 * double(i) / double(npos - 1)});
+  pos.push_back({alt[nalt / 2], lat[nlat / 2]});
+  pos.push_back({uniform_alt[nalt / 2], -90});
+
+  for (auto *grid : {&uniform_alt, &alt}) {
+    const Atmosphere::Atm atm({t}, *grid, lat, {0},
+                              Grid<Atmosphere::Point, 4>(a, 1, nalt, nlat, 1));
+
+    size_t ndiff = 0;
+    Atmosphere::InterPoints hint;
+    for (auto &p : pos) {
+      const auto ip = atm.interpPoints(t, p[0], p[1], 0);
+      const auto iph = atm.interpPoints(t, p[0], p[1], 0, hint);
+      const auto ref_alt = scan(*grid, Altitude<AltitudeType::meter>{p[0]});
+      const auto ref_lat = scan(lat, Coordinate<CoordinateType::lat>{p[1]});
+      if (not same(ip.Alt(), ref_alt) or not same(ip.Lat(), ref_lat) or
+          not same(iph.Alt(), ref_alt) or not same(iph.Lat(), ref_lat))
+        ndiff++;
+      hint = iph;
+    }
+
+    double sum = 0;
+    const Time start_scan;
+    for (auto &p : pos)
+      sum += scan(*grid, Altitude<AltitudeType::meter>{p[0]}).weight() +
+             scan(lat, Coordinate<CoordinateType::lat>{p[1]}).weight();
+    const double tscan = TimeStep(Time() - start_scan).count();
+
+    const Time start_search;
+    for (auto &p : pos) {
+      const auto ip = atm.interpPoints(t, p[0], p[1], 0);
+      sum -= ip.Alt().weight() + ip.Lat().weight();
+    }
+    const double tsearch = TimeStep(Time() - start_search).count();
+
+    const Time start_hint;
+    for (auto &p : pos) {
+      hint = atm.interpPoints(t, p[0], p[1], 0, hint);
+      sum -= hint.Alt().weight() + hint.Lat().weight();
+    }
+    const double thint = TimeStep(Time() - start_hint).count();
+
+    std::cout << (grid == &alt ? "Non-uniform" : "Uniform") << " grid of "
+              << nalt << " altitudes and " << nlat << " latitudes, "
+              << pos.size() << " positions, differences from a scan of the "
+              << "grids (expects 0): " << ndiff << "\nScan: " << tscan
+              << " s, search: " << tsearch << " s, with hints: " << thint
+              << " s, speedups " << tscan / tsearch << " and "
+              << tscan / thint << " (sum " << sum << ")\n";
+  }
+}
+
+void test010() {
+  constexpr size_t npos = 1'000'000;
+  const std::vector<Species::Species> specs{
+      Species::Species::Nitrogen, Species::Species::Oxygen,
+      Species::Species::Water, Species::Species::CarbonDioxide,
+      Species::Species::Ozone};
+  std::vector<VMR<VMRType::ratio>> vmr;
+  for (size_t i = 0; i < specs.size(); i++)
+    vmr.emplace_back(Species::Isotope(specs[i], 0), 1e-3 * double(i + 1));
+  const Atmosphere::Point a(100e3, 296., std::array<double, 3>{1e-5, 0, 0},
+                            std::array<double, 3>{10., 1., 0.1}, vmr);
+  const Time t;
+  const Atmosphere::Atm atm({t}, {0, 10e3, 20e3}, {0, 10}, {0, 10},
+                            Grid<Atmosphere::Point, 4>(a, 1, 3, 2, 2));
+
+  double sum = 0;
+  Atmosphere::InterPoints hint;
+  const size_t allocations_before = allocations;
+  const Time start;
+  for (size_t i = 0; i < npos; i++) {
+    const double x = double(i) / double(npos);
+    hint = atm.interpPoints(t, 20e3 * x, 10 * x, 10 * x, hint);
+    sum += atm(hint).VolumeMixingRatio(Species::Isotope(specs[i % 5], 0));
+  }
+  const double tinterp = TimeStep(Time() - start).count();
+  const size_t nalloc = allocations - allocations_before;
+
+  // More species than are kept inline
+  std::vector<VMR<VMRType::ratio>> many;
+  for (unsigned char i = 0; i < 12; i++)
+    many.emplace_back(Species::Isotope(Species::Species::Water, i % 7),
+                      double(i));
+  Atmosphere::Point b(1, 1, std::array<double, 3>{0, 0, 0},
+                      std::array<double, 3>{0, 0, 0}, many);
+  Atmosphere::Point c = 0.5 * b;
+  c.expP();
+  b = c;
+  const auto *const heap = c.VolumeMixingRatios().data();
+  const size_t allocations_before_move = allocations;
+  Atmosphere::Point d = std::move(c);
+  const bool kept = d.VolumeMixingRatios().data() == heap;
+  c = std::move(d);
+  const size_t nmove = allocations - allocations_before_move;
+
+  std::cout << "Interpolated " << npos << " points of " << specs.size()
+            << " species, allocations (expects 0): " << nalloc
+            << ", mean volume mixing ratio (expects 0.003): "
+            << sum / double(npos) << ", " << 1e9 * tinterp / double(npos)
+            << " ns per point\nHalf of the last of " << many.size()
+            << " species (expects 5.5): " << b.VolumeMixingRatios()[11].value()
+            << "\nMoves of them keep their buffer (expects 1): "
+            << (kept and c.VolumeMixingRatios().data() == heap)
+            << ", allocations (expects 0): " << nmove << '\n';
+}
+
+void test011() {
+  constexpr size_t nalt = 100, nlat = 30, nlon = 30, nrep = 20;
+  std::vector<VMR<VMRType::ratio>> vmr;
+  for (unsigned char i = 0; i < 5; i++)
+    vmr.emplace_back(Species::Isotope(Species::Species::Water, i), 1e-4);
+  const Atmosphere::Point a(100e3, 296., std::array<double, 3>{1e-5, 0, 0},
+                            std::array<double, 3>{10., 1., 0.1}, vmr);
+  std::vector<Altitude<AltitudeType::meter>> alt;
+  std::vector<Coordinate<CoordinateType::lat>> lat;
+  std::vector<Coordinate<CoordinateType::lon>> lon;
+  for (size_t i = 0; i < nalt; i++) alt.push_back(1e3 * double(i));
+  for (size_t i = 0; i < nlat; i++) lat.push_back(double(i));
+  for (size_t i = 0; i < nlon; i++) lon.push_back(double(i));
+  Atmosphere::Atm atm({Time()}, alt, lat, lon,
+                      Grid<Atmosphere::Point, 4>(a, 1, nalt, nlat, nlon));
+
+  // Set one field of all points, then read it and another one back
+  double sum = 0;
+  const Time start;
+  for (size_t r = 0; r < nrep; r++) {
+    for (size_t j = 0; j < nalt; j++)
+      for (size_t k = 0; k < nlat; k++)
+        for (size_t m = 0; m < nlon; m++)
+          atm(0, j, k, m).Temp(200 + double(j + k + m + r));
+    for (size_t j = 0; j < nalt; j++)
+      for (size_t k = 0; k < nlat; k++)
+        for (size_t m = 0; m < nlon; m++)
+          sum += atm(0, j, k, m).Temp() +
+                 atm(0, j, k, m).VolumeMixingRatio(vmr[4].isot());
+  }
+  const double tfield = TimeStep(Time() - start).count();
+
+  // A point set and read back through its view
+  Atmosphere::Point b(a);
+  b.Temp(250);
+  b.VolumeMixingRatio(vmr[2].isot(), 3e-4);
+  atm(0, 1, 2, 3) = b;
+  std::ostringstream sb, sv;
+  sb << b;
+  sv << atm(0, 1, 2, 3);
+  const Atmosphere::Point copy = atm(0, 1, 2, 3);
+  atm(0, 1, 2, 3).Temp(260);
+
+  // A point of other species
+  std::string error;
+  try {
+    atm(0, 0, 0, 0) = Atmosphere::Point(
+        1, 1, std::array<double, 3>{0, 0, 0}, std::array<double, 3>{0, 0, 0},
+        std::vector<VMR<VMRType::ratio>>(
+            5, VMR<VMRType::ratio>(Species::Isotope(Species::Species::Ozone, 0),
+                                   0)));
+  } catch (std::exception &e) {
+    error = e.what();
+  }
+
+  std::cout << "Set and read the temperature of " << nalt * nlat * nlon
+            << " points " << nrep << " times: " << tfield << " s (sum "
+            << sum << ")\nPoint read back as it was set (expects 1): "
+            << (sb.str() == sv.str())
+            << "\nA copied point keeps its temperature (expects 250): "
+            << copy.Temp()
+            << "\nSetting a point of other species throws (expects 1): "
+            << (not error.empty()) << '\n';
+}
+
+/** Whether all fields of two atmospheres of the same grids are equal */
+bool same_fields(const Atmosphere::Atm &a, const Atmosphere::Atm &b) {
+  if (a.ntid() not_eq b.ntid() or a.nalt() not_eq b.nalt() or
+      a.nlat() not_eq b.nlat() or a.nlon() not_eq b.nlon())
+    return false;
+  for (size_t i = 0; i < a.ntid(); i++)
+    for (size_t j = 0; j < a.nalt(); j++)
+      for (size_t k = 0; k < a.nlat(); k++)
+        for (size_t m = 0; m < a.nlon(); m++) {
+          const auto x = a(i, j, k, m), y = b(i, j, k, m);
+          if (x.Pres() not_eq y.Pres() or x.Temp() not_eq y.Temp() or
+              x.MagField().value() not_eq y.MagField().value() or
+              x.WindField().value() not_eq y.WindField().value() or
+              x.specs() not_eq y.specs())
+            return false;
+          for (auto s : x.specs())
+            if (x.VolumeMixingRatio(s) not_eq y.VolumeMixingRatio(s))
+              return false;
+        }
+  return true;
+}
+
+void test012() {
+  constexpr size_t nalt = 40, nlat = 60, nlon = 60;
+  std::vector<VMR<VMRType::ratio>> vmr{
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                          0.78},
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                          0.2095},
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
+                          400e-06}};
+  const Atmosphere::Point a(100e3, 296., std::array<double, 3>{1e-5, 0, 0},
+                            std::array<double, 3>{10., 1., 0.1}, vmr);
+  std::vector<Altitude<AltitudeType::meter>> alt;
+  std::vector<Coordinate<CoordinateType::lat>> lat;
+  std::vector<Coordinate<CoordinateType::lon>> lon;
+  for (size_t i = 0; i < nalt; i++) alt.push_back(2e3 * double(i));
+  for (size_t i = 0; i < nlat; i++) lat.push_back(-89.5 + 3 * double(i));
+  for (size_t i = 0; i < nlon; i++) lon.push_back(6 * double(i));
+  Atmosphere::Atm atm({Time()}, alt, lat, lon,
+                      Grid<Atmosphere::Point, 4>(a, 1, nalt, nlat, nlon));
+  for (size_t j = 0; j < nalt; j++)
+    for (size_t k = 0; k < nlat; k++)
+      for (size_t m = 0; m < nlon; m++) {
+        atm(0, j, k, m).Temp(200 + std::sin(double(j * k + m)) * 80.123456789);
+        atm(0, j, k, m).WindField().v() = std::cos(double(j + k * m)) * 31.4159;
+        atm(0, j, k, m).VolumeMixingRatio(vmr[2].isot(),
+                                          1e-4 * std::exp(-double(j) / 7));
+      }
+
+  File::File<File::Operation::Write, File::Type::Xml> save(
+      "test_atm_test012.xml");
+  saveAtm(save, atm);
+  save.close();
+  File::File<File::Operation::WriteBinary, File::Type::Xml> saveb(
+      "test_atm_test012b.xml");
+  saveAtm(saveb, atm);
+  saveb.close();
+
+  // The data of points as read before, through a string stream
+  Atmosphere::Atm ref(1, nalt, nlat, nlon, vmr.size());
+  Time start;
+  {
+    File::File<File::Operation::Read, File::Type::Xml> data(
+        "test_atm_test012.xml");
+    data.get_child("Atm");
+    std::istringstream is(data.get_child("Data").text().as_string());
+    for (size_t j = 0; j < nalt; j++)
+      for (size_t k = 0; k < nlat; k++)
+        for (size_t m = 0; m < nlon; m++) {
+          Atmosphere::Point p(atm(0, 0, 0, 0).specs());
+          p.readPureAscii(is);
+          ref(0, j, k, m) = p;
+        }
+  }
+  const double tstream = TimeStep(Time() - start).count();
+
+  Atmosphere::Atm ascii;
+  start = Time();
+  File::File<File::Operation::Read, File::Type::Xml> read(
+      "test_atm_test012.xml");
+  readAtm(read, ascii);
+  read.close();
+  const double tascii = TimeStep(Time() - start).count();
+
+  Atmosphere::Atm binary;
+  start = Time();
+  File::File<File::Operation::ReadBinary, File::Type::Xml> readb(
+      "test_atm_test012b.xml");
+  readAtm(readb, binary);
+  readb.close();
+  const double tbinary = TimeStep(Time() - start).count();
+
+  // A binary file of point after point, as written before
+  {
+    File::File<File::Operation::WriteBinary, File::Type::Xml> old(
+        "test_atm_test012o.xml");
+    old.new_child("Atm");
+    old.add_attribute("Time", atm.ntid());
+    old.add_attribute("Altitudes", atm.nalt());
+    old.add_attribute("Latitudes", atm.nlat());
+    old.add_attribute("Longitudes", atm.nlon());
+    old.add_attribute("Species", atm(0, 0, 0, 0).specs());
+    old.new_child("Time");
+    old.write(atm.tidvec());
+    old.leave_child();
+    old.new_child("Altitudes");
+    old.write(atm.altvec());
+    old.leave_child();
+    old.new_child("Latitudes");
+    old.write(atm.latvec());
+    old.leave_child();
+    old.new_child("Longitudes");
+    old.write(atm.lonvec());
+    old.leave_child();
+    old.new_child("Data");
+    for (size_t j = 0; j < nalt; j++)
+      for (size_t k = 0; k < nlat; k++)
+        for (size_t m = 0; m < nlon; m++)
+          Atmosphere::Point(atm(0, j, k, m)).saveBinary(old);
+    old.leave_child();
+    old.leave_child();
+    old.close();
+  }
+  Atmosphere::Atm points;
+  start = Time();
+  File::File<File::Operation::ReadBinary, File::Type::Xml> reado(
+      "test_atm_test012o.xml");
+  readAtm(reado, points);
+  reado.close();
+  const double tpoints = TimeStep(Time() - start).count();
+
+  // Text of a sign after a sign, and of a value more than the points hold
+  const auto text_error = [](const std::string &from, const std::string &to) {
+    std::ifstream is("test_atm_test012.xml");
+    std::string xml((std::istreambuf_iterator<char>(is)),
+                    std::istreambuf_iterator<char>());
+    is.close();
+    xml.replace(xml.find(from), from.size(), to);
+    std::ofstream os("test_atm_test012t.xml");
+    os << xml;
+    os.close();
+    try {
+      Atmosphere::Atm bad;
+      File::File<File::Operation::Read, File::Type::Xml> readbad(
+          "test_atm_test012t.xml");
+      readAtm(readbad, bad);
+    } catch (std::exception &e) {
+      return std::string(e.what());
+    }
+    return std::string();
+  };
+  const std::string sign_error = text_error("<Data>\n", "<Data>\n+-");
+  const std::string extra_error = text_error("</Data>", " 1\n</Data>");
+
+  // A header that does not fit the data
+  {
+    std::ifstream is("test_atm_test012b.xml");
+    std::string xml((std::istreambuf_iterator<char>(is)),
+                    std::istreambuf_iterator<char>());
+    is.close();
+    const auto pos = xml.find("Bytes=\"");
+    xml.insert(pos + 7, "1");
+    std::ofstream os("test_atm_test012b.xml");
+    os << xml;
+  }
+  std::string error;
+  try {
+    Atmosphere::Atm bad;
+    File::File<File::Operation::ReadBinary, File::Type::Xml> readbad(
+        "test_atm_test012b.xml");
+    readAtm(readbad, bad);
+  } catch (std::exception &e) {
+    error = e.what();
+  }
+
+  std::cout << "Read " << nalt * nlat * nlon
+            << " points of text by string stream: " << tstream
+            << " s, by readAtm: " << tascii
+            << " s\nText read as by string stream (expects 1): "
+            << same_fields(ascii, ref) << "\nRead binary fields: " << tbinary
+            << " s, binary points: " << tpoints
+            << " s\nBinary fields read as written (expects 1): "
+            << same_fields(binary, atm)
+            << "\nBinary points read as written (expects 1): "
+            << same_fields(points, atm)
+            << "\nWrong size in the header throws (expects 1): "
+            << (not error.empty())
+            << "\nA sign after a sign throws (expects this):\n"
+            << sign_error
+            << "Values after the last point throw (expects this):\n"
+            << extra_error;
+}
+
 int main() {
   std::cout << "Tests of the Atmosphere namespace\n";
   std::cout << '\n'
@@ -300,4 +705,12 @@ int main() {
             << "Calc just two points to see how they change with altitude"
             << '\n';
   test008();  // Calc just two points to see how they change with altitude
+  std::cout << '\n' << "Grid point search of a fine atmosphere" << '\n';
+  test009();  // Grid point search of a fine atmosphere
+  std::cout << '\n' << "Interpolation without allocations" << '\n';
+  test010();  // Interpolation without allocations
+  std::cout << '\n' << "Points as views of the fields" << '\n';
+  test011();  // Points as views of the fields
+  std::cout << '\n' << "Reading atmospheres of many points" << '\n';
+  test012();  // Reading atmospheres of many points
 }
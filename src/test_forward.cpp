@@ -74,7 +74,7 @@ void test001() {
       Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
       Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
   Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0, 0.7};
-  band.Lines()[0] =
+  band.EditLines()[0] =
       Absorption::Line(O266, 100e9, 1e-16, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
 
   constexpr size_t nfreq = 11;
@@ -175,7 +175,7 @@ void test002() {
       Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
       Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
   Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0, 0.7};
-  band.Lines()[0] =
+  band.EditLines()[0] =
       Absorption::Line(O266, 100e9, 1e-16, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
 
   constexpr size_t nfreq = 21;
@@ -198,8 +198,246 @@ void test002() {
   //   std::cout << conv.jac << '\n';
 }
 
+void test003() {
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+
+  auto x = Geom::Pos<Geom::PosType::Xyz>({0, a + 90001, 0});
+  auto dx = Geom::Los<Geom::LosType::Xyz>({1, -1, 1});
+  auto n = Geom::Nav(x, dx, wgs84);
+
+  constexpr size_t N = 46;
+  std::vector<Altitude<AltitudeType::meter>> A = {
+      -7.282161e+02, 0.000000e+00, 1.000000e+03, 2.000000e+03, 3.000000e+03,
+      4.000000e+03,  5.000000e+03, 6.000000e+03, 7.000000e+03, 8.000000e+03,
+      9.000000e+03,  1.000000e+04, 1.100000e+04, 1.200000e+04, 1.300000e+04,
+      1.400000e+04,  1.500000e+04, 1.600000e+04, 1.700000e+04, 1.800000e+04,
+      1.900000e+04,  2.000000e+04, 2.100000e+04, 2.200000e+04, 2.300000e+04,
+      2.400000e+04,  2.500000e+04, 2.750000e+04, 3.000000e+04, 3.250000e+04,
+      3.500000e+04,  3.750000e+04, 4.000000e+04, 4.250000e+04, 4.500000e+04,
+      4.750000e+04,  5.000000e+04, 5.500000e+04, 6.000000e+04, 6.500000e+04,
+      7.000000e+04,  7.500000e+04, 8.000000e+04, 8.500000e+04, 9.000000e+04,
+      9.500000e+04};
+  std::vector<double> P = {
+      110000, 101300, 90400, 80500, 71500, 63300, 55900, 49200, 43200, 37800,
+      32900,  28600,  24700, 21300, 18200, 15600, 13200, 11100, 9370,  7890,
+      6660,   5650,   4800,  4090,  3500,  3000,  2570,  1763,  1220,  852,
+      600,    426,    305,   220,   159,   116,   85.4,  45.6,  23.9,  12.1,
+      5.8,    2.6,    1.1,   0.44,  0.172, 0.069};
+  std::vector<double> T = {
+      2.997000e+02, 2.997000e+02, 2.937000e+02, 2.877000e+02, 2.837000e+02,
+      2.770000e+02, 2.703000e+02, 2.636000e+02, 2.570000e+02, 2.503000e+02,
+      2.436000e+02, 2.370000e+02, 2.301000e+02, 2.236000e+02, 2.170000e+02,
+      2.103000e+02, 2.037000e+02, 1.970000e+02, 1.948000e+02, 1.988000e+02,
+      2.027000e+02, 2.067000e+02, 2.107000e+02, 2.146000e+02, 2.170000e+02,
+      2.192000e+02, 2.214000e+02, 2.270000e+02, 2.323000e+02, 2.377000e+02,
+      2.431000e+02, 2.485000e+02, 2.540000e+02, 2.594000e+02, 2.648000e+02,
+      2.696000e+02, 2.702000e+02, 2.634000e+02, 2.531000e+02, 2.360000e+02,
+      2.189000e+02, 2.018000e+02, 1.848000e+02, 1.771000e+02, 1.770000e+02,
+      1.843000e+02};
+
+  Atmosphere::Point ap = Atmosphere::Point(
+      P[0], T[0], std::array<double, 3>{10e-6, 10e-6, 30e-6},
+      std::array<double, 3>{10., 1., 0.1},
+      std::vector<VMR<VMRType::ratio>>{
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                              0.78},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                              0.2095},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
+                              400e-06}});
+  Atmosphere::Atm atm({Time()}, A, {0}, {0}, {3, 1, N, 1, 1});
+  for (size_t i = 0; i < N; i++)
+    atm(0, i, 0, 0) = Atmosphere::Point(
+        P[i], T[i], std::array<double, 3>{10e-6, 10e-6, 30e-6},
+        std::array<double, 3>{10., 1., 0.1},
+        std::vector<VMR<VMRType::ratio>>{
+            VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                                0.78},
+            VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                                0.2095},
+            VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
+                                400e-06 - 5e-6 * i}});
+  const Species::Isotope O266(Species::Species::Oxygen, 0),
+      H2O161(Species::Species::Water, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
+  Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0, 0.7};
+  band.EditLines()[0] =
+      Absorption::Line(O266, 100e9, 1e-16, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+
+  constexpr size_t nfreq = 11;
+  constexpr Frequency<FrequencyType::Freq> flow = 90e9;
+  constexpr Frequency<FrequencyType::Freq> fupp = 110e9;
+  auto f = linspace(flow, fupp, nfreq);
+  auto rad0 = RTE::source_vec_planck<1>(299.7, f);
+
+  const Path::Tolerance tolerance{0.02, 0.5, 0.01, 2e3};
+  const auto fixed = Path::calc_single_geometric_path(n, atm, 100, 90e3);
+  const auto adaptive =
+      Path::calc_single_geometric_path(n, atm, 100, 90e3, tolerance);
+
+  // Every point left out is within tolerance of the kept points around it
+  bool within = adaptive.second == fixed.second;
+  std::vector<double> s(fixed.first.size(), 0);
+  for (size_t i = 1; i < s.size(); i++)
+    s[i] = s[i - 1] + Path::dist(fixed.first[i - 1], fixed.first[i]);
+  size_t first = 0, last = 0;
+  for (size_t i = 0, k = 0; i < fixed.first.size(); i++) {
+    if (k < adaptive.first.size() and
+        Path::dist(fixed.first[i], adaptive.first[k]) == 0.0) {
+      first = i;
+      last = i;
+      k++;
+      while (last + 1 < fixed.first.size() and k < adaptive.first.size() and
+             Path::dist(fixed.first[last], adaptive.first[k]) not_eq 0.0)
+        last++;
+      within = within and s[last] - s[first] <= tolerance.max_dist * (1 + 1e-9);
+      continue;
+    }
+    const auto &pa = fixed.first[first].atm, &pi = fixed.first[i].atm,
+               &pb = fixed.first[last].atm;
+    const double x = (s[i] - s[first]) / (s[last] - s[first]);
+    const double lp = std::log(pa.Pres()) +
+                      x * (std::log(pb.Pres()) - std::log(pa.Pres()));
+    const double t = pa.Temp() + x * (pb.Temp() - pa.Temp());
+    const double wa = pa.VolumeMixingRatio(H2O161),
+                 wi = pi.VolumeMixingRatio(H2O161),
+                 wb = pb.VolumeMixingRatio(H2O161);
+    within = within and
+             std::abs(std::log(pi.Pres()) - lp) <= tolerance.log_p and
+             std::abs(pi.Temp() - t) <= tolerance.t and
+             std::abs(wi - wa - x * (wb - wa)) <=
+                 tolerance.vmr * std::max({wa, wi, wb});
+  }
+
+  // Once before timing, so that neither timing pays for first use
+  RTE::Forward::compute(rad0, f, {Derivative::Atm::Temperature}, {band},
+                        adaptive.first);
+  Time start;
+  const auto out_fixed = RTE::Forward::compute(
+      rad0, f, {Derivative::Atm::Temperature}, {band}, fixed.first);
+  const double tfixed = TimeStep(Time() - start).count();
+  start = Time();
+  const auto out_adaptive = RTE::Forward::compute(
+      rad0, f, {Derivative::Atm::Temperature}, {band}, adaptive.first);
+  const double tadaptive = TimeStep(Time() - start).count();
+
+  double diff = 0;
+  for (size_t iv = 0; iv < nfreq; iv++)
+    diff = std::max(diff, std::abs(out_adaptive.x(0, iv)[0] /
+                                       out_fixed.x(0, iv)[0] -
+                                   1));
+
+  std::cout << "Points of 100 m steps: " << fixed.first.size()
+            << ", adaptive: " << adaptive.first.size()
+            << "\nPoints left out are within tolerance (expects 1): " << within
+            << "\nForward model of 100 m steps: " << tfixed
+            << " s, adaptive: " << tadaptive << " s, speedup "
+            << tfixed / tadaptive
+            << "\nLargest relative difference of the radiance: " << diff
+            << '\n';
+}
+
+void test004() {
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+
+  auto x = Geom::Pos<Geom::PosType::Xyz>({0, a + 90001, 0});
+  auto dx = Geom::Los<Geom::LosType::Xyz>({1, -1, 1});
+  auto n = Geom::Nav(x, dx, wgs84);
+
+  // An atmosphere every 10 km with a scale height of 7 km
+  constexpr size_t N = 11;
+  const std::vector<VMR<VMRType::ratio>> vmr{
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                          0.78},
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                          0.2095},
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
+                          400e-06}};
+  std::vector<Altitude<AltitudeType::meter>> A;
+  std::vector<Pressure<PressureType::Pa>> P;
+  std::vector<Temperature<TemperatureType::K>> T;
+  for (size_t i = 0; i < N; i++) {
+    const double z = 10e3 * double(i);
+    A.push_back(z);
+    P.push_back(101300 * std::exp(-z / 7e3));
+    T.push_back(std::max(290 - 6.5e-3 * z, 210.0));
+  }
+  Atmosphere::Atm atm({Time()}, A, {0}, {0}, {3, 1, N, 1, 1});
+  for (size_t i = 0; i < N; i++)
+    atm(0, i, 0, 0) = Atmosphere::Point(
+        P[i], T[i], std::array<double, 3>{10e-6, 10e-6, 30e-6},
+        std::array<double, 3>{10., 1., 0.1}, vmr);
+  const auto path = Path::calc_single_geometric_path(n, atm, 1e3, 90e3);
+
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
+  Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0, 0.7};
+  band.EditLines()[0] =
+      Absorption::Line(O266, 100e9, 1e-16, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+
+  constexpr size_t nfreq = 11;
+  constexpr Frequency<FrequencyType::Freq> flow = 90e9;
+  constexpr Frequency<FrequencyType::Freq> fupp = 110e9;
+  auto f = linspace(flow, fupp, nfreq);
+  auto rad0 = RTE::source_vec_planck<1>(T.front(), f);
+
+  // The same profile every 2.5 km for the table
+  std::vector<Pressure<PressureType::Pa>> Ptab;
+  std::vector<Temperature<TemperatureType::K>> Ttab;
+  for (size_t i = 0; i <= 40; i++) {
+    const double z = 2.5e3 * double(i);
+    Ptab.push_back(101300 * std::exp(-z / 7e3));
+    Ttab.push_back(std::max(290 - 6.5e-3 * z, 210.0));
+  }
+  const std::vector<Absorption::Xsec::Lut::Table> tables{
+      Absorption::Xsec::Lut::Table({band}, f, Ptab, Ttab, {-30, -15, 0, 15, 30},
+                                   vmr)};
+  const auto out_lbl = RTE::Forward::compute(
+      rad0, f, {Derivative::Atm::Temperature}, {band}, path.first);
+  const auto out_lut = RTE::Forward::compute(
+      rad0, f, {Derivative::Atm::Temperature}, {}, path.first, tables);
+
+  double diff = 0;
+  for (size_t iv = 0; iv < nfreq; iv++)
+    diff = std::max(
+        diff, std::abs(out_lut.x(0, iv)[0] / out_lbl.x(0, iv)[0] - 1));
+  std::cout << "Largest relative difference of the radiance from a table "
+            << "(expects below 1e-4): " << diff << '\n';
+
+  try {
+    RTE::Forward::compute(rad0, f, {Derivative::Atm::WindU}, {}, path.first,
+                          tables);
+    std::cout << "A wind derivative from a table throws (expects this): "
+              << "did not throw\n";
+  } catch (std::runtime_error &e) {
+    std::cout << "A wind derivative from a table throws (expects this):\n"
+              << e.what();
+  }
+}
+
 int main() {
   //     test001();
   //   std::cout << "\n\n\n";
   test002();
+  std::cout << '\n' << "Forward model on adaptive paths" << '\n';
+  test003();  // Forward model on adaptive paths
+  test004();  // Forward model with a table of cross-sections
 }
@@ -1,4 +1,9 @@
+#include <complex>
+#include <cstdint>
+#include <utility>
+
 #include "grids.h"
+#include "timeclass.h"
 
 void test001() {
   Grid<double, 2> g(0, 4, 4);
@@ -21,4 +26,147 @@ void test001() {
             << '\n';
 }
 
-int main() { test001(); }
+/** The grid before elements were aligned, copied whole and indexed
+ * unchecked, for comparison */
+template <typename b, std::size_t n>
+class ReferenceGrid {
+  std::unique_ptr<b[]> ptr;
+  std::array<std::size_t, n> gridsize;
+
+  std::size_t nelem() const {
+    return std::reduce(gridsize.cbegin(), gridsize.cend(), std::size_t(1),
+                       std::multiplies<std::size_t>());
+  }
+
+  std::size_t index(std::array<std::size_t, n> ind) const noexcept {
+    std::size_t posmul{gridsize.back()};
+    std::size_t pos{ind.back()};
+    for (std::size_t i{n - 2}; i < n; i--) {
+      pos += posmul * ind[i];
+      posmul *= gridsize[i];
+      if (ind[i] >= gridsize[i]) {
+        std::cerr << "Out of range\n";
+        std::terminate();
+      }
+    }
+    return pos;
+  }
+
+ public:
+  template <typename... Inds>
+  ReferenceGrid(const b &fillval, Inds... inds)
+      : ptr(std::make_unique<b[]>(mul(inds...))),
+        gridsize({std::size_t(inds)...}) {
+    for (std::size_t i = 0; i < nelem(); i++) ptr[i] = fillval;
+  }
+
+  ReferenceGrid(const ReferenceGrid &g) noexcept
+      : ptr(std::make_unique<b[]>(g.nelem())), gridsize(g.gridsize) {
+    const std::size_t end = nelem();
+    for (size_t i = 0; i < end; i++) ptr[i] = g.ptr[i];
+  }
+
+  template <typename... Inds>
+  b &operator()(Inds... inds) noexcept {
+    return ptr[index(std::array<std::size_t, n>{std::size_t(inds)...})];
+  }
+};  // ReferenceGrid
+
+void test002() {
+  constexpr std::size_t n0 = 20, n1 = 200, n2 = 500, nrep = 10;
+  Grid<double, 3> g(0, n0, n1, n2);
+  ReferenceGrid<double, 3> r(0, n0, n1, n2);
+  for (std::size_t i = 0; i < n0; i++)
+    for (std::size_t j = 0; j < n1; j++)
+      for (std::size_t k = 0; k < n2; k++)
+        r(i, j, k) = g(i, j, k) = double(i + j + k);
+
+  // Sums over all elements by each accessor
+  auto time_sum = [&](auto &&get) {
+    double sum = 0;
+    const Time start;
+    for (std::size_t rep = 0; rep < nrep; rep++)
+      for (std::size_t i = 0; i < n0; i++)
+        for (std::size_t j = 0; j < n1; j++)
+          for (std::size_t k = 0; k < n2; k++) sum += get(i, j, k);
+    return std::pair{TimeStep(Time() - start).count(), sum};
+  };
+  const auto ref =
+      time_sum([&](auto i, auto j, auto k) -> double { return r(i, j, k); });
+  const auto checked =
+      time_sum([&](auto i, auto j, auto k) -> double { return g(i, j, k); });
+  const auto unchecked = time_sum(
+      [&](auto i, auto j, auto k) -> double { return g.unchecked(i, j, k); });
+
+  // The sub-grid of the middle of axis 1 by pointer and strides
+  Sub s(g, 1, n1 / 2);
+  const double *p = s.data();
+  bool same = true;
+  for (std::size_t i = 0; i < n0; i++)
+    for (std::size_t k = 0; k < n2; k++)
+      same = same and
+             p[i * s.stride(0) + k * s.stride(1)] == g(i, n1 / 2, k) and
+             &s(i, k) == &g(i, n1 / 2, k);
+
+  std::cout << "Sum of " << n0 * n1 * n2 << " elements " << nrep
+            << " times, reference: " << ref.first << " s, checked: "
+            << checked.first << " s, unchecked: " << unchecked.first
+            << " s\nSame sums (expects 1): "
+            << (ref.second == checked.second and
+                ref.second == unchecked.second)
+            << "\nSub-grid by pointer and strides as by index (expects 1): "
+            << same << '\n';
+}
+
+void test003() {
+  constexpr std::size_t n0 = 50, n1 = 100, n2 = 1000, nrep = 5;
+  using Complex = std::complex<double>;
+  const Grid<Complex, 3> g(Complex(1, 2), n0, n1, n2);
+  const ReferenceGrid<Complex, 3> r(Complex(1, 2), n0, n1, n2);
+
+  Time start;
+  for (std::size_t rep = 0; rep < nrep; rep++) {
+    ReferenceGrid<Complex, 3> copy(r);
+    copy(rep, 0, 0) = 0;
+  }
+  const double tref = TimeStep(Time() - start).count();
+
+  start = Time();
+  for (std::size_t rep = 0; rep < nrep; rep++) {
+    Grid<Complex, 3> copy(g);
+    copy(rep, 0, 0) = 0;
+  }
+  const double tcopy = TimeStep(Time() - start).count();
+
+  Grid<Complex, 3> a(Complex(0, 0), n0, n1, n2);
+  start = Time();
+  for (std::size_t rep = 0; rep < nrep; rep++) a = g;
+  const double tassign = TimeStep(Time() - start).count();
+
+  Grid<Complex, 3> c(Complex(3, 4), 1, 1, 1);
+  start = Time();
+  for (std::size_t rep = 0; rep < nrep; rep++) {
+    using std::swap;
+    swap(a, c);
+  }
+  const double tswap = TimeStep(Time() - start).count();
+  Grid<Complex, 3> m(std::move(c));
+  c = std::move(a);
+
+  std::cout << "Copy of " << n0 * n1 * n2 << " complex elements " << nrep
+            << " times, reference: " << tref << " s, copy: " << tcopy
+            << " s, assignment: " << tassign << " s, swap: " << tswap
+            << " s\nElements aligned to 64 bytes (expects 1): "
+            << (reinterpret_cast<std::uintptr_t>(g.data()) % 64 == 0)
+            << "\nAssigned and moved grids keep their elements (expects 1 1): "
+            << (c(0, 0, 0) == Complex(3, 4)) << ' '
+            << (m(n0 - 1, n1 - 1, n2 - 1) == Complex(1, 2)) << '\n';
+}
+
+int main() {
+  test001();
+  std::cout << '\n' << "Accessors of a grid" << '\n';
+  test002();  // Accessors of a grid
+  std::cout << '\n' << "Copies and moves of a grid" << '\n';
+  test003();  // Copies and moves of a grid
+}
@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
 #include "file.h"
 #include "hitran.h"
 #include "lbl.h"
+#include "timeclass.h"
 
 void test001(std::string file) {
   File::File<File::Operation::Read, File::Type::Raw> f(file);
@@ -15,6 +22,144 @@ void test001(std::string file) {
   //   wbin(file+"bin.xml"); saveBands(wbin, bands); wbin.close();
 }
 
+std::string bands_as_text(const std::vector<Absorption::Band> &bands,
+                          const std::string &file) {
+  {
+    File::File<File::Operation::Write, File::Type::Xml> out(file);
+    saveBands(out, bands);
+    out.close();
+  }
+  std::ifstream in(file);
+  std::ostringstream os;
+  os << in.rdbuf();
+  std::filesystem::remove(file);
+  return os.str();
+}
+
+/** Writes a synthetic catalog of N lines of CO in 10 bands, sorted by
+ * frequency from 2000 cm-1 on.  The bands take turns line by line, or with
+ * blocks each take a tenth of the catalog */
+void write_synthetic(const std::string &file, std::size_t N, bool blocks) {
+  std::ofstream out(file);
+  char rec[256];
+  for (std::size_t i = 0; i < N; i++) {
+    const std::size_t b = blocks ? 10 * i / N : i % 10;
+    const int vu = int(b % 5) + 1;
+    const int J = int(i / 10) % 80;
+    const char *label = b < 5 ? "X" : "A";
+    std::snprintf(rec, sizeof rec,
+                  "%2d%1d%12.6f%10.3E%10.3E%5.3f%5.3f%10.4f%4.2f%8.5f"
+                  "%15s%15s%15s%15s%6s%12s%1s%7.1f%7.1f",
+                  5, 1, 2000.0 + 0.01 * double(i), 1e-20 * (1 + double(J)),
+                  1.5 + double(vu), 0.05, 0.06, 10.0 * double(J * (J + 1)),
+                  0.68, -0.003, "", "", "", "", "000000", "000000000000", " ",
+                  double(2 * J + 3), double(2 * J + 1));
+    out << rec << ' ' << "ElecStateLabel=" << label << ";v=" << vu
+        << ";J=" << J + 1 << ";\tElecStateLabel=" << label << ";v=" << vu - 1
+        << ";J=" << J << ";\n";
+  }
+}
+
+void test002() {
+  const std::string file = "test_hitran_test002.par";
+  constexpr std::size_t N = 100'000;
+  write_synthetic(file, N, false);
+
+  const double flow = 2100.005 * 29'979'245'800.0;
+  const double fupp = 2900.005 * 29'979'245'800.0;
+  for (auto [lo, hi] : {std::pair{-1.0, 1e99}, std::pair{flow, fupp}}) {
+    const Time t0;
+    File::File<File::Operation::Read, File::Type::Raw> in(file);
+    auto serial = Absorption::parse_hitran_with_qns(in, lo, hi);
+    const Time t1;
+    auto mapped = Absorption::parse_hitran_with_qns(file, lo, hi);
+    const Time t2;
+
+    std::size_t nlines = 0;
+    for (auto &band : mapped) nlines += band.n_lines();
+    std::cout << mapped.size() << " bands (expects 10) of " << nlines
+              << " lines (expects " << (lo < 0 ? N : 80'000) << "), same as "
+              << "line by line: "
+              << (bands_as_text(serial, file + ".a.xml") ==
+                  bands_as_text(mapped, file + ".b.xml"))
+              << " (expects 1)\n";
+    std::cerr << "Line by line " << TimeStep(t1 - t0).count()
+              << " s, mapped " << TimeStep(t2 - t1).count() << " s\n";
+  }
+  std::filesystem::remove(file);
+}
+
+void test003() {
+  const std::string file = "test_hitran_test003.par";
+  const std::string cat = "test_hitran_test003.cat";
+  constexpr std::size_t N = 100'000;
+  constexpr double kayser = 29'979'245'800.0;
+  write_synthetic(file, N, true);
+  const auto bands = Absorption::parse_hitran_with_qns(file, -1, 1e99);
+  Absorption::saveCatalog(cat, bands);
+
+  const Time t0;
+  const auto all = Absorption::readBands(cat, -1, 1e99);
+  const Time t1;
+  std::cout << all.size() << " bands (expects 10), same as saved: "
+            << (bands_as_text(bands, file + ".a.xml") ==
+                bands_as_text(all, file + ".b.xml"))
+            << " (expects 1)\n";
+
+  // Only the third and fourth band have lines in the range
+  const double flow = 2199.995 * kayser;
+  const double fupp = 2399.995 * kayser;
+  const Time t2;
+  const auto some = Absorption::readBands(cat, flow, fupp);
+  const Time t3;
+  std::cout << some.size() << " bands (expects 2), same as saved: "
+            << (bands_as_text({bands[2], bands[3]}, file + ".a.xml") ==
+                bands_as_text(some, file + ".b.xml"))
+            << " (expects 1)\n";
+
+  const Absorption::Catalog catalog(cat);
+  const auto [first, last] = catalog.lines(flow, fupp);
+  bool sorted = std::is_sorted(first, last, [](auto &a, auto &b) {
+    return a.f0 < b.f0;
+  });
+  bool found = std::all_of(first, last, [&](auto &l) {
+    return bands[l.band].Lines()[l.line].F0() == l.f0;
+  });
+  std::cout << last - first << " lines (expects 20000), sorted " << sorted
+            << " (expects 1), of their bands " << found << " (expects 1)\n";
+
+  try {
+    Absorption::Catalog bad(file);
+    std::cout << "Read a .par file as a catalog (expects an error)\n";
+  } catch (std::runtime_error &e) {
+    std::cout << "Error: " << e.what() << " (expects an error)\n";
+  }
+
+  // A line shape out of range in the first band
+  {
+    std::fstream io(cat, std::ios::in | std::ios::out | std::ios::binary);
+    std::uint64_t offset;
+    io.seekg(32 + 24);
+    io.read(reinterpret_cast<char *>(&offset), sizeof offset);
+    const std::int64_t shape = 99;
+    io.seekp(std::streamoff(offset + 6 * sizeof shape));
+    io.write(reinterpret_cast<const char *>(&shape), sizeof shape);
+  }
+  try {
+    Absorption::readBands(cat, -1, 1e99);
+    std::cout << "Read a catalog with a bad line shape (expects an error)\n";
+  } catch (std::runtime_error &e) {
+    std::cout << "Error: " << e.what() << " (expects an error)\n";
+  }
+
+  std::cerr << "All bands " << TimeStep(t1 - t0).count() << " s, two bands "
+            << TimeStep(t3 - t2).count() << " s\n";
+  std::filesystem::remove(file);
+  std::filesystem::remove(cat);
+}
+
 int main(int argc, char **argv) {
   if (argc == 2) test001(std::string{argv[1]});
+  test002();
+  test003();
 }
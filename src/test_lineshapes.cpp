@@ -1,6 +1,8 @@
+#include "faddeeva.h"
 #include "lbl.h"
 #include "lineshapes.h"
 #include "mathhelpers.h"
+#include "timeclass.h"
 
 void test001() {
   constexpr double T = 275;
@@ -28,7 +30,7 @@ void test001() {
       Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
   const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3,
                                        300, 0.7};
-  band.Lines()[0] =
+  band.EditLines()[0] =
       Absorption::Line(O266, 100e9, 1e-18, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
   auto& line = band.Lines()[0];
   const double GDpart = band.GD_giv_F0(T);
@@ -59,7 +61,47 @@ void test001() {
   }
 }
 
+void test002() {
+  // Arguments from the line center to far into the wings, as seen by the
+  // line shapes, and a few in the lower half-plane
+  std::vector<Complex> z;
+  for (double y : {0.0, 1e-6, 1e-3, 0.1, 1.0, 5.0, 20.0, 1e3})
+    for (double x : linspace(-50.0, 50.0, 10001)) z.emplace_back(x, y);
+  for (double x : linspace(-10.0, 10.0, 101)) z.emplace_back(x, -0.5);
+
+  std::vector<Complex> batch(z.size());
+  Faddeeva::w(z.data(), batch.data(), z.size());
+
+  double max_err = 0;
+  for (std::size_t i = 0; i < z.size(); i++)
+    max_err = std::max(max_err, std::abs(batch[i] - Faddeeva::w(z[i])) /
+                                    std::abs(Faddeeva::w(z[i])));
+  std::cout << "Max relative error of " << z.size()
+            << " batched Faddeeva evaluations (expects below 1e-13): "
+            << max_err << '\n';
+
+  constexpr std::size_t n = 100;
+  Complex sum = 0;
+
+  const Time start_scalar;
+  for (std::size_t j = 0; j < n; j++)
+    for (auto& x : z) sum += Faddeeva::w(x);
+  const double t_scalar = TimeStep(Time() - start_scalar).count();
+
+  const Time start_batch;
+  for (std::size_t j = 0; j < n; j++) {
+    Faddeeva::w(z.data(), batch.data(), z.size());
+    for (auto& x : batch) sum -= x;
+  }
+  const double t_batch = TimeStep(Time() - start_batch).count();
+
+  std::cout << "Scalar: " << t_scalar << " s, batched: " << t_batch
+            << " s, speedup " << t_scalar / t_batch << " (checksum "
+            << std::abs(sum) << ")\n";
+}
+
 int main() {
   std::setprecision(20);
   test001();  // Test Voigt Line Shape and some derivatives
+  test002();  // Test the batched Faddeeva function against the scalar one
 }
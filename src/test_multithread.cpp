@@ -13,10 +13,73 @@ int test001(double time, int n, char x) {
   return n;
 }
 
+void test002() {
+  Multithread::Configure(1, 4, 1);
+  std::cout << "Threads per arena (expects 1 4 1): "
+            << Multithread::Concurrency(Multithread::Arena::Acquisition) << ' '
+            << Multithread::Concurrency(Multithread::Arena::Compute) << ' '
+            << Multithread::Concurrency(Multithread::Arena::Background)
+            << '\n';
+
+  auto x = Multithread::submit(Multithread::Arena::Background,
+                               [] { return 42; });
+  std::cout << "submit (expects 42): " << x.get() << '\n';
+
+  std::vector<double> v(1000);
+  Multithread::parallel_for(Multithread::Arena::Compute, 0, v.size(),
+                            [&v](std::size_t i) { v[i] = 0.1 * double(i); })
+      .get();
+  std::cout << "parallel_for (expects 99.9): " << v.back() << '\n';
+
+  auto sum = Multithread::parallel_reduce(
+      Multithread::Arena::Compute, 0, v.size(), 0.0,
+      [&v](std::size_t i) { return v[i]; },
+      [](double a, double b) { return a + b; }, 10);
+  std::cout << "parallel_reduce (expects 49950): " << sum.get() << '\n';
+
+  // Occupy the single acquisition thread so that the next task cannot start
+  auto block = Multithread::submit(Multithread::Arena::Acquisition,
+                                   [] { Sleep(0.1); });
+  auto never = Multithread::submit(Multithread::Arena::Acquisition, [] {
+    std::cout << "This should never be printed\n";
+  });
+  never.cancel();
+  block.get();
+  try {
+    never.get();
+    std::cout << "cancel: not cancelled\n";
+  } catch (const Multithread::Cancelled &e) {
+    std::cout << "cancel: " << e.what() << '\n';
+  }
+
+  // Cancel a running loop
+  std::atomic<std::size_t> count{0};
+  auto loop = Multithread::parallel_for(
+      Multithread::Arena::Compute, 0, 1'000'000, [&count](std::size_t) {
+        count++;
+        Sleep(0.0001);
+      });
+  Sleep(0.05);
+  loop.cancel();
+  try {
+    loop.get();
+    std::cout << "cancel loop: not cancelled\n";
+  } catch (const Multithread::Cancelled &e) {
+    std::cout << "cancel loop: " << e.what() << " (expects only part of "
+              << "1000000 iterations: " << (count < 1'000'000) << ")\n";
+  }
+}
+
 int main() {
-  auto x1 = Async(test001, 0.00005, 120, 'x');
-  auto x2 = Async(test001, 0.0001, 60, 'a');
-  auto x3 = Async(test001, 0.0002, 30, 'b');
-  auto x4 = Async(test001, 0.0004, 15, 'c');
-  auto x5 = Async(test001, 0.0008, 8, 'd');
+  {
+    auto x1 = Async(test001, 0.00005, 120, 'x');
+    auto x2 = Async(test001, 0.0001, 60, 'a');
+    auto x3 = Async(test001, 0.0002, 30, 'b');
+    auto x4 = Async(test001, 0.0004, 15, 'c');
+    auto x5 = Async(test001, 0.0008, 8, 'd');
+  }
+
+  std::cout << "---------------------------------------Executor\n";
+  test002();  // Test the task arenas
+  std::cout << "---------------------------------------\n";
 }
@@ -1,3 +1,7 @@
+#include <filesystem>
+#include <utility>
+
+#include "allocations.h"
 #include "mathhelpers.h"
 #include "xsec.h"
 
@@ -34,7 +38,7 @@ void test001() {
       Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
   const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
                                        0.7};
-  band.Lines()[0] =
+  band.EditLines()[0] =
       Absorption::Line(O266, 100e9, 1e-18, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
 
   for (double P : {1, 10, 100, 1000, 10000, 100000}) {
@@ -59,9 +63,10 @@ void test001() {
     const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature,
                                                  Derivative::Atm::WindU};
 
+    Absorption::PropagationMatrix::Workspace ws;
     Absorption::PropagationMatrix::Results<1> res(f.size(), derivs.size());
     Absorption::PropagationMatrix::Results<1> src(f.size(), derivs.size());
-    Absorption::PropagationMatrix::compute(res, src, f, {band}, p, derivs);
+    Absorption::PropagationMatrix::compute(res, src, ws, f, {band}, p, derivs);
 
     const Atmosphere::Point ap_T(
         P, T + 0.1, std::array<double, 3>{mu, mv, mw},
@@ -74,8 +79,8 @@ void test001() {
             VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
                                 vmrh2o}});
     Absorption::PropagationMatrix::Results<1> resdT(f.size(), derivs.size());
-    Absorption::PropagationMatrix::compute(resdT, src, f, {band}, {nav, ap_T},
-                                           derivs);
+    Absorption::PropagationMatrix::compute(resdT, src, ws, f, {band},
+                                           {nav, ap_T}, derivs);
 
     const Atmosphere::Point ap_wu(
         P, T, std::array<double, 3>{mu, mv, mw},
@@ -91,7 +96,7 @@ void test001() {
                                                p.nav.sphericalLos().aa());
     const auto f_wu = scale(fsensor, fscale_wu);
     Absorption::PropagationMatrix::Results<1> resdwu(f.size(), derivs.size());
-    Absorption::PropagationMatrix::compute(resdwu, src, f_wu, {band},
+    Absorption::PropagationMatrix::compute(resdwu, src, ws, f_wu, {band},
                                            {nav, ap_wu}, derivs);
 
     std::cout << "At Pressure (" << P << " Pa):\n";
@@ -107,4 +112,177 @@ void test001() {
   }
 }
 
-int main() { test001(); }
+void test002() {
+  constexpr size_t nfreq = 1001;
+  constexpr size_t ncalls = 100;
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+  const auto nav = Geom::Nav(Geom::Pos<Geom::PosType::Xyz>({0, a + 1, 0}),
+                             Geom::Los<Geom::LosType::Xyz>({1, 1, 1}), wgs84);
+  const Atmosphere::Point ap = Atmosphere::Point(
+      1000, 275, std::array<double, 3>{10e-6, 10e-6, 30e-6},
+      std::array<double, 3>{10, 1, 0.1},
+      std::vector<VMR<VMRType::ratio>>{
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                              0.78},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                              0.2095}});
+  const Path::Point p = {nav, ap};
+
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
+                                       0.7};
+  std::vector<Absorption::Band> bands;
+  for (size_t nlines : {10, 1000}) {
+    Absorption::Band band(
+        O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+        Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+        Absorption::Shape::VP, false, 296, 750e9, g, g, nlines);
+    for (size_t i = 0; i < nlines; i++)
+      band.EditLines()[i] =
+          Absorption::Line(O266, 90e9 + 20e6 * double(i), 1e-18, 1e-20, {0, 0},
+                           1, 1, 1e-20, l, l, m);
+    bands.push_back(band);
+  }
+
+  const auto f = linspace<Frequency<FrequencyType::Freq>>(80e9, 120e9, nfreq);
+  const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature};
+  Absorption::PropagationMatrix::Results<1> res(f.size(), derivs.size());
+  Absorption::PropagationMatrix::Results<1> src(f.size(), derivs.size());
+
+  // The first call of a workspace sizes it, the later ones must not allocate
+  std::cout << "Heap allocations of " << ncalls << " calls with a workspace:\n";
+  const std::vector<Absorption::Band> one{bands.back()};
+  for (auto *b : {&one, &std::as_const(bands)}) {
+    Absorption::PropagationMatrix::Workspace ws;
+    Absorption::PropagationMatrix::compute(res, src, ws, f, *b, p, derivs);
+    const std::size_t before = allocations;
+    for (size_t i = 0; i < ncalls; i++)
+      Absorption::PropagationMatrix::compute(res, src, ws, f, *b, p, derivs);
+    std::cout << b->size() << " band(s) (expects 0): " << allocations - before
+              << '\n';
+  }
+}
+
+void test003() {
+  constexpr size_t nfreq = 2001;
+  constexpr size_t nlines = 50;
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+  const auto nav = Geom::Nav(Geom::Pos<Geom::PosType::Xyz>({0, a + 1, 0}),
+                             Geom::Los<Geom::LosType::Xyz>({1, 1, 1}), wgs84);
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<VMR<VMRType::ratio>> vmr{
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                          0.78},
+      VMR<VMRType::ratio>{O266, 0.2095}};
+
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
+                                       0.7};
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 750e9, g, g, nlines);
+  for (size_t i = 0; i < nlines; i++)
+    band.EditLines()[i] =
+        Absorption::Line(O266, 90e9 + 400e6 * double(i), 1e-18, 1e-20,
+                         {0, 0}, 1, 1, 1e-20 * double(i + 1), l, l, m);
+  const std::vector<Absorption::Band> bands{band};
+  const auto f = linspace<Frequency<FrequencyType::Freq>>(80e9, 120e9, nfreq);
+
+  // Eight pressures per decade from 1 Pa to 1000 hPa, perturbations of 20 K
+  std::vector<Pressure<PressureType::Pa>> P;
+  std::vector<Temperature<TemperatureType::K>> T;
+  for (int i = 0; i <= 40; i++) {
+    P.push_back(std::pow(10.0, 0.125 * i));
+    T.push_back(200 + 2 * i);
+  }
+  const Time start_table;
+  const Absorption::Xsec::Lut::Table table(bands, f, P, T,
+                                           {-40, -20, 0, 20, 40}, vmr);
+  const double ttable = TimeStep(Time() - start_table).count();
+
+  // Between the grid points of the table
+  std::vector<Path::Point> points;
+  const std::array<double, 3> zero{0, 0, 0};
+  for (int i = 0; i < 40; i++) {
+    const double dT = 11.0 * (i % 5) - 27;
+    points.push_back(Path::Point(
+        nav, Atmosphere::Point(std::pow(10.0, 0.125 * i + 0.05),
+                               200 + 2 * i + dT, zero, zero, vmr)));
+  }
+  std::cout << "Table of " << table.Pressures() << " pressures, "
+            << table.Temperatures() << " temperatures and " << f.size()
+            << " frequencies made in " << ttable << " s\nAgainst LBL "
+            << "(expects all below 1e-2): "
+            << Absorption::Xsec::Lut::compare(table, bands, points) << '\n';
+
+  // The same table from file
+  const auto path =
+      (std::filesystem::temp_directory_path() / "test_xsec_lut.xml").string();
+  {
+    File::File<File::Operation::WriteBinary, File::Type::Xml> file(path);
+    saveTable(file, table);
+    file.close();
+  }
+  Absorption::Xsec::Lut::Table copy;
+  {
+    File::File<File::Operation::ReadBinary, File::Type::Xml> file(path);
+    readTable(file, copy);
+  }
+  std::filesystem::remove(path);
+  std::filesystem::remove(path + ".bin");
+  const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature};
+  Absorption::Xsec::Lbl::Results r1(f.size(), 1), r2(f.size(), 1), src;
+  table.compute(r1, src, f, points[7], derivs);
+  copy.compute(r2, src, f, points[7], derivs);
+  std::cout << "Same after saving and reading (expects 1): "
+            << (r1.x == r2.x and r1.dx == r2.dx) << '\n';
+
+  // Other frequencies of the same count
+  auto shifted = f;
+  shifted.back() += 1;
+  try {
+    table.compute(r1, src, shifted, points[7], derivs);
+    std::cout << "Other frequencies throw (expects this): did not throw\n";
+  } catch (std::runtime_error &e) {
+    std::cout << "Other frequencies throw (expects this):\n" << e.what();
+  }
+
+  // Speed of the propagation matrix from lines and from the table
+  constexpr size_t ncalls = 20;
+  Absorption::PropagationMatrix::Results<1> res(f.size(), derivs.size());
+  Absorption::PropagationMatrix::Results<1> tmp(f.size(), derivs.size());
+  Absorption::PropagationMatrix::Workspace ws;
+  const Time start_lbl;
+  for (size_t i = 0; i < ncalls; i++)
+    Absorption::PropagationMatrix::compute(res, tmp, ws, f, bands,
+                                           points[i % points.size()], derivs);
+  const double tlbl = TimeStep(Time() - start_lbl).count();
+  const std::vector<Absorption::Xsec::Lut::Table> tables{table};
+  const Time start_lut;
+  for (size_t i = 0; i < ncalls; i++)
+    Absorption::PropagationMatrix::compute(res, tmp, ws, f, {},
+                                           points[i % points.size()], derivs,
+                                           tables);
+  const double tlut = TimeStep(Time() - start_lut).count();
+  std::cout << ncalls << " propagation matrices from lines: " << tlbl
+            << " s, from the table: " << tlut << " s, speedup " << tlbl / tlut
+            << '\n';
+}
+
+int main() {
+  test001();
+  test002();  // No allocations with a workspace
+  test003();  // Cross-sections from a table
+}
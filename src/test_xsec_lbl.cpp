@@ -1,3 +1,7 @@
+#include <tbb/global_control.h>
+
+#include <thread>
+
 #include "mathhelpers.h"
 #include "xsec_lbl.h"
 
@@ -82,14 +86,14 @@ void test002() {
       Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
       Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
   Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0, 0.7};
-  band.Lines()[0] =
+  band.EditLines()[0] =
       Absorption::Line(O266, 100e9, 1e-20, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
 
   constexpr size_t M = 100;
   std::vector<Absorption::Xsec::Lbl::Results> sum(
       N, Absorption::Xsec::Lbl::Results(M, 0));
   Absorption::Xsec::Lbl::Results dummy_src(M, 0);
-  Absorption::Xsec::Lbl::Results comp(M, 0);
+  Absorption::Xsec::Lbl::Workspace comp(M, 0);
   auto f = linspace<Frequency<FrequencyType::Freq>>(90e9, 110e9, M);
 
   for (size_t i = 0; i < N; i++) {
@@ -139,7 +143,7 @@ void test003() {
       Absorption::Shape::VP, false, 296, 750e9, g, g, 1);
   const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
                                        0.7};
-  band.Lines()[0] =
+  band.EditLines()[0] =
       Absorption::Line(O266, 100e9, 1e-18, 1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
 
   for (double P : {1, 10, 100, 1000, 10000, 100000}) {
@@ -165,7 +169,7 @@ void test003() {
 
     Absorption::Xsec::Lbl::Results lbl_res(f.size(), derivs.size());
     Absorption::Xsec::Lbl::Results lbl_src(f.size(), derivs.size());
-    Absorption::Xsec::Lbl::Results lbl_clc(f.size(), derivs.size());
+    Absorption::Xsec::Lbl::Workspace lbl_clc(f.size(), derivs.size());
     Absorption::Xsec::Lbl::compute(lbl_res, lbl_src, lbl_clc, f, band, p,
                                    derivs);
 
@@ -220,8 +224,668 @@ void test003() {
   }
 }
 
+void test004() {
+  constexpr size_t nlines = 4000;
+  constexpr size_t nfreq = 2000;
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+
+  const auto xpos = Geom::Pos<Geom::PosType::Xyz>({0, a + 1, 0});
+  const auto dxlos = Geom::Los<Geom::LosType::Xyz>({1, 1, 1});
+  const auto nav = Geom::Nav(xpos, dxlos, wgs84);
+
+  const Atmosphere::Point ap = Atmosphere::Point(
+      1000, 275, std::array<double, 3>{10e-6, 10e-6, 30e-6},
+      std::array<double, 3>{10, 1, 0.1},
+      std::vector<VMR<VMRType::ratio>>{
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                              0.78},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                              0.2095},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
+                              400e-06}});
+  const Path::Point p = {nav, ap};
+
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 750e9, g, g, nlines);
+  const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
+                                       0.7};
+  for (size_t i = 0; i < nlines; i++)
+    band.EditLines()[i] = Absorption::Line(O266, 50e9 + 25e6 * double(i), 1e-18,
+                                           1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+
+  const auto f = linspace<Frequency<FrequencyType::Freq>>(40e9, 160e9, nfreq);
+  const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature};
+
+  std::vector<size_t> threads{1, 2, 4};
+  if (std::thread::hardware_concurrency() > 4)
+    threads.push_back(std::thread::hardware_concurrency());
+
+  std::cout << "Scaling of " << nlines << " lines on " << nfreq
+            << " frequencies (hardware threads: "
+            << std::thread::hardware_concurrency() << "):\n";
+  // Created before any limit, since TBB warns when an arena is created with
+  // more threads than the limit allows
+  Multithread::GetArena(Multithread::Arena::Compute).initialize();
+
+  Absorption::Xsec::Lbl::Results first;
+  double one = 0;
+  for (size_t n : threads) {
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, n);
+
+    Absorption::Xsec::Lbl::Results res(f.size(), derivs.size());
+    Absorption::Xsec::Lbl::Results src(f.size(), derivs.size());
+    Absorption::Xsec::Lbl::Workspace comp(f.size(), derivs.size());
+    const Time start;
+    Absorption::Xsec::Lbl::compute(res, src, comp, f, band, p, derivs);
+    const double t = TimeStep(Time() - start).count();
+    if (n == 1) {
+      first = res;
+      one = t;
+    }
+
+    std::cout << n << " threads: " << t << " s, speedup " << one / t
+              << ", same as 1 thread: "
+              << (res.x == first.x and res.dx == first.dx) << '\n';
+  }
+}
+
+void test005() {
+  constexpr size_t nlines = 4000;
+  constexpr size_t nfreq = 20000;
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+
+  const auto xpos = Geom::Pos<Geom::PosType::Xyz>({0, a + 1, 0});
+  const auto dxlos = Geom::Los<Geom::LosType::Xyz>({1, 1, 1});
+  const auto nav = Geom::Nav(xpos, dxlos, wgs84);
+
+  const Atmosphere::Point ap = Atmosphere::Point(
+      1000, 275, std::array<double, 3>{10e-6, 10e-6, 30e-6},
+      std::array<double, 3>{10, 1, 0.1},
+      std::vector<VMR<VMRType::ratio>>{
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                              0.78},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                              0.2095},
+          VMR<VMRType::ratio>{Species::Isotope(Species::Species::Water, 0),
+                              400e-06}});
+  const Path::Point p = {nav, ap};
+
+  // Lines cut off 250 MHz from their centers on a 120 GHz wide grid
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 250e6, g, g, nlines);
+  const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
+                                       0.7};
+  for (size_t i = 0; i < nlines; i++)
+    band.EditLines()[i] = Absorption::Line(O266, 50e9 + 25e6 * double(i), 1e-18,
+                                           1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+
+  const auto f = linspace<Frequency<FrequencyType::Freq>>(40e9, 160e9, nfreq);
+  const std::vector<Frequency<FrequencyType::Freq>> r(f.crbegin(), f.crend());
+  const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature};
+
+  // The reversed grid is not sorted so every line visits all of it
+  std::cout << "Cutoff windows of " << nlines << " lines on " << nfreq
+            << " frequencies:\n";
+  double tf = 0, tr = 0;
+  Absorption::Xsec::Lbl::Results resf, resr;
+  for (auto* x : {&f, &r}) {
+    Absorption::Xsec::Lbl::Results res(x->size(), derivs.size());
+    Absorption::Xsec::Lbl::Results src(x->size(), derivs.size());
+    Absorption::Xsec::Lbl::Workspace comp(x->size(), derivs.size());
+    const Time start;
+    Absorption::Xsec::Lbl::compute(res, src, comp, *x, band, p, derivs);
+    const double t = TimeStep(Time() - start).count();
+    if (x == &f) {
+      tf = t;
+      resf = res;
+    } else {
+      tr = t;
+      resr = res;
+    }
+  }
+
+  bool same = true;
+  for (size_t iv = 0; iv < nfreq; iv++)
+    same = same and resf.x[iv] == resr.x[nfreq - 1 - iv] and
+           resf.dx[0][iv] == resr.dx[0][nfreq - 1 - iv];
+  std::cout << "Sorted: " << tf << " s, unsorted: " << tr << " s, speedup "
+            << tr / tf << ", same result: " << same << '\n';
+}
+
+void test006() {
+  constexpr size_t nlines = 20000;
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByFixedFrequency,
+      Absorption::Shape::VP, false, 296, 750e9, g, g, nlines);
+  const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
+                                       0.7};
+  for (size_t i = 0; i < nlines; i++)
+    band.EditLines()[i] = Absorption::Line(O266, 150e9 - 5e6 * double(i), 1e-18,
+                                           1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+
+  const Absorption::Band &cband = band;
+  double sum = 0;
+  const Time start;
+  for (size_t i = 0; i < nlines; i++)
+    sum += cband.CutoffLower(i) + cband.CutoffUpper(i);
+  const double t = TimeStep(Time() - start).count();
+  std::cout << "Cutoffs of " << nlines << " lines with a fixed frequency: " << t
+            << " s (checksum " << sum << ")\n";
+
+  std::cout << "Mean frequency (expects 100.003 GHz): "
+            << cband.MeanFreq() * 1e-9 << " GHz, first line by frequency "
+            << "(expects " << nlines - 1 << "): " << cband.LineOrder().front()
+            << '\n';
+  const std::size_t generation = band.Generation();
+  std::cout << "Reading the lines keeps the derived values (expects 1): "
+            << (band.Lines().front().F0() > 0.0 and
+                band.Generation() == generation)
+            << '\n';
+  band.EditLines()[0].F0(10e9);
+  std::cout << "After editing the first line (expects 99.9955 GHz): "
+            << cband.MeanFreq() * 1e-9 << " GHz, first line by frequency "
+            << "(expects 0): " << cband.LineOrder().front() << '\n';
+}
+
+void test007() {
+  constexpr size_t nlines = 20000;
+  constexpr size_t nrep = 20;
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 250e6, g, g, nlines);
+  const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3, 15e3, 0,
+                                       0.7};
+  for (size_t i = 0; i < nlines; i++)
+    band.EditLines()[i] = Absorption::Line(O266, 50e9 + 5e6 * double(i), 1e-18,
+                                           1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+  const std::vector<VMR<VMRType::ratio>> vmr{
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                          0.78},
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                          0.2095}};
+
+  // The per-line parameters that the line-by-line loop reads
+  const Absorption::Band &cband = band;
+  double sum_aos = 0, sum_soa = 0;
+  const Time start_aos;
+  for (size_t r = 0; r < nrep; r++) {
+    for (auto &line : cband.Lines()) {
+      const auto X = line.ShapeModel()(275, cband.T0(), 1000, vmr);
+      sum_aos += line.F0() * line.I0() * line.E0() + X.G0 + X.D0 + X.Y;
+    }
+  }
+  const double taos = TimeStep(Time() - start_aos).count();
+
+  cband.Arrays();  // Not timing the one-time copy
+  const Time start_soa;
+  for (size_t r = 0; r < nrep; r++) {
+    const auto &la = cband.Arrays();
+    for (size_t i = 0; i < nlines; i++) {
+      const auto X = la.ShapeModel(i, 275, cband.T0(), 1000, vmr);
+      sum_soa += la.f0[i] * la.i0[i] * la.e0[i] + X.G0 + X.D0 + X.Y;
+    }
+  }
+  const double tsoa = TimeStep(Time() - start_soa).count();
+
+  std::cout << "Line parameters of " << nlines << " lines " << nrep
+            << " times:\nLines: " << taos << " s, arrays: " << tsoa
+            << " s, speedup " << taos / tsoa
+            << ", same result: " << (sum_aos == sum_soa) << '\n';
+}
+
+void test008() {
+  constexpr size_t nlines = 20000;
+  constexpr size_t nrep = 20;
+  const Species::Isotope O266(Species::Species::Oxygen, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::Oxygen));
+  const std::vector<Quantum::Number> l(
+      getLocalQuantumNumberCount(Species::Species::Oxygen));
+  Absorption::Band band(
+      O266, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 250e6, g, g, nlines);
+  for (size_t i = 0; i < nlines; i++) {
+    const Absorption::LineShape::Model m{Species::Species::Oxygen, 10e3,
+                                         15e3 + double(i), 0,
+                                         0.5 + 1e-5 * double(i)};
+    band.EditLines()[i] = Absorption::Line(O266, 50e9 + 5e6 * double(i), 1e-18,
+                                           1e-20, {0, 0}, 1, 1, 1e-20, l, l, m);
+  }
+  const std::vector<VMR<VMRType::ratio>> vmr{
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Nitrogen, 0),
+                          0.78},
+      VMR<VMRType::ratio>{Species::Isotope(Species::Species::Oxygen, 0),
+                          0.2095}};
+  const Absorption::Band &cband = band;
+  const Temperature<TemperatureType::K> T = 275;
+  const Pressure<PressureType::Pa> P = 1000;
+
+  std::vector<Absorption::LineShape::Output> X1(nlines), dX1(nlines);
+  const Time start1;
+  for (size_t r = 0; r < nrep; r++) {
+    for (size_t i = 0; i < nlines; i++) {
+      X1[i] = cband.Lines()[i].ShapeModel()(T, cband.T0(), P, vmr);
+      dX1[i] = cband.Lines()[i].ShapeModel().dT(T, cband.T0(), P, vmr);
+    }
+  }
+  const double t1 = TimeStep(Time() - start1).count();
+
+  std::vector<Absorption::LineShape::Output> X2(nlines), dX2(nlines);
+  cband.Arrays();  // Not timing the one-time copy
+  const Time start2;
+  for (size_t r = 0; r < nrep; r++)
+    cband.Arrays().ShapeModels(
+        Absorption::LineShape::State(T, cband.T0(), P), vmr, X2.data(),
+        dX2.data());
+  const double t2 = TimeStep(Time() - start2).count();
+
+  double err = 0;
+  for (size_t i = 0; i < nlines; i++) {
+    err = std::max(err, std::abs(X2[i].G0 / X1[i].G0 - 1));
+    err = std::max(err, std::abs(dX2[i].G0 / dX1[i].G0 - 1));
+  }
+  std::cout << "Line shape parameters and temperature derivatives of "
+            << nlines << " lines " << nrep << " times:\nPer line: " << t1
+            << " s, band: " << t2 << " s, speedup " << t1 / t2
+            << ", max relative difference (expects below 1e-14): " << err
+            << '\n';
+}
+
+void test009() {
+  constexpr size_t nlines = 300;
+  constexpr size_t nrep = 100;
+  const Species::Isotope CO(Species::Species::CarbonMonoxide, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::CarbonMonoxide));
+  Absorption::Band band(
+      CO, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, true, 296, 250e6, g, g, nlines);
+  const Absorption::LineShape::Model m{Species::Species::CarbonMonoxide, 10e3,
+                                       15e3, 0, 0.7};
+  for (size_t i = 0; i < nlines; i++) {
+    const Rational J(int(i % 30));
+    const std::vector<Quantum::Number> lower{Quantum::Number(J)};
+    const std::vector<Quantum::Number> upper{Quantum::Number(J + 1)};
+    band.EditLines()[i] =
+        Absorption::Line(CO, 100e9 + 1e6 * double(i), 1e-18, 1e-20, {1, 2}, 1,
+                         1, 1e-20, lower, upper, m);
+  }
+  const Absorption::Band &cband = band;
+
+  // The strengths of all polarizations of a line add up to one
+  const auto &za = cband.Zeeman();
+  double err = 0;
+  for (size_t i = 0; i < nlines; i++) {
+    double sum = 0;
+    for (size_t p = 0; p < 3; p++)
+      for (size_t iz = za.offset[p][i]; iz < za.offset[p][i + 1]; iz++)
+        sum += za.strength[p][iz];
+    err = std::max(err, std::abs(sum - 1));
+  }
+
+  double sum_line = 0, sum_band = 0;
+  const Time start_line;
+  for (size_t r = 0; r < nrep; r++) {
+    for (auto &line : cband.Lines()) {
+      constexpr auto pol = Absorption::Polarization::Pi;
+      const auto range = line.ZeemanRange(pol, CO);
+      for (int iz = range.first; iz <= range.second; iz++)
+        sum_line += line.ZeemanStrength(pol, CO, iz) *
+                    std::abs(line.ZeemanSplitting(pol, CO, iz));
+    }
+  }
+  const double tline = TimeStep(Time() - start_line).count();
+
+  const size_t pi = size_t(Absorption::Polarization::Pi);
+  const Time start_band;
+  for (size_t r = 0; r < nrep; r++)
+    for (size_t iz = 0; iz < za.strength[pi].size(); iz++)
+      sum_band += za.strength[pi][iz] * std::abs(za.splitting[pi][iz]);
+  const double tband = TimeStep(Time() - start_band).count();
+
+  std::cout << "Zeeman components of " << nlines << " lines " << nrep
+            << " times:\nStrengths of a line add up to 1 (max error "
+            << "expects below 1e-14): " << err << "\nPer line: " << tline
+            << " s, band: " << tband << " s, speedup " << tline / tband
+            << ", same result: " << (sum_line == sum_band) << '\n';
+
+  // Without a magnetic field the polarizations add up to the band without
+  // Zeeman effect
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+  const auto nav = Geom::Nav(Geom::Pos<Geom::PosType::Xyz>({0, a + 1, 0}),
+                             Geom::Los<Geom::LosType::Xyz>({1, 1, 1}), wgs84);
+  const Atmosphere::Point ap(
+      1000, 275, std::array<double, 3>{0, 0, 0}, std::array<double, 3>{0, 0, 0},
+      std::vector<VMR<VMRType::ratio>>{VMR<VMRType::ratio>{CO, 1e-6}});
+  const Path::Point p = {nav, ap};
+  const auto f = linspace<Frequency<FrequencyType::Freq>>(99e9, 101e9, 1001);
+  Absorption::Xsec::Lbl::Workspace ws(f.size(), 0);
+  Absorption::Xsec::Lbl::Results zeeman(f.size(), 0), src(f.size(), 0);
+  for (auto pol : {Absorption::Polarization::SigmaMinus,
+                   Absorption::Polarization::Pi,
+                   Absorption::Polarization::SigmaPlus})
+    Absorption::Xsec::Lbl::compute(zeeman, src, ws, f, cband, p, {}, pol);
+
+  Absorption::Band plain(
+      CO, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, false, 296, 250e6, g, g, nlines);
+  *plain.EditLines() = cband.Lines();
+  Absorption::Xsec::Lbl::Results none(f.size(), 0);
+  Absorption::Xsec::Lbl::compute(none, src, ws, f, plain, p, {});
+
+  double xerr = 0;
+  for (size_t iv = 0; iv < f.size(); iv++)
+    xerr = std::max(xerr, std::abs(zeeman.x[iv] / none.x[iv] - 1.0));
+  std::cout << "Polarizations without a magnetic field against no Zeeman "
+            << "effect, max relative difference (expects below 1e-12): "
+            << xerr << '\n';
+}
+
+void test010() {
+  constexpr size_t nrep = 200;
+  const std::array<Species::Isotope, 4> isots{
+      Species::Isotope(Species::Species::Water, 0),
+      Species::Isotope(Species::Species::CarbonDioxide, 0),
+      Species::Isotope(Species::Species::Oxygen, 0),
+      Species::Isotope(Species::Species::CarbonMonoxide, 0)};
+  std::vector<double> T;
+  for (double t = 100; t < 3000; t += 0.731) T.push_back(t);
+
+  // Also builds the tables, so they are not built while timing
+  double errQ = 0, errdQ = 0;
+  for (auto &x : isots) {
+    for (double t : T) {
+      const auto q = x.Partition(t);
+      errQ = std::max(errQ, std::abs(q.Q / x.QT(t) - 1));
+      errdQ = std::max(errdQ, std::abs(q.dQdT / x.dQT(t) - 1));
+    }
+  }
+
+  double sum_analytic = 0, sum_table = 0;
+  const Time start_analytic;
+  for (size_t r = 0; r < nrep; r++)
+    for (auto &x : isots)
+      for (double t : T) sum_analytic += x.QT(t) + x.dQT(t);
+  const double tanalytic = TimeStep(Time() - start_analytic).count();
+
+  const Time start_table;
+  for (size_t r = 0; r < nrep; r++)
+    for (auto &x : isots)
+      for (double t : T) {
+        const auto q = x.Partition(t);
+        sum_table += q.Q + q.dQdT;
+      }
+  const double ttable = TimeStep(Time() - start_table).count();
+
+  std::cout << "Tabulated partition functions of " << isots.size()
+            << " isotopes at " << T.size() << " temperatures " << nrep
+            << " times:\nMax relative difference of Q (expects below 1e-10): "
+            << errQ << ", of dQ/dT (expects below 1e-8): " << errdQ
+            << "\nAnalytic: " << tanalytic << " s, table: " << ttable
+            << " s, speedup " << tanalytic / ttable << ", relative difference "
+            << "of the sums: " << std::abs(sum_table / sum_analytic - 1)
+            << '\n';
+}
+
+void test011() {
+  constexpr size_t nlines = 4000;
+  constexpr size_t nlevels = 10;
+  const Species::Isotope CO(Species::Species::CarbonMonoxide, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::CarbonMonoxide));
+  const std::vector<Quantum::Number> q(
+      getLocalQuantumNumberCount(Species::Species::CarbonMonoxide));
+  const Absorption::LineShape::Model m{Species::Species::CarbonMonoxide, 10e3,
+                                       15e3, 0, 0.7};
+
+  // Lines over 20-180 GHz with strengths spread over twelve orders of
+  // magnitude, most of them far from the frequency grid
+  std::vector<Absorption::Band> bands;
+  for (size_t ib = 0; ib < 4; ib++) {
+    Absorption::Band band(
+        CO, Absorption::Mirroring::None, Absorption::Normalization::None,
+        Absorption::Population::ByLTE, Absorption::Cutoff::None,
+        Absorption::Shape::VP, false, 296, 0, g, g);
+    for (size_t i = ib; i < nlines; i += 4)
+      band.appendLine(Absorption::Line(
+          CO, 20e9 + 40e6 * double(i),
+          1e-18 * std::pow(10.0, -12.0 * double((i * 7919) % nlines) /
+                                     double(nlines)),
+          1e-21 * double(i % 50), {}, 1, 1, 1e-20, q, q, m));
+    bands.push_back(band);
+  }
+
+  // Weak lines of a speed-dependent shape, which cannot be bounded
+  constexpr size_t nsd = 200;
+  Absorption::Band sd(
+      CO, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::None,
+      Absorption::Shape::SDVP, false, 296, 0, g, g);
+  for (size_t i = 0; i < nsd; i++)
+    sd.appendLine(Absorption::Line(CO, 20e9 + 800e6 * double(i), 1e-30, 0, {},
+                                   1, 1, 1e-20, q, q, m));
+  bands.push_back(sd);
+
+  Atmosphere::Point p0(1e5, 290, std::array<double, 3>{0, 0, 0},
+                       std::array<double, 3>{0, 0, 0},
+                       std::vector<VMR<VMRType::ratio>>{
+                           VMR<VMRType::ratio>{CO, 1e-6}});
+  std::vector<Altitude<AltitudeType::meter>> alt(nlevels);
+  Grid<Atmosphere::Point, 4> data(p0, 1, nlevels, 1, 1);
+  for (size_t i = 0; i < nlevels; i++) {
+    alt[i] = 8e3 * double(i);
+    data(0, i, 0, 0) = Atmosphere::Point(
+        1e5 * std::exp(-double(i)), 290 - 6 * double(i),
+        std::array<double, 3>{0, 0, 0}, std::array<double, 3>{0, 0, 0},
+        std::vector<VMR<VMRType::ratio>>{VMR<VMRType::ratio>{CO, 1e-6}});
+  }
+  const Time now;
+  const Atmosphere::Atm atm({now}, alt, {0}, {0}, data);
+  const auto f = linspace<Frequency<FrequencyType::Freq>>(95e9, 105e9, 2001);
+
+  auto pruned = bands;
+  const auto report = Absorption::Xsec::Lbl::prune(
+      pruned, f, atm, 1e-6, Absorption::Xsec::Lbl::Threshold::Relative);
+
+  constexpr auto a = Length<LengthType::meter>{6'378'137.0};
+  constexpr auto b = Length<LengthType::meter>{6'356'752.314245};
+  auto wgs84 = Geom::Ellipsoid(a, std::sqrt((a * a - b * b) / (a * a)));
+  const auto nav = Geom::Nav(Geom::Pos<Geom::PosType::Xyz>({0, a + 1, 0}),
+                             Geom::Los<Geom::LosType::Xyz>({1, 1, 1}), wgs84);
+  Absorption::Xsec::Lbl::Workspace ws(f.size(), 0);
+  Absorption::Xsec::Lbl::Results all(f.size(), 0), some(f.size(), 0),
+      src(f.size(), 0);
+  double err = 0, tall = 0, tsome = 0;
+  // The grid points and the points halfway between them
+  for (size_t i = 0; i < 2 * nlevels - 1; i++) {
+    const Path::Point p = {nav, atm(now, 4e3 * double(i), 0, 0)};
+    all.reset(f.size(), 0);
+    some.reset(f.size(), 0);
+    const Time start_all;
+    for (auto &band : bands)
+      Absorption::Xsec::Lbl::compute(all, src, ws, f, band, p, {});
+    tall += TimeStep(Time() - start_all).count();
+    const Time start_some;
+    for (auto &band : pruned)
+      Absorption::Xsec::Lbl::compute(some, src, ws, f, band, p, {});
+    tsome += TimeStep(Time() - start_some).count();
+    for (size_t iv = 0; iv < f.size(); iv++)
+      err = std::max(err, std::abs(all.x[iv] - some.x[iv]));
+  }
+
+  std::cout << "Pruned " << report.removed << " of "
+            << report.removed + report.kept << " lines to a relative 1e-6 of "
+            << "the strongest line's bound " << report.strongest
+            << ":\nBound " << report.bound << " within threshold (expects 1): "
+            << (report.bound <= 1e-6 * report.strongest)
+            << ", error within bound (expects 1): " << (err <= report.bound)
+            << ", error " << err << "\nLines of the speed-dependent band "
+            << "kept (expects 1): " << (pruned.back().n_lines() == nsd)
+            << "\nAll lines: " << tall
+            << " s, pruned: " << tsome << " s, speedup " << tall / tsome
+            << '\n';
+}
+
+/** The static data of an isotope as dispatched by species before the table */
+struct IsotopeReference {
+  double mass;
+  double gi;
+  double Q;
+  double dQ;
+};
+
+template <size_t... S>
+IsotopeReference isotope_reference(Species::Isotope x, double T,
+                                   std::index_sequence<S...>) {
+  IsotopeReference out{std::numeric_limits<double>::quiet_NaN(),
+                       std::numeric_limits<double>::quiet_NaN(), 0, 0};
+  auto get = [&](auto s) {
+    constexpr auto spec = Species::Species(decltype(s)::value);
+    if constexpr (Species::getIsotopologueCount(spec) > 0) {
+      if (x.Spec() == spec) {
+        Species::Isotopologue<spec> isot;
+        const unsigned char num = x.Num();
+        out = {isot.Mass(num), double(isot.G(num)),
+               isot.template QT<false>(T, num), isot.template QT<true>(T, num)};
+      }
+    }
+  };
+  (get(std::integral_constant<size_t, S>{}), ...);
+  return out;
+}
+
+IsotopeReference isotope_reference(Species::Isotope x, double T) {
+  return isotope_reference(
+      x, T, std::make_index_sequence<size_t(Species::Species::FINAL)>{});
+}
+
+void test012() {
+  constexpr size_t nrep = 2000;
+  std::vector<Species::Isotope> isots;
+  for (size_t i = 0; i < size_t(Species::Species::FINAL); i++)
+    for (unsigned char j = 0;
+         j < Species::getIsotopologueCount(Species::Species(i)); j++)
+      isots.emplace_back(Species::Species(i), j);
+  const std::array<double, 4> T{50, 180.5, 296, 1200};
+
+  auto same = [](double a, double b) {
+    return a == b or (std::isnan(a) and std::isnan(b));
+  };
+  size_t ndiff = 0;
+  for (auto &x : isots) {
+    for (double t : T) {
+      const auto ref = isotope_reference(x, t);
+      if (not same(ref.mass, x.mass()) or not same(ref.gi, x.gi()) or
+          not same(ref.Q, x.QT(t)) or not same(ref.dQ, x.dQT(t)))
+        ndiff++;
+    }
+  }
+  const Species::Isotope bath(Species::Species::Bath, 0);
+  const auto ref = isotope_reference(bath, 296);
+  if (not same(ref.mass, bath.mass()) or not same(ref.gi, bath.gi()) or
+      not same(ref.Q, bath.QT(296)) or not same(ref.dQ, bath.dQT(296)))
+    ndiff++;
+
+  double sum_switch = 0, sum_table = 0;
+  const Time start_switch;
+  for (size_t r = 0; r < nrep; r++)
+    for (auto &x : isots)
+      for (double t : T) {
+        const auto y = isotope_reference(x, t);
+        sum_switch += y.mass + y.gi + y.Q + y.dQ;
+      }
+  const double tswitch = TimeStep(Time() - start_switch).count();
+
+  const Time start_table;
+  for (size_t r = 0; r < nrep; r++)
+    for (auto &x : isots)
+      for (double t : T) sum_table += x.mass() + x.gi() + x.QT(t) + x.dQT(t);
+  const double ttable = TimeStep(Time() - start_table).count();
+
+  std::cout << "Isotope table of " << isots.size()
+            << " isotopes, entries that differ from the dispatch by species "
+            << "(expects 0): " << ndiff << "\nDispatch: " << tswitch
+            << " s, table: " << ttable << " s, speedup " << tswitch / ttable
+            << ", relative difference of the sums (expects 0): "
+            << std::abs(sum_table / sum_switch - 1) << '\n';
+}
+
+void test013() {
+  const Species::Isotope CO(Species::Species::CarbonMonoxide, 0);
+  const std::vector<Quantum::Number> g(
+      getGlobalQuantumNumberCount(Species::Species::CarbonMonoxide));
+  Absorption::Band band(
+      CO, Absorption::Mirroring::None, Absorption::Normalization::None,
+      Absorption::Population::ByLTE, Absorption::Cutoff::ByLineOffset,
+      Absorption::Shape::VP, true, 296, 250e6, g, g, 1);
+  const Absorption::LineShape::Model m{Species::Species::CarbonMonoxide, 10e3,
+                                       15e3, 0, 0.7};
+  const std::vector<Quantum::Number> lower{Quantum::Number(Rational(300))};
+  const std::vector<Quantum::Number> upper{Quantum::Number(Rational(301))};
+  band.EditLines()[0] = Absorption::Line(CO, 100e9, 1e-18, 1e-20, {1, 2}, 1, 1,
+                                         1e-20, lower, upper, m);
+  const Absorption::Band &cband = band;
+
+  // The Zeeman components are only computed when they are used
+  std::cout << "Mean frequency of a line above the Wigner tables (expects "
+            << "100 GHz): " << cband.MeanFreq() * 1e-9 << " GHz\n";
+  try {
+    cband.Zeeman();
+    std::cout << "Zeeman components above the Wigner tables computed\n";
+  } catch (const std::runtime_error &e) {
+    std::cout << "Zeeman components above the Wigner tables throw (expects "
+              << "this):\n"
+              << e.what();
+  }
+}
+
 int main() {
   //   test001();  // Test a few partition functions
   //   test002();  // Test some LBL
   test003();
+  test004();  // Scaling with threads of a large band
+  test005();  // Only the frequencies inside the cutoff on a sorted grid
+  test006();  // Cached band values and their update
+  test007();  // Line parameters as arrays
+  test008();  // Line shape parameters of all lines of a band at once
+  test009();  // Zeeman components of the lines of a band
+  test010();  // Tabulated partition functions
+  test011();  // Pruning of weak lines
+  test012();  // Isotope data from the table
+  test013();  // Zeeman components that cannot be computed
 }
@@ -6,7 +6,9 @@
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
 
 /** A duration of time, 1 full tick should be 1 second */
 using TimeStep = std::chrono::duration<double>;
@@ -7,6 +7,7 @@
 
 #include "constants.h"
 #include "enums.h"
+#include "smallvector.h"
 #include "species.h"
 
 #define SCALAR(Scalar)                                                         \
@@ -391,6 +392,10 @@ class VMR {
   }
 };  // VMR
 
+/** Volume mixing ratios of the species of an atmospheric state, inline for
+ * the usual few species */
+using VMRs = SmallVector<VMR<VMRType::ratio>, 8>;
+
 template <DistanceType X>
 class Distance final {
   SCALAR(Distance)
@@ -1,6 +1,8 @@
 #include "wigner.h"
 
 #include <algorithm>
+#include <sstream>
+#include <stdexcept>
 
 #if DO_FAST_WIGNER
 #define WIGNER3 fw3jja6
@@ -10,15 +12,28 @@
 #define WIGNER6 wig6jj
 #endif
 
+namespace {
+/** Largest 2j of the tables that wigner3j makes, far above any line */
+constexpr int table_two_j = 400;
+
+/** Symbols in the dynamic hash table of fastwigxj */
+constexpr int fast_entries = 1 << 16;
+
+/** The wigxjpf scratch space of a thread, kept between symbols */
+struct ThreadTemp {
+  ThreadTemp() { wig_thread_temp_init(table_two_j * 3 / 2 + 1); }
+  ~ThreadTemp() { wig_temp_free(); }
+  ThreadTemp(const ThreadTemp &) = delete;
+  ThreadTemp &operator=(const ThreadTemp &) = delete;
+};
+}  // namespace
+
 int make_wigner_ready(int largest, [[maybe_unused]] int fastest, int size) {
+  // The dynamic tables are shared by all threads of the executor
   if (size == 3) {
 #if DO_FAST_WIGNER
     fastwigxj_load(FAST_WIGNER_PATH_3J, 3, NULL);
-#ifdef _OPENMP
     fastwigxj_thread_dyn_init(3, fastest);
-#else
-    fastwigxj_dyn_init(3, fastest);
-#endif
 #endif
     wig_table_init(largest, 3);
 
@@ -27,13 +42,8 @@ int make_wigner_ready(int largest, [[maybe_unused]] int fastest, int size) {
 #if DO_FAST_WIGNER
     fastwigxj_load(FAST_WIGNER_PATH_3J, 3, NULL);
     fastwigxj_load(FAST_WIGNER_PATH_6J, 6, NULL);
-#ifdef _OPENMP
     fastwigxj_thread_dyn_init(3, fastest);
     fastwigxj_thread_dyn_init(6, fastest);
-#else
-    fastwigxj_dyn_init(3, fastest);
-    fastwigxj_dyn_init(6, fastest);
-#endif
 #endif
     wig_table_init(largest * 2, 6);
 
@@ -47,15 +57,19 @@ double wigner3j(const Rational j1, const Rational j2, const Rational j3,
                 const Rational m1, const Rational m2, const Rational m3) {
   const int a = int(2 * j1), b = int(2 * j2), c = int(2 * j3), d = int(2 * m1),
             e = int(2 * m2), f = int(2 * m3);
-  double g;
   const int j = std::max({std::abs(a), std::abs(b), std::abs(c), std::abs(d),
-                          std::abs(e), std::abs(f)}) *
-                    3 / 2 +
-                1;
+                          std::abs(e), std::abs(f)});
+  if (j > table_two_j) {
+    std::ostringstream os;
+    os << "Wigner 3j symbol with 2j = " << j << " above the largest 2j ("
+       << table_two_j << ") of the tables\n";
+    throw std::runtime_error(os.str());
+  }
 
-  wig_temp_init(j);
-  g = WIGNER3(a, b, c, d, e, f);
-  wig_temp_free();
+  // Thread-safe static, so the tables are made once before any use
+  [[maybe_unused]] static const int ready =
+      make_wigner_ready(table_two_j, fast_entries, 3);
+  thread_local const ThreadTemp temp;
 
-  return g;
+  return WIGNER3(a, b, c, d, e, f);
 }
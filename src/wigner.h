@@ -25,6 +25,9 @@ int make_wigner_ready(int largest, int fastest, int size);
  *
  * Run wigxjpf wig3jj for Rational symbol
  *
+ * Thread-safe.  The tables are made on the first call, and every thread keeps
+ * its own scratch space between calls.  Throws for 2j above the tables
+ *
  * /                \
  * |  j1   j2   j3  |
  * |                |
@@ -2,15 +2,63 @@
 
 #include <execution>
 
-#include "xsec_lbl.h"
+#include "multithread.h"
 
 namespace Absorption {
 namespace PropagationMatrix {
+/** Sums the line-by-line cross-sections of a block of bands
+ *
+ * Every block gets its own results and scratch space from the pool, so no two
+ * threads ever write to the same memory
+ */
+struct BandSum {
+  Multithread::Pool<BandBlock> &pool;
+  std::unique_ptr<BandBlock> block;
+  const std::vector<Frequency<FrequencyType::Freq>> &f;
+  const std::vector<Band> &bands;
+  const Path::Point &atm;
+  const std::vector<Derivative::Target> &derivs;
+  const Polarization polarization;
+
+  BandSum(const std::vector<Frequency<FrequencyType::Freq>> &f_,
+          const std::vector<Band> &bands_, const Path::Point &atm_,
+          const std::vector<Derivative::Target> &derivs_,
+          const Polarization polarization_,
+          Multithread::Pool<BandBlock> &pool_)
+      : pool(pool_),
+        block(pool_.take()),
+        f(f_),
+        bands(bands_),
+        atm(atm_),
+        derivs(derivs_),
+        polarization(polarization_) {
+    block->res.reset(f.size(), derivs.size());
+    block->src.reset(f.size(), derivs.size());
+  }
+
+  BandSum(BandSum &x, tbb::split)
+      : BandSum(x.f, x.bands, x.atm, x.derivs, x.polarization, x.pool) {}
+
+  ~BandSum() { pool.give(std::move(block)); }
+
+  void operator()(const tbb::blocked_range<size_t> &r) {
+    for (size_t i = r.begin(); i not_eq r.end(); ++i)
+      Xsec::Lbl::compute(block->res, block->src, block->lbl, f, bands[i], atm,
+                         derivs, polarization);
+  }
+
+  void join(const BandSum &x) {
+    block->res += x.block->res;
+    block->src += x.block->src;
+  }
+};  // BandSum
+
 template <size_t N>
-void internal_compute(Results<N> &res, Results<N> &src,
+void internal_compute(Results<N> &res, Results<N> &src, Workspace &ws,
                       const std::vector<Frequency<FrequencyType::Freq>> &f,
                       const std::vector<Band> &bands, const Path::Point &atm,
-                      const std::vector<Derivative::Target> &derivs) {
+                      const std::vector<Derivative::Target> &derivs,
+                      const std::vector<Xsec::Lut::Table> &tables) {
   std::fill(res.x.begin(), res.x.end(), PropMat<N>());
   std::fill(src.x.begin(), src.x.end(), PropMat<N>());
   std::fill(res.dx.begin(), res.dx.end(), res.x);
@@ -21,10 +69,8 @@ void internal_compute(Results<N> &res, Results<N> &src,
   [[maybe_unused]] const auto zeeman_angles =
       Zeeman::angles_with_derivatives(mag, los.za(), los.aa());
 
-  Xsec::Lbl::Results lbl_res(f.size(), derivs.size());
-  Xsec::Lbl::Results lbl_src(f.size(), derivs.size());
-  Xsec::Lbl::Results lbl_clc(f.size(), derivs.size());
-  bool first = true;
+  auto &lbl_res = ws.res;
+  auto &lbl_src = ws.src;
   for (auto z : {Polarization::SigmaMinus, Polarization::Pi,
                  Polarization::SigmaPlus, Polarization::None}) {
     if constexpr (N not_eq 4) {
@@ -35,19 +81,26 @@ void internal_compute(Results<N> &res, Results<N> &src,
     }
 
     // Reset all since polarizations must be treated independently
-    if (not first) {
-      std::fill(lbl_res.x.begin(), lbl_res.x.end(), Complex(0, 0));
-      std::fill(lbl_src.x.begin(), lbl_src.x.end(), Complex(0, 0));
-      std::fill(lbl_res.dx.begin(), lbl_res.dx.end(), lbl_res.x);
-      std::fill(lbl_src.dx.begin(), lbl_src.dx.end(), lbl_src.x);
+    lbl_res.reset(f.size(), derivs.size());
+    lbl_src.reset(f.size(), derivs.size());
+
+    // Add up xsec from all bands, in parallel if there are several
+    if (bands.size() > 1) {
+      BandSum sum(f, bands, atm, derivs, z, ws.blocks);
+      Multithread::deterministic_reduce(Multithread::Arena::Compute, 0,
+                                        bands.size(), sum);
+      lbl_res += sum.block->res;
+      lbl_src += sum.block->src;
     } else {
-      first = false;
+      for (const auto &band : bands) {
+        Xsec::Lbl::compute(lbl_res, lbl_src, ws.lbl, f, band, atm, derivs, z);
+      }
     }
 
-    // Add up xsec from all bands
-    for (const auto &band : bands) {
-      Xsec::Lbl::compute(lbl_res, lbl_src, lbl_clc, f, band, atm, derivs, z);
-    }
+    // Tables of cross-sections have no Zeeman effect
+    if (z == Polarization::None)
+      for (const auto &table : tables)
+        table.compute(lbl_res, lbl_src, f, atm, derivs);
 
     // FIXME: Add other types of cross-sections here
 
@@ -189,29 +242,33 @@ void internal_compute(Results<N> &res, Results<N> &src,
                  [numden](auto &x) { return x * numden; });
 }
 
-void compute(Results<1> &res, Results<1> &src,
+void compute(Results<1> &res, Results<1> &src, Workspace &ws,
              const std::vector<Frequency<FrequencyType::Freq>> &f,
              const std::vector<Band> &bands, const Path::Point &atm,
-             const std::vector<Derivative::Target> &derivs) {
-  internal_compute(res, src, f, bands, atm, derivs);
+             const std::vector<Derivative::Target> &derivs,
+             const std::vector<Xsec::Lut::Table> &tables) {
+  internal_compute(res, src, ws, f, bands, atm, derivs, tables);
 }
-void compute(Results<2> &res, Results<2> &src,
+void compute(Results<2> &res, Results<2> &src, Workspace &ws,
              const std::vector<Frequency<FrequencyType::Freq>> &f,
              const std::vector<Band> &bands, const Path::Point &atm,
-             const std::vector<Derivative::Target> &derivs) {
-  internal_compute(res, src, f, bands, atm, derivs);
+             const std::vector<Derivative::Target> &derivs,
+             const std::vector<Xsec::Lut::Table> &tables) {
+  internal_compute(res, src, ws, f, bands, atm, derivs, tables);
 }
-void compute(Results<3> &res, Results<3> &src,
+void compute(Results<3> &res, Results<3> &src, Workspace &ws,
              const std::vector<Frequency<FrequencyType::Freq>> &f,
              const std::vector<Band> &bands, const Path::Point &atm,
-             const std::vector<Derivative::Target> &derivs) {
-  internal_compute(res, src, f, bands, atm, derivs);
+             const std::vector<Derivative::Target> &derivs,
+             const std::vector<Xsec::Lut::Table> &tables) {
+  internal_compute(res, src, ws, f, bands, atm, derivs, tables);
 }
-void compute(Results<4> &res, Results<4> &src,
+void compute(Results<4> &res, Results<4> &src, Workspace &ws,
              const std::vector<Frequency<FrequencyType::Freq>> &f,
              const std::vector<Band> &bands, const Path::Point &atm,
-             const std::vector<Derivative::Target> &derivs) {
-  internal_compute(res, src, f, bands, atm, derivs);
+             const std::vector<Derivative::Target> &derivs,
+             const std::vector<Xsec::Lut::Table> &tables) {
+  internal_compute(res, src, ws, f, bands, atm, derivs, tables);
 }
 }  // namespace PropagationMatrix
 }  // namespace Absorption
@@ -5,6 +5,8 @@
 #include "derivatives.h"
 #include "lbl.h"
 #include "propmat.h"
+#include "xsec_lbl.h"
+#include "xsec_lut.h"
 
 namespace Absorption {
 namespace PropagationMatrix {
@@ -18,22 +20,47 @@ struct Results {
       : x(nfreq, PropMat<N>()), dx(njac, x) {}
 };
 
-void compute(Results<1> &, Results<1> &,
+/** The sums and scratch space of a block of bands computed in parallel */
+struct BandBlock {
+  Xsec::Lbl::Results res;
+  Xsec::Lbl::Results src;
+  Xsec::Lbl::Workspace lbl;
+};
+
+/** Scratch space of compute, kept by the caller between calls
+ *
+ * Owned by the caller, for example once per thread or per forward
+ * calculation, so that the frequency-sized buffers are only zeroed between
+ * calls instead of allocated.  A workspace must not be used by two calls at
+ * the same time
+ */
+struct Workspace {
+  Xsec::Lbl::Results res;
+  Xsec::Lbl::Results src;
+  Xsec::Lbl::Workspace lbl;
+  Multithread::Pool<BandBlock> blocks;
+};
+
+void compute(Results<1> &, Results<1> &, Workspace &,
              const std::vector<Frequency<FrequencyType::Freq>> &,
              const std::vector<Band> &, const Path::Point &,
-             const std::vector<Derivative::Target> &);
-void compute(Results<2> &, Results<2> &,
+             const std::vector<Derivative::Target> &,
+             const std::vector<Xsec::Lut::Table> &tables = {});
+void compute(Results<2> &, Results<2> &, Workspace &,
              const std::vector<Frequency<FrequencyType::Freq>> &,
              const std::vector<Band> &, const Path::Point &,
-             const std::vector<Derivative::Target> &);
-void compute(Results<3> &, Results<3> &,
+             const std::vector<Derivative::Target> &,
+             const std::vector<Xsec::Lut::Table> &tables = {});
+void compute(Results<3> &, Results<3> &, Workspace &,
              const std::vector<Frequency<FrequencyType::Freq>> &,
              const std::vector<Band> &, const Path::Point &,
-             const std::vector<Derivative::Target> &);
-void compute(Results<4> &, Results<4> &,
+             const std::vector<Derivative::Target> &,
+             const std::vector<Xsec::Lut::Table> &tables = {});
+void compute(Results<4> &, Results<4> &, Workspace &,
              const std::vector<Frequency<FrequencyType::Freq>> &,
              const std::vector<Band> &, const Path::Point &,
-             const std::vector<Derivative::Target> &);
+             const std::vector<Derivative::Target> &,
+             const std::vector<Xsec::Lut::Table> &tables = {});
 }  // namespace PropagationMatrix
 }  // namespace Absorption
 
@@ -1,32 +1,33 @@
 #include "xsec_lbl.h"
 
+#include <algorithm>
 #include <execution>
 
+#include "multithread.h"
+
 namespace Absorption {
 namespace Xsec {
 namespace Lbl {
-union ComputedDerivData {
-  double d;
-  LineShape::Output lso;
-  ComputedDerivData() noexcept : d(0) {}
-};
-
-#define LINESHAPEDERIVATIVES(PARAM)                           \
-  else if (derivs[i] == Derivative::Line::Shape##PARAM##X0) { \
-    out[i].d = lsmod.dX0(T, T0, P, vmr, derivs[i].Species(),  \
-                         LineShape::Parameter::PARAM);        \
-  }                                                           \
-  else if (derivs[i] == Derivative::Line::Shape##PARAM##X1) { \
-    out[i].d = lsmod.dX1(T, T0, P, vmr, derivs[i].Species(),  \
-                         LineShape::Parameter::PARAM);        \
-  }                                                           \
-  else if (derivs[i] == Derivative::Line::Shape##PARAM##X2) { \
-    out[i].d = lsmod.dX2(T, T0, P, vmr, derivs[i].Species(),  \
-                         LineShape::Parameter::PARAM);        \
-  }                                                           \
-  else if (derivs[i] == Derivative::Line::Shape##PARAM##X3) { \
-    out[i].d = lsmod.dX3(T, T0, P, vmr, derivs[i].Species(),  \
-                         LineShape::Parameter::PARAM);        \
+#define LINESHAPEDERIVATIVES(PARAM)                                \
+  else if (derivs[i] == Derivative::Line::Shape##PARAM##X0) {      \
+    out[i].d = LineShape::Model::dX0(first, last, T, T0, P, vmr,   \
+                                     derivs[i].Species(),          \
+                                     LineShape::Parameter::PARAM); \
+  }                                                                \
+  else if (derivs[i] == Derivative::Line::Shape##PARAM##X1) {      \
+    out[i].d = LineShape::Model::dX1(first, last, T, T0, P, vmr,   \
+                                     derivs[i].Species(),          \
+                                     LineShape::Parameter::PARAM); \
+  }                                                                \
+  else if (derivs[i] == Derivative::Line::Shape##PARAM##X2) {      \
+    out[i].d = LineShape::Model::dX2(first, last, T, T0, P, vmr,   \
+                                     derivs[i].Species(),          \
+                                     LineShape::Parameter::PARAM); \
+  }                                                                \
+  else if (derivs[i] == Derivative::Line::Shape##PARAM##X3) {      \
+    out[i].d = LineShape::Model::dX3(first, last, T, T0, P, vmr,   \
+                                     derivs[i].Species(),          \
+                                     LineShape::Parameter::PARAM); \
   }
 
 void update_derivatives(std::vector<ComputedDerivData> &cpp,
@@ -40,21 +41,28 @@ void update_derivatives(std::vector<ComputedDerivData> &cpp,
   }
 }
 
-std::vector<ComputedDerivData> process_derivatives(
-    const std::vector<Derivative::Target> &derivs,
-    const Absorption::LineShape::Model &lsmod,
-    Temperature<TemperatureType::K> T, Temperature<TemperatureType::K> T0,
-    Pressure<PressureType::Pa> P,
-    const std::vector<VMR<VMRType::ratio>> &vmr) noexcept {
+/** Sets out to the line shape derivatives of a line with the model made of
+ * the species [first, last), dXdT is its temperature derivative from the band
+ */
+void process_derivatives(std::vector<ComputedDerivData> &out,
+                         const std::vector<Derivative::Target> &derivs,
+                         const LineShape::AllSingleParameters *first,
+                         const LineShape::AllSingleParameters *last,
+                         const LineShape::Output &dXdT,
+                         Temperature<TemperatureType::K> T,
+                         Temperature<TemperatureType::K> T0,
+                         Pressure<PressureType::Pa> P,
+                         const VMRs &vmr) noexcept {
   const std::size_t n = derivs.size();
 
-  std::vector<ComputedDerivData> out(n);
+  out.assign(n, ComputedDerivData{});
 
   for (std::size_t i = 0; i < n; i++) {
     if (derivs[i] == Derivative::Atm::Temperature) {
-      out[i].lso = lsmod.dT(T, T0, P, vmr);
+      out[i].lso = dXdT;
     } else if (derivs[i] == Derivative::Atm::VMR) {
-      out[i].lso = out[i].lso = lsmod.dVMR(T, T0, P, vmr, derivs[i].Species());
+      out[i].lso = LineShape::Model::dVMR(first, last, T, T0, P, vmr,
+                                          derivs[i].Species());
     }
     LINESHAPEDERIVATIVES(G0)
     LINESHAPEDERIVATIVES(D0)
@@ -66,12 +74,31 @@ std::vector<ComputedDerivData> process_derivatives(
     LINESHAPEDERIVATIVES(G)
     LINESHAPEDERIVATIVES(DV)
   }
-
-  return out;
 }
 
 #undef LINESHAPEDERIVATIVES
 
+/** Indices [first, last) of the frequencies that a line is computed for */
+struct Window {
+  size_t first;
+  size_t last;
+
+  /** The frequencies of f between low and upp
+   *
+   * Binary searched on sorted grids, otherwise all of f, in which case the
+   * line shape tests every frequency against the cutoff
+   */
+  Window(const std::vector<Frequency<FrequencyType::Freq>> &f, bool sorted,
+         Frequency<FrequencyType::Freq> low,
+         Frequency<FrequencyType::Freq> upp) noexcept
+      : first(0), last(f.size()) {
+    if (sorted) {
+      first = std::lower_bound(f.cbegin(), f.cend(), low) - f.cbegin();
+      last = std::upper_bound(f.cbegin() + first, f.cend(), upp) - f.cbegin();
+    }
+  }
+};
+
 template <class LineShape>
 void compute_lineshape(std::vector<Complex> &comp_x,
                        std::vector<std::vector<Complex>> &comp_dx,
@@ -82,58 +109,92 @@ void compute_lineshape(std::vector<Complex> &comp_x,
                        std::size_t this_line,
                        Frequency<FrequencyType::Freq> cutoff_low,
                        Frequency<FrequencyType::Freq> cutoff_upp,
-                       LineShape ls) {
-  const size_t nv = f.size();
+                       const Window &win, LineShape ls) {
   const size_t nd = derivs.size();
+  constexpr size_t nw = LineShape::nw;
 
-  for (size_t iv = 0; iv < nv; iv++) {
-    if (cutoff_low <= f[iv] and f[iv] <= cutoff_upp) {
-      comp_x[iv] = lm * ls(f[iv]);
-      for (size_t id = 0; id < nd; id++) {
-        if (derivs[id] == Derivative::Atm::Temperature) {
-          comp_dx[id][iv] = lm * ls.dFdT(cdd[id].lso, T) +
-                            linemixing_derivative(cdd[id].lso) * ls.F;
-        } else if (derivs[id].isWind()) {
-          comp_dx[id][iv] = lm * ls.dFdf();  // WARNING: Not true derivative
-        } else if (derivs[id].isMagnetism()) {
-          comp_dx[id][iv] = lm * ls.dFdH(cdd[id].d);
-        } else if (derivs[id] == Derivative::Atm::VMR and
-                   isnonzero(cdd[id].lso)) {
-          comp_dx[id][iv] = lm * ls.dFdVMR(cdd[id].lso) +
-                            linemixing_derivative(cdd[id].lso) * ls.F;
-        } else if (derivs[id].isLineCenter(this_line)) {
-          comp_dx[id][iv] = lm * ls.dFdF0();
-        } else if (derivs[id].isshapeG0()) {
-          comp_dx[id][iv] = lm * ls.dFdG0(cdd[id].d);
-        } else if (derivs[id].isshapeD0()) {
-          comp_dx[id][iv] = lm * ls.dFdD0(cdd[id].d);
-        } else if (derivs[id].isshapeG2()) {
-          comp_dx[id][iv] = lm * ls.dFdG2(cdd[id].d);
-        } else if (derivs[id].isshapeD2()) {
-          comp_dx[id][iv] = lm * ls.dFdD2(cdd[id].d);
-        } else if (derivs[id].isshapeFVC()) {
-          comp_dx[id][iv] = lm * ls.dFdFVC(cdd[id].d);
-        } else if (derivs[id].isshapeETA()) {
-          comp_dx[id][iv] = lm * ls.dFdETA(cdd[id].d);
-        } else if (derivs[id].isshapeY()) {
-          comp_dx[id][iv] = Complex(0, -cdd[id].d) * ls.F;
-        } else if (derivs[id].isshapeG()) {
-          comp_dx[id][iv] = cdd[id].d * ls.F;
-        } else if (derivs[id].isshapeDV()) {
-          comp_dx[id][iv] = lm * ls.dFdDV(cdd[id].d);
+  // Sets the line shape at f[iv] to the last evaluated frequency of ls
+  const auto set = [&](size_t iv) {
+    comp_x[iv] = lm * ls.F;
+    for (size_t id = 0; id < nd; id++) {
+      if (derivs[id] == Derivative::Atm::Temperature) {
+        comp_dx[id][iv] = lm * ls.dFdT(cdd[id].lso, T) +
+                          linemixing_derivative(cdd[id].lso) * ls.F;
+      } else if (derivs[id].isWind()) {
+        comp_dx[id][iv] = lm * ls.dFdf();  // WARNING: Not true derivative
+      } else if (derivs[id].isMagnetism()) {
+        comp_dx[id][iv] = lm * ls.dFdH(cdd[id].d);
+      } else if (derivs[id] == Derivative::Atm::VMR and
+                 isnonzero(cdd[id].lso)) {
+        comp_dx[id][iv] = lm * ls.dFdVMR(cdd[id].lso) +
+                          linemixing_derivative(cdd[id].lso) * ls.F;
+      } else if (derivs[id].isLineCenter(this_line)) {
+        comp_dx[id][iv] = lm * ls.dFdF0();
+      } else if (derivs[id].isshapeG0()) {
+        comp_dx[id][iv] = lm * ls.dFdG0(cdd[id].d);
+      } else if (derivs[id].isshapeD0()) {
+        comp_dx[id][iv] = lm * ls.dFdD0(cdd[id].d);
+      } else if (derivs[id].isshapeG2()) {
+        comp_dx[id][iv] = lm * ls.dFdG2(cdd[id].d);
+      } else if (derivs[id].isshapeD2()) {
+        comp_dx[id][iv] = lm * ls.dFdD2(cdd[id].d);
+      } else if (derivs[id].isshapeFVC()) {
+        comp_dx[id][iv] = lm * ls.dFdFVC(cdd[id].d);
+      } else if (derivs[id].isshapeETA()) {
+        comp_dx[id][iv] = lm * ls.dFdETA(cdd[id].d);
+      } else if (derivs[id].isshapeY()) {
+        comp_dx[id][iv] = Complex(0, -cdd[id].d) * ls.F;
+      } else if (derivs[id].isshapeG()) {
+        comp_dx[id][iv] = cdd[id].d * ls.F;
+      } else if (derivs[id].isshapeDV()) {
+        comp_dx[id][iv] = lm * ls.dFdDV(cdd[id].d);
+      }
+    }
+  };
+
+  const auto outside = [&](size_t iv) {
+    comp_x[iv] = Complex(0, 0);
+    for (size_t id = 0; id < nd; id++) comp_dx[id][iv] = Complex(0, 0);
+  };
+
+  if constexpr (nw > 0) {
+    // The Faddeeva function of a block of frequencies at once, only for the
+    // arguments each frequency inside the cutoff actually needs
+    constexpr size_t nb = 64;
+    typename LineShape::State s[nb];
+    Complex w[nb * nw];
+    for (size_t first = win.first; first < win.last; first += nb) {
+      const size_t last = std::min(first + nb, win.last);
+      size_t n = 0;
+      for (size_t iv = first; iv < last; iv++)
+        if (cutoff_low <= f[iv] and f[iv] <= cutoff_upp)
+          n += ls.w_args(f[iv], w + n, s[iv - first]);
+      Faddeeva::w(w, w, n);
+
+      for (size_t iv = first, k = 0; iv < last; iv++) {
+        if (cutoff_low <= f[iv] and f[iv] <= cutoff_upp) {
+          ls(s[iv - first], w + k);
+          k += s[iv - first].n;
+          set(iv);
+        } else {
+          outside(iv);
         }
       }
-    } else {
-      comp_x[iv] = Complex(0, 0);
-      for (size_t id = 0; id < nd; id++) {
-        comp_dx[id][iv] = Complex(0, 0);
+    }
+  } else {
+    for (size_t iv = win.first; iv < win.last; iv++) {
+      if (cutoff_low <= f[iv] and f[iv] <= cutoff_upp) {
+        ls(f[iv]);
+        set(iv);
+      } else {
+        outside(iv);
       }
     }
   }
 
   if (cutoff_upp > 0.0) {
     ls(cutoff_upp);
-    for (size_t iv = 0; iv < nv; iv++) {
+    for (size_t iv = win.first; iv < win.last; iv++) {
       if (cutoff_low <= f[iv] and f[iv] <= cutoff_upp) {
         comp_x[iv] -= lm * ls.F;
         for (size_t id = 0; id < nd; id++) {
@@ -313,15 +374,23 @@ void compute_lte_linestrength(
     LineStrength<FrequencyType::Freq, AreaType::m2> S0, double SZ,
     Energy<EnergyType::Joule> E0, Frequency<FrequencyType::Freq> F0, double QT0,
     Temperature<TemperatureType::K> T0, double QT, double dQTdT,
-    double mixing_ratio, size_t line_id, Species::Isotope line_spec) {
+    double mixing_ratio, size_t line_id, Species::Isotope line_spec,
+    const Window &win) {
   const double K1 = boltzman_ratio(atm.atm.Temp(), T0, E0);
   const double gamma = stimulated_emission(atm.atm.Temp(), F0);
   const double gamma0 = stimulated_emission(T0, F0);
   const double K2 = stimulated_relative_emission(gamma, gamma0);
   const double lte = mixing_ratio * SZ * S0 * K1 * K2 * QT0 / QT;
+  const size_t i0 = win.first;
+  const size_t nv = win.last;
 
-  std::transform(comp.x.cbegin(), comp.x.cend(), res.x.begin(),
-                 [lte](auto &x) { return lte * x; });
+  // Adds a * x + b * dx to the results
+  auto add = [i0, nv](std::vector<Complex> &r, const std::vector<Complex> &x,
+                      double a, const std::vector<Complex> &dx, double b) {
+    for (size_t iv = i0; iv < nv; iv++) r[iv] += a * x[iv] + b * dx[iv];
+  };
+
+  for (size_t iv = i0; iv < nv; iv++) res.x[iv] += lte * comp.x[iv];
   for (size_t i = 0; i < derivs.size(); i++) {
     if (derivs[i] == Derivative::Atm::Temperature) {
       const double dK1dT = dboltzman_ratio_dT(K1, atm.atm.Temp(), E0);
@@ -330,52 +399,34 @@ void compute_lte_linestrength(
       const double dltedT = mixing_ratio * SZ * S0 * dK1dT * K2 * QT0 / QT +
                             mixing_ratio * SZ * S0 * K1 * dK2dT * QT0 / QT -
                             dQTdT * lte / QT;
-      std::transform(comp.x.cbegin(), comp.x.cend(), comp.dx[i].cbegin(),
-                     res.dx[i].begin(), [dltedT, lte](auto &x, auto &dx) {
-                       return dltedT * x + lte * dx;
-                     });
-
+      add(res.dx[i], comp.x, dltedT, comp.dx[i], lte);
     } else if (derivs[i].isLineCenter(line_id)) {
       const double dK2dF0 =
           dstimulated_relative_emission_dF0(gamma, gamma0, atm.atm.Temp(), T0);
       const double dltedF0 = mixing_ratio * SZ * S0 * K1 * dK2dF0 * QT0 / QT;
-      std::transform(comp.x.cbegin(), comp.x.cend(), comp.dx[i].cbegin(),
-                     res.dx[i].begin(), [dltedF0, lte](auto &x, auto &dx) {
-                       return dltedF0 * x + lte * dx;
-                     });
+      add(res.dx[i], comp.x, dltedF0, comp.dx[i], lte);
     } else if (derivs[i].isLineStrength(line_id)) {
       const double dltedS0 = lte / S0;  // OK beause S0 cannot be 0
-      std::transform(comp.x.cbegin(), comp.x.cend(), res.dx[i].begin(),
-                     [dltedS0](auto &x) { return dltedS0 * x; });
+      for (size_t iv = i0; iv < nv; iv++) res.dx[i][iv] += dltedS0 * comp.x[iv];
     } else if (derivs[i].isVMR(line_spec)) {
       const double dltedVMR =
           SZ * S0 * K1 * K2 * QT0 /
           QT;  // mixing_ratio can be 0 but we still have a derivative...
-      std::transform(comp.x.cbegin(), comp.x.cend(), comp.dx[i].cbegin(),
-                     res.dx[i].begin(), [dltedVMR, lte](auto &x, auto &dx) {
-                       return dltedVMR * x + lte * dx;
-                     });
+      add(res.dx[i], comp.x, dltedVMR, comp.dx[i], lte);
     } else if (derivs[i] == Derivative::Atm::WindU) {
       const double dfdwu = atm.DopplerShiftRatioDerivativeU();
-      std::transform(comp.dx[i].cbegin(), comp.dx[i].cend(), fs.cbegin(),
-                     res.dx[i].begin(), [dfdwu, lte](auto &dx, auto &f) {
-                       return dfdwu * lte * f * dx;
-                     });
+      for (size_t iv = i0; iv < nv; iv++)
+        res.dx[i][iv] += dfdwu * lte * fs[iv] * comp.dx[i][iv];
     } else if (derivs[i] == Derivative::Atm::WindV) {
       const double dfdwv = atm.DopplerShiftRatioDerivativeV();
-      std::transform(comp.dx[i].cbegin(), comp.dx[i].cend(), fs.cbegin(),
-                     res.dx[i].begin(), [dfdwv, lte](auto &dx, auto &f) {
-                       return dfdwv * lte * f * dx;
-                     });
+      for (size_t iv = i0; iv < nv; iv++)
+        res.dx[i][iv] += dfdwv * lte * fs[iv] * comp.dx[i][iv];
     } else if (derivs[i] == Derivative::Atm::WindV) {
       const double dfdww = atm.DopplerShiftRatioDerivativeW();
-      std::transform(comp.dx[i].cbegin(), comp.dx[i].cend(), fs.cbegin(),
-                     res.dx[i].begin(), [dfdww, lte](auto &dx, auto &f) {
-                       return dfdww * lte * f * dx;
-                     });
+      for (size_t iv = i0; iv < nv; iv++)
+        res.dx[i][iv] += dfdww * lte * fs[iv] * comp.dx[i][iv];
     } else {
-      std::transform(comp.dx[i].cbegin(), comp.dx[i].cend(), res.dx[i].begin(),
-                     [lte](auto &dx) { return lte * dx; });
+      for (size_t iv = i0; iv < nv; iv++) res.dx[i][iv] += lte * comp.dx[i][iv];
     }
   }
 }
@@ -398,198 +449,587 @@ std::pair<double, double> compute_nlte_linestrength(
   return {SZ * k, SZ * ratio};
 }
 
-void compute(Results &res, Results &src, Results &comp,
+/** Values of a band that are the same for all of its lines */
+struct BandConstants {
+  double H;
+  double GDpart;
+  double QT0;
+  Species::PartitionValue Q;
+  double mixing_ratio;
+  const LineArrays &lines;
+  const ZeemanArrays &zeeman;
+
+  /** Indices of the lines whose cutoff reaches a frequency, increasing */
+  const std::vector<std::size_t> &active;
+
+  /** Line shape parameters of the active lines and their temperature
+   * derivatives, the latter only if they are needed, in the workspace */
+  const std::vector<LineShape::Output> &X;
+  const std::vector<LineShape::Output> &dXdT;
+
+  BandConstants(const Band &band,
+                const std::vector<Frequency<FrequencyType::Freq>> &f,
+                const Path::Point &atm,
+                const std::vector<Derivative::Target> &derivs, Workspace &ws)
+      : H(atm.atm.MagField().Strength()),
+        GDpart(band.GD_giv_F0(atm.atm.Temp())),
+        QT0(band.QT0()),
+        Q(band.Partition(atm.atm.Temp())),
+        mixing_ratio(atm.atm.VolumeMixingRatio(band.Isotopologue())),
+        lines(band.Arrays()),
+        zeeman(band.Zeeman()),
+        active(ws.active),
+        X(ws.X),
+        dXdT(ws.dXdT) {
+    ws.active.clear();
+    if (not f.empty()) {
+      const auto [fmin, fmax] = std::minmax_element(f.cbegin(), f.cend());
+      for (size_t i = 0; i < band.n_lines(); i++)
+        if (band.CutoffLower(i) <= *fmax and *fmin <= band.CutoffUpper(i))
+          ws.active.push_back(i);
+    }
+
+    ws.X.resize(band.n_lines());
+    if (std::find(derivs.cbegin(), derivs.cend(),
+                  Derivative::Atm::Temperature) not_eq derivs.cend())
+      ws.dXdT.resize(band.n_lines());
+    else
+      ws.dXdT.clear();
+
+    lines.ShapeModels(
+        ws.active, LineShape::State(atm.atm.Temp(), band.T0(), atm.atm.Pres()),
+        atm.atm.VolumeMixingRatios(), ws.X.data(),
+        ws.dXdT.empty() ? nullptr : ws.dXdT.data());
+  }
+};
+
+/** Adds the absorption of a single line to res and src, comp and cdd are
+ * scratch */
+void compute_line(Results &res, Results &src, Results &comp,
+                  std::vector<ComputedDerivData> &cdd,
+                  const std::vector<Frequency<FrequencyType::Freq>> &f,
+                  const Band &band, const Path::Point &atm,
+                  const std::vector<Derivative::Target> &derivs,
+                  const Polarization polarization, const BandConstants &bc,
+                  bool sorted, size_t iline) {
+  const double H = bc.H;
+  const double GDpart = bc.GDpart;
+
+  const auto cutoff_low = band.CutoffLower(iline);
+  const auto cutoff_upp = band.CutoffUpper(iline);
+  const Window win(f, sorted, cutoff_low, cutoff_upp);
+  if (win.first == win.last) return;
+
+  const auto &la = bc.lines;
+  const auto F0 = la.f0[iline];
+  const auto id = la.id[iline];
+  const auto &X = bc.X[iline];
+  const Complex lm{1.0 + X.G, -X.Y};
+
+  process_derivatives(
+      cdd, derivs, la.shape.data() + la.shape_offset[iline],
+      la.shape.data() + la.shape_offset[iline + 1],
+      bc.dXdT.empty() ? LineShape::Output{} : bc.dXdT[iline], atm.atm.Temp(),
+      band.T0(), atm.atm.Pres(), atm.atm.VolumeMixingRatios());
+
+  const auto &zeeman_offset = bc.zeeman.offset[size_t(polarization)];
+  const auto &zeeman_splitting = bc.zeeman.splitting[size_t(polarization)];
+  const auto &zeeman_strength = bc.zeeman.strength[size_t(polarization)];
+  for (size_t iz = zeeman_offset[iline]; iz < zeeman_offset[iline + 1]; iz++) {
+    const auto DZ = zeeman_splitting[iz];
+    const auto SZ = zeeman_strength[iz];
+
+    // Update the derivatives for Zeeman line
+    update_derivatives(cdd, derivs, DZ);
+
+    // Forward Line Shape
+    switch (band.ShapeType()) {
+      case Shape::DP:
+        compute_lineshape(
+            comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), id,
+            cutoff_low, cutoff_upp, win,
+            LineShape::Base::Doppler(F0, X, GDpart, DZ * H));
+        break;
+      case Shape::LP:
+        compute_lineshape(
+            comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), id,
+            cutoff_low, cutoff_upp, win,
+            LineShape::Base::Lorentz(F0, X, GDpart, DZ * H));
+        break;
+      case Shape::VP:
+        compute_lineshape(
+            comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), id,
+            cutoff_low, cutoff_upp, win,
+            LineShape::Base::Voigt(F0, X, GDpart, DZ * H));
+        break;
+      case Shape::SDVP:
+        compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
+                          id, cutoff_low, cutoff_upp, win,
+                          LineShape::Base::SpeedDependentVoigt(
+                              F0, X, GDpart, DZ * H));
+        break;
+      case Shape::SDHCVP:
+        compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
+                          id, cutoff_low, cutoff_upp, win,
+                          LineShape::Base::SpeedDependentHardCollisionVoigt(
+                              F0, X, GDpart, DZ * H));
+        break;
+      case Shape::HTP:
+        compute_lineshape(
+            comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), id,
+            cutoff_low, cutoff_upp, win,
+            LineShape::Base::HartmannTran(F0, X, GDpart, DZ * H));
+        break;
+      case Shape::FINAL: { /* leave last */
+      }
+    }
+
+    // Mirrored Line Shape
+    switch (band.MirrorType()) {
+      case Mirroring::Same:
+        switch (band.ShapeType()) {
+          case Shape::DP:
+            compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
+                              atm.atm.Temp(), id, cutoff_low,
+                              cutoff_upp, win,
+                              LineShape::Base::Doppler(
+                                  -F0, mirrored(X), -GDpart, DZ * H));
+            break;
+          case Shape::LP:
+            compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
+                              atm.atm.Temp(), id, cutoff_low,
+                              cutoff_upp, win,
+                              LineShape::Base::Lorentz(
+                                  -F0, mirrored(X), -GDpart, DZ * H));
+            break;
+          case Shape::VP:
+            compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
+                              atm.atm.Temp(), id, cutoff_low,
+                              cutoff_upp, win,
+                              LineShape::Base::Voigt(-F0, mirrored(X),
+                                                     -GDpart, DZ * H));
+            break;
+          case Shape::SDVP:
+            compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
+                              atm.atm.Temp(), id, cutoff_low,
+                              cutoff_upp, win,
+                              LineShape::Base::SpeedDependentVoigt(
+                                  -F0, mirrored(X), -GDpart, DZ * H));
+            break;
+          case Shape::SDHCVP:
+            compute_lineshape(
+                comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
+                id, cutoff_low, cutoff_upp, win,
+                LineShape::Base::SpeedDependentHardCollisionVoigt(
+                    -F0, mirrored(X), -GDpart, DZ * H));
+            break;
+          case Shape::HTP:
+            compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
+                              atm.atm.Temp(), id, cutoff_low,
+                              cutoff_upp, win,
+                              LineShape::Base::HartmannTran(
+                                  -F0, mirrored(X), -GDpart, DZ * H));
+            break;
+          case Shape::FINAL: { /* leave last */
+          }
+        }
+        break;
+      case Mirroring::Lorentz:
+        compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
+                          id, cutoff_low, cutoff_upp, win,
+                          LineShape::Base::Lorentz(-F0, mirrored(X),
+                                                   -GDpart, DZ * H));
+        break;
+      case Mirroring::None:
+      case Mirroring::FINAL: { /* leave last */
+      }
+    }
+
+    // Normalized Line Shape
+    switch (band.NormType()) {
+      case Normalization::VVH:
+        //           apply_VVH_scaling(F, dF, data, f, band.F0(i), T, band, i,
+        //           derivatives_data, derivatives_data_active);
+        break;
+      case Normalization::VVW:
+        //           apply_VVW_scaling(F, dF, f, band.F0(i), band, i,
+        //           derivatives_data, derivatives_data_active);
+        break;
+      case Normalization::RosenkranzQuadratic:
+        //           apply_rosenkranz_quadratic_scaling(F, dF, f, band.F0(i),
+        //           T, band, i, derivatives_data, derivatives_data_active);
+        break;
+      case Normalization::None:
+      case Normalization::FINAL: { /* leave last */
+      }
+    }
+
+    // Apply line strength by whatever method is necessary
+    switch (band.PopType()) {
+      case Population::ByLTE: {
+        compute_lte_linestrength(res, comp, f, atm, derivs, la.i0[iline], SZ,
+                                 la.e0[iline], F0, bc.QT0, band.T0(),
+                                 bc.Q.Q, bc.Q.dQdT, bc.mixing_ratio, id,
+                                 band.Isotopologue(), win);
+      } break;
+      case Population::ByNLTE: {
+        double r1 = 0, r2 = 0;  // FIXME: Input the correct numbers when
+                                // operating in NLTE mode
+
+        const std::pair<double, double> S =
+            compute_nlte_linestrength(SZ, F0, la.gl[iline], la.gu[iline],
+                                      la.a[iline], r2, r1, atm.atm.Temp());
+
+        for (size_t iv = win.first; iv < win.last; iv++) {
+          res.x[iv] += S.first * comp.x[iv];
+          src.x[iv] += S.second * comp.x[iv];
+        }
+      } break;
+      case Population::FINAL: { /* leave last */
+      }
+    }
+  }
+}
+
+/** Sums the lines of a block of a band for the parallel reduction
+ *
+ * Every block gets its own results and scratch space, so no two threads ever
+ * write to the same memory
+ */
+struct LineSum {
+  Multithread::Pool<LineBlock> &pool;
+  std::unique_ptr<LineBlock> block;
+  const std::vector<Frequency<FrequencyType::Freq>> &f;
+  const Band &band;
+  const Path::Point &atm;
+  const std::vector<Derivative::Target> &derivs;
+  const Polarization polarization;
+  const BandConstants &bc;
+  const bool sorted;
+
+  LineSum(const std::vector<Frequency<FrequencyType::Freq>> &f_,
+          const Band &band_, const Path::Point &atm_,
+          const std::vector<Derivative::Target> &derivs_,
+          const Polarization polarization_, const BandConstants &bc_,
+          bool sorted_, Multithread::Pool<LineBlock> &pool_)
+      : pool(pool_),
+        block(pool_.take()),
+        f(f_),
+        band(band_),
+        atm(atm_),
+        derivs(derivs_),
+        polarization(polarization_),
+        bc(bc_),
+        sorted(sorted_) {
+    block->res.reset(f.size(), derivs.size());
+    block->src.reset(f.size(), derivs.size());
+    block->comp.reset(f.size(), derivs.size());
+  }
+
+  LineSum(LineSum &x, tbb::split)
+      : LineSum(x.f, x.band, x.atm, x.derivs, x.polarization, x.bc, x.sorted,
+                x.pool) {}
+
+  ~LineSum() { pool.give(std::move(block)); }
+
+  void operator()(const tbb::blocked_range<size_t> &r) {
+    for (size_t k = r.begin(); k not_eq r.end(); ++k)
+      compute_line(block->res, block->src, block->comp, block->cdd, f, band,
+                   atm, derivs, polarization, bc, sorted, bc.active[k]);
+  }
+
+  void join(const LineSum &x) {
+    block->res += x.block->res;
+    block->src += x.block->src;
+  }
+};  // LineSum
+
+void compute(Results &res, Results &src, Workspace &ws,
              const std::vector<Frequency<FrequencyType::Freq>> &f,
              const Band &band, const Path::Point &atm,
              const std::vector<Derivative::Target> &derivs,
              const Polarization polarization) {
-  const double H = atm.atm.MagField().Strength();
-  const double GDpart = band.GD_giv_F0(atm.atm.Temp());
-  const double QT0 = band.QT0();
-  const double QT = band.QT(atm.atm.Temp());
-  const double dQTdT = band.dQT(atm.atm.Temp());
-  const double mixing_ratio = atm.atm.VolumeMixingRatio(band.Isotopologue());
-
   // Skip Zeeman copies if Zeeman or without
   if (band.doZeeman() and polarization == Polarization::None)
     return;
   else if (not band.doZeeman() and polarization not_eq Polarization::None)
     return;
 
-  for (size_t iline = 0; iline < band.n_lines(); iline++) {
-    const auto &line = band.Lines()[iline];
-    const auto zeeman_range =
-        line.ZeemanRange(polarization, band.Isotopologue());
-    const auto X = line.ShapeModel()(atm.atm.Temp(), band.T0(), atm.atm.Pres(),
-                                     atm.atm.VolumeMixingRatios());
-    const Complex lm{1.0 + X.G, -X.Y};
-
-    auto cdd = process_derivatives(derivs, line.ShapeModel(), atm.atm.Temp(),
-                                   band.T0(), atm.atm.Pres(),
-                                   atm.atm.VolumeMixingRatios());
-
-    for (int iz = zeeman_range.first; iz <= zeeman_range.second; iz++) {
-      const auto DZ =
-          line.ZeemanSplitting(polarization, band.Isotopologue(), iz);
-      const auto SZ =
-          line.ZeemanStrength(polarization, band.Isotopologue(), iz);
-      const auto cutoff_low = band.CutoffLower(iline);
-      const auto cutoff_upp = band.CutoffUpper(iline);
-
-      // Update the derivatives for Zeeman line
-      update_derivatives(cdd, derivs, DZ);
-
-      // Forward Line Shape
-      switch (band.ShapeType()) {
-        case Shape::DP:
-          compute_lineshape(
-              comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), line.ID(),
-              cutoff_low, cutoff_upp,
-              LineShape::Base::Doppler(line.F0(), X, GDpart, DZ * H));
-          break;
-        case Shape::LP:
-          compute_lineshape(
-              comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), line.ID(),
-              cutoff_low, cutoff_upp,
-              LineShape::Base::Lorentz(line.F0(), X, GDpart, DZ * H));
-          break;
-        case Shape::VP:
-          compute_lineshape(
-              comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), line.ID(),
-              cutoff_low, cutoff_upp,
-              LineShape::Base::Voigt(line.F0(), X, GDpart, DZ * H));
-          break;
-        case Shape::SDVP:
-          compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
-                            line.ID(), cutoff_low, cutoff_upp,
-                            LineShape::Base::SpeedDependentVoigt(
-                                line.F0(), X, GDpart, DZ * H));
-          break;
-        case Shape::SDHCVP:
-          compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
-                            line.ID(), cutoff_low, cutoff_upp,
-                            LineShape::Base::SpeedDependentHardCollisionVoigt(
-                                line.F0(), X, GDpart, DZ * H));
-          break;
-        case Shape::HTP:
-          compute_lineshape(
-              comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(), line.ID(),
-              cutoff_low, cutoff_upp,
-              LineShape::Base::HartmannTran(line.F0(), X, GDpart, DZ * H));
-          break;
-        case Shape::FINAL: { /* leave last */
-        }
-      }
+  const BandConstants bc(band, f, atm, derivs, ws);
+
+  // Lines only visit the frequencies inside their cutoff when this is known
+  const bool sorted = std::is_sorted(f.cbegin(), f.cend());
+
+  // Small bands are not worth the overhead of threads
+  if (bc.active.size() < 2 * line_grain) {
+    // Every line overwrites the scratch space so it only needs the sizes
+    if (ws.comp.x.size() not_eq f.size() or
+        ws.comp.dx.size() not_eq derivs.size())
+      ws.comp.reset(f.size(), derivs.size());
+
+    for (size_t iline : bc.active)
+      compute_line(res, src, ws.comp, ws.cdd, f, band, atm, derivs,
+                   polarization, bc, sorted, iline);
+    return;
+  }
+
+  LineSum sum(f, band, atm, derivs, polarization, bc, sorted, ws.blocks);
+  Multithread::deterministic_reduce(Multithread::Arena::Compute, 0,
+                                    bc.active.size(), sum, line_grain);
+  res += sum.block->res;
+  src += sum.block->src;
+}
+
+namespace {
+/** Bound of |F| of a Doppler, Lorentz or Voigt line shape at least df from
+ * the line centre, for Doppler half widths from GD0 to GD1 and pressure half
+ * widths from G0 on
+ *
+ * The Voigt shape is the Doppler shape convolved with the Lorentz shape, so
+ * it is bounded by the largest value of either shape, and by splitting the
+ * convolution at df / 2 into the Lorentz shape at df / 2 plus the Doppler
+ * shape beyond df / 2 times the largest Lorentz value
+ */
+double shape_bound(Shape shape, double df, double GD0, double GD1,
+                   double G0) noexcept {
+  if (shape == Shape::LP) return Constant::inv_pi / std::hypot(df, G0);
 
-      // Mirrored Line Shape
-      switch (band.MirrorType()) {
-        case Mirroring::Same:
-          switch (band.ShapeType()) {
-            case Shape::DP:
-              compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
-                                atm.atm.Temp(), line.ID(), cutoff_low,
-                                cutoff_upp,
-                                LineShape::Base::Doppler(
-                                    -line.F0(), mirrored(X), -GDpart, DZ * H));
-              break;
-            case Shape::LP:
-              compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
-                                atm.atm.Temp(), line.ID(), cutoff_low,
-                                cutoff_upp,
-                                LineShape::Base::Lorentz(
-                                    -line.F0(), mirrored(X), -GDpart, DZ * H));
-              break;
-            case Shape::VP:
-              compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
-                                atm.atm.Temp(), line.ID(), cutoff_low,
-                                cutoff_upp,
-                                LineShape::Base::Voigt(-line.F0(), mirrored(X),
-                                                       -GDpart, DZ * H));
-              break;
-            case Shape::SDVP:
-              compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
-                                atm.atm.Temp(), line.ID(), cutoff_low,
-                                cutoff_upp,
-                                LineShape::Base::SpeedDependentVoigt(
-                                    -line.F0(), mirrored(X), -GDpart, DZ * H));
-              break;
-            case Shape::SDHCVP:
-              compute_lineshape(
-                  comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
-                  line.ID(), cutoff_low, cutoff_upp,
-                  LineShape::Base::SpeedDependentHardCollisionVoigt(
-                      -line.F0(), mirrored(X), -GDpart, DZ * H));
-              break;
-            case Shape::HTP:
-              compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm,
-                                atm.atm.Temp(), line.ID(), cutoff_low,
-                                cutoff_upp,
-                                LineShape::Base::HartmannTran(
-                                    -line.F0(), mirrored(X), -GDpart, DZ * H));
-              break;
-            case Shape::FINAL: { /* leave last */
+  if (shape == Shape::DP) {
+    const double GD = std::clamp(df * std::sqrt(2 * Constant::ln_2), GD0, GD1);
+    const double invGD = Constant::sqrt_ln_2 / GD;
+    return Constant::inv_sqrt_pi * invGD *
+           std::exp(-Constant::pow2(invGD * df));
+  }
+
+  const double doppler = Constant::inv_sqrt_pi * Constant::sqrt_ln_2 / GD0;
+  if (not(G0 > 0)) return doppler;
+  const double lorentz = Constant::inv_pi / G0;
+  const double split =
+      Constant::inv_pi / std::hypot(0.5 * df, G0) +
+      std::erfc(Constant::sqrt_ln_2 * df / (2 * GD1)) * lorentz;
+  return std::min({doppler, lorentz, split});
+}
+
+/** Distance from x to the nearest frequency of the sorted f */
+double distance(const std::vector<Frequency<FrequencyType::Freq>> &f,
+                double x) noexcept {
+  const auto upp = std::lower_bound(f.cbegin(), f.cend(), x);
+  double out = std::numeric_limits<double>::infinity();
+  if (upp not_eq f.cend()) out = upp->value() - x;
+  if (upp not_eq f.cbegin()) out = std::min(out, x - std::prev(upp)->value());
+  return out;
+}
+
+/** Distance from [lo, hi] to the nearest frequency of the sorted f */
+double distance(const std::vector<Frequency<FrequencyType::Freq>> &f,
+                double lo, double hi) noexcept {
+  const auto upp = std::lower_bound(f.cbegin(), f.cend(), lo);
+  if (upp not_eq f.cend() and upp->value() <= hi) return 0;
+  return std::min(distance(f, lo), distance(f, hi));
+}
+
+/** The largest absorption of each line of the band at a frequency of the
+ * sorted f and any point interpolated in atm, or infinity if it cannot be
+ * bounded
+ *
+ * Interpolation mixes the grid points of one cell of neighbouring points, so
+ * the temperature, pressure, volume mixing ratio and magnetic field of a
+ * point in a cell are within their ranges over the cell.  The line strength
+ * is bounded by the largest value of each of its factors over the range of
+ * temperatures, each being monotonic in temperature.  The line shape
+ * parameters are taken as their extremes at the lowest and highest
+ * temperature and pressure with the volume mixing ratios of every point of
+ * the cell, which holds for parameters monotonic in temperature and pressure
+ */
+std::vector<double> line_bounds(
+    const Band &band, const std::vector<Frequency<FrequencyType::Freq>> &f,
+    const Atmosphere::Atm &atm) {
+  const size_t n = band.n_lines();
+  if (band.PopType() not_eq Population::ByLTE or
+      not(band.ShapeType() == Shape::DP or band.ShapeType() == Shape::LP or
+          band.ShapeType() == Shape::VP))
+    return std::vector<double>(n, std::numeric_limits<double>::infinity());
+
+  const auto &la = band.Arrays();
+  const double factor = (band.CutType() == Cutoff::None ? 1 : 2) *
+                        (band.MirrorType() == Mirroring::None ? 1 : 2);
+
+  // The Zeeman components move the lines at most this far per unit field
+  std::vector<double> zeeman(n, 0);
+  if (band.doZeeman()) {
+    for (auto p : {Polarization::SigmaMinus, Polarization::Pi,
+                   Polarization::SigmaPlus}) {
+      const auto &offset = band.Zeeman().offset[size_t(p)];
+      const auto &splitting = band.Zeeman().splitting[size_t(p)];
+      if (offset.size() not_eq n + 1) continue;
+      for (size_t i = 0; i < n; i++)
+        for (size_t iz = offset[i]; iz < offset[i + 1]; iz++)
+          zeeman[i] = std::max(zeeman[i], std::abs(splitting[iz].value()));
+    }
+  }
+
+  // A cell starts at every grid point but the last of each dimension
+  const std::array<size_t, 4> size{atm.ntid(), atm.nalt(), atm.nlat(),
+                                   atm.nlon()};
+  std::array<size_t, 4> ncell;
+  for (size_t d = 0; d < 4; d++) ncell[d] = size[d] > 1 ? size[d] - 1 : 1;
+
+  std::vector<double> out(n, 0);
+  std::vector<LineShape::Output> X(n);
+  std::vector<double> cmin(n), cmax(n), G0min(n), mixing(n);
+  std::vector<VMRs> vmrs;
+  for (size_t it = 0; it < ncell[0]; it++) {
+    for (size_t ia = 0; ia < ncell[1]; ia++) {
+      for (size_t ila = 0; ila < ncell[2]; ila++) {
+        for (size_t ilo = 0; ilo < ncell[3]; ilo++) {
+          const std::array<size_t, 4> first{it, ia, ila, ilo};
+          double Tmin = std::numeric_limits<double>::infinity();
+          double Tmax = -Tmin, Pmin = Tmin, Pmax = -Tmin, vmr = 0, H = 0;
+          vmrs.clear();
+          for (size_t corner = 0; corner < 16; corner++) {
+            std::array<size_t, 4> k;
+            bool dup = false;
+            for (size_t d = 0; d < 4; d++) {
+              k[d] = first[d] + ((corner >> d) & 1);
+              dup = dup or k[d] == size[d];
             }
+            if (dup) continue;
+
+            const auto &p = atm(k[0], k[1], k[2], k[3]);
+            Tmin = std::min<double>(Tmin, p.Temp());
+            Tmax = std::max<double>(Tmax, p.Temp());
+            Pmin = std::min<double>(Pmin, p.Pres());
+            Pmax = std::max<double>(Pmax, p.Pres());
+            vmr = std::max(
+                vmr, std::abs(p.VolumeMixingRatio(band.Isotopologue())));
+            H = std::max(H, p.MagField().Strength());
+            vmrs.push_back(p.VolumeMixingRatios());
           }
-          break;
-        case Mirroring::Lorentz:
-          compute_lineshape(comp.x, comp.dx, f, derivs, cdd, lm, atm.atm.Temp(),
-                            line.ID(), cutoff_low, cutoff_upp,
-                            LineShape::Base::Lorentz(-line.F0(), mirrored(X),
-                                                     -GDpart, DZ * H));
-          break;
-        case Mirroring::None:
-        case Mirroring::FINAL: { /* leave last */
-        }
-      }
 
-      // Normalized Line Shape
-      switch (band.NormType()) {
-        case Normalization::VVH:
-          //           apply_VVH_scaling(F, dF, data, f, band.F0(i), T, band, i,
-          //           derivatives_data, derivatives_data_active);
-          break;
-        case Normalization::VVW:
-          //           apply_VVW_scaling(F, dF, f, band.F0(i), band, i,
-          //           derivatives_data, derivatives_data_active);
-          break;
-        case Normalization::RosenkranzQuadratic:
-          //           apply_rosenkranz_quadratic_scaling(F, dF, f, band.F0(i),
-          //           T, band, i, derivatives_data, derivatives_data_active);
-          break;
-        case Normalization::None:
-        case Normalization::FINAL: { /* leave last */
-        }
-      }
+          std::fill(cmin.begin(), cmin.end(),
+                    std::numeric_limits<double>::infinity());
+          std::fill(cmax.begin(), cmax.end(),
+                    -std::numeric_limits<double>::infinity());
+          std::fill(G0min.begin(), G0min.end(),
+                    std::numeric_limits<double>::infinity());
+          std::fill(mixing.begin(), mixing.end(), 0);
+          for (auto &v : vmrs) {
+            for (double T : {Tmin, Tmax}) {
+              for (double P : {Pmin, Pmax}) {
+                la.ShapeModels(LineShape::State(T, band.T0(), P), v, X.data(),
+                               nullptr);
+                for (size_t i = 0; i < n; i++) {
+                  const double centre = la.f0[i] + X[i].D0 + X[i].DV;
+                  cmin[i] = std::min(cmin[i], centre);
+                  cmax[i] = std::max(cmax[i], centre);
+                  G0min[i] = std::min(G0min[i], X[i].G0);
+                  mixing[i] = std::max(
+                      mixing[i], std::abs(Complex(1 + X[i].G, -X[i].Y)));
+                }
+              }
+            }
+          }
 
-      // Apply line strength by whatever method is necessary
-      switch (band.PopType()) {
-        case Population::ByLTE: {
-          compute_lte_linestrength(res, comp, f, atm, derivs, line.I0(), SZ,
-                                   line.E0(), line.F0(), QT0, band.T0(), QT,
-                                   dQTdT, mixing_ratio, line.ID(),
-                                   band.Isotopologue());
-        } break;
-        case Population::ByNLTE: {
-          double r1 = 0, r2 = 0;  // FIXME: Input the correct numbers when
-                                  // operating in NLTE mode
-
-          const std::pair<double, double> S =
-              compute_nlte_linestrength(SZ, line.F0(), line.Gl(), line.Gu(),
-                                        line.A(), r2, r1, atm.atm.Temp());
-
-          std::transform(comp.x.cbegin(), comp.x.cend(), res.x.cbegin(),
-                         res.x.begin(),
-                         [k = S.first](auto &a, auto &b) { return k * a + b; });
-
-          std::transform(
-              comp.x.cbegin(), comp.x.cend(), src.x.cbegin(), src.x.begin(),
-              [r = S.second](auto &a, auto &b) { return r * a + b; });
-        } break;
-        case Population::FINAL: { /* leave last */
+          const double QT0_QT = band.QT0() / std::min(band.QT(Tmin),
+                                                     band.QT(Tmax));
+          for (size_t i = 0; i < n; i++) {
+            const auto F0 = la.f0[i];
+            const double df =
+                std::max(0.0, distance(f, cmin[i], cmax[i]) - zeeman[i] * H);
+            double boltzman = 0, K2 = 0;
+            for (double T : {Tmin, Tmax}) {
+              boltzman = std::max(boltzman,
+                                  boltzman_ratio(T, band.T0(), la.e0[i]));
+              K2 = std::max(K2, stimulated_relative_emission(
+                                    stimulated_emission(T, F0),
+                                    stimulated_emission(band.T0(), F0)));
+            }
+            const double S =
+                vmr * std::abs(la.i0[i]) * boltzman * K2 * QT0_QT;
+            const double centre =
+                std::max(std::abs(cmin[i]), std::abs(cmax[i]));
+            const double b =
+                factor * S * mixing[i] *
+                shape_bound(band.ShapeType(), df,
+                            band.GD_giv_F0(Tmin) *
+                                std::min(std::abs(cmin[i]), std::abs(cmax[i])),
+                            band.GD_giv_F0(Tmax) * centre, G0min[i]);
+            out[i] = std::isnan(b) ? std::numeric_limits<double>::infinity()
+                                   : std::max(out[i], b);
+          }
         }
       }
     }
   }
+  return out;
+}
+}  // namespace
+
+Pruned prune(std::vector<Band> &bands,
+             const std::vector<Frequency<FrequencyType::Freq>> &f,
+             const Atmosphere::Atm &atm, double threshold, Threshold type,
+             const std::vector<Derivative::Target> &derivs) {
+  auto sorted_f = f;
+  std::sort(sorted_f.begin(), sorted_f.end());
+
+  std::vector<std::vector<double>> bounds(bands.size());
+  Multithread::parallel_for(Multithread::Arena::Compute, 0, bands.size(),
+                            [&](size_t i) {
+                              bounds[i] = line_bounds(bands[i], sorted_f, atm);
+                            })
+      .get();
+
+  Pruned out{0, 0, 0, 0};
+  struct Candidate {
+    double bound;
+    size_t band;
+    size_t line;
+  };
+  std::vector<Candidate> candidates;
+  for (size_t ib = 0; ib < bands.size(); ib++) {
+    const auto &lines = bands[ib].Lines();
+    for (size_t il = 0; il < lines.size(); il++) {
+      const double b = bounds[ib][il];
+      if (std::isfinite(b)) out.strongest = std::max(out.strongest, b);
+      if (std::isfinite(b) and
+          std::none_of(derivs.cbegin(), derivs.cend(), [&](auto &d) {
+            return d.isLine(lines[il].ID());
+          }))
+        candidates.push_back({b, ib, il});
+    }
+  }
+
+  const double budget =
+      type == Threshold::Relative ? threshold * out.strongest : threshold;
+  std::sort(candidates.begin(), candidates.end(),
+            [](auto &a, auto &b) { return a.bound < b.bound; });
+
+  // Marks the removed lines by a negative bound
+  for (auto &c : candidates) {
+    if (out.bound + c.bound > budget) break;
+    out.bound += c.bound;
+    bounds[c.band][c.line] = -1;
+  }
+
+  for (size_t ib = 0; ib < bands.size(); ib++) {
+    const auto &b = bounds[ib];
+    if (std::find(b.cbegin(), b.cend(), -1) == b.cend()) {
+      out.kept += b.size();
+      continue;
+    }
+
+    auto lines = bands[ib].EditLines();
+    size_t keep = 0;
+    for (size_t il = 0; il < lines->size(); il++) {
+      if (b[il] == -1) continue;
+      if (keep not_eq il) lines[keep] = std::move(lines[il]);
+      keep++;
+    }
+    out.removed += lines->size() - keep;
+    out.kept += keep;
+    lines->erase(lines.begin() + keep, lines.end());
+  }
+  return out;
 }
 }  // namespace Lbl
 }  // namespace Xsec
@@ -5,6 +5,7 @@
 #include "derivatives.h"
 #include "lbl.h"
 #include "lineshapes.h"
+#include "multithread.h"
 #include "propmat.h"
 
 namespace Absorption::Xsec::Lbl {
@@ -14,13 +15,113 @@ struct Results {
 
   Results(size_t nfreq = 0, size_t njac = 0) noexcept
       : x(nfreq, Complex{0, 0}), dx(njac, x) {}
+
+  Results &operator+=(const Results &other) noexcept {
+    for (size_t i = 0; i < x.size(); i++) x[i] += other.x[i];
+    for (size_t j = 0; j < dx.size(); j++)
+      for (size_t i = 0; i < dx[j].size(); i++) dx[j][i] += other.dx[j][i];
+    return *this;
+  }
+
+  /** Sets all values to zero, only allocating if the sizes change */
+  void reset(size_t nfreq, size_t njac) {
+    x.assign(nfreq, Complex{0, 0});
+    dx.resize(njac);
+    for (auto &d : dx) d.assign(nfreq, Complex{0, 0});
+  }
+};
+
+/** Line shape derivative data of one derivative target of a line */
+union ComputedDerivData {
+  double d;
+  LineShape::Output lso;
+  ComputedDerivData() noexcept : d(0) {}
+};
+
+/** The sums and scratch space of a block of lines computed in parallel */
+struct LineBlock {
+  Results res;
+  Results src;
+  Results comp;
+  std::vector<ComputedDerivData> cdd;
+};
+
+/** Scratch space of compute, kept by the caller between calls
+ *
+ * The buffers keep their sizes, so that computing on the same frequencies
+ * with the same derivatives again does not allocate.  A workspace must not be
+ * used by two calls at the same time
+ */
+struct Workspace {
+  Results comp;
+  std::vector<ComputedDerivData> cdd;
+  std::vector<std::size_t> active;
+  std::vector<LineShape::Output> X;
+  std::vector<LineShape::Output> dXdT;
+  Multithread::Pool<LineBlock> blocks;
+
+  Workspace(size_t nfreq = 0, size_t njac = 0) : comp(nfreq, njac) {}
 };
 
-void compute(Results &res, Results &src, Results &comp,
+/** Lines per task when the lines of a band are computed in parallel */
+constexpr size_t line_grain = 64;
+
+/** Adds the absorption of all lines of the band to res and src
+ *
+ * Only the lines whose cutoff reaches a frequency of f are computed.  Large
+ * bands are computed in blocks of line_grain lines on the compute arena.  The
+ * blocks are summed in an order that only depends on the number of these
+ * lines, so the result does not change with the number of threads
+ */
+void compute(Results &res, Results &src, Workspace &ws,
              const std::vector<Frequency<FrequencyType::Freq>> &f,
              const Band &band, const Path::Point &atm,
              const std::vector<Derivative::Target> &derivs,
              const Polarization polarization = Polarization::None);
+
+ENUMCLASS(Threshold, unsigned char, Absolute, Relative)
+
+/** The lines prune removed and how much they could have added */
+struct Pruned {
+  size_t removed;
+  size_t kept;
+
+  /** Bound of the absorption that the removed lines together add to
+   * Results::x at any frequency of the grid and point of the atmosphere */
+  double bound;
+
+  /** Largest bound of the absorption of a single line */
+  double strongest;
+};
+
+/** Removes the lines that cannot add more than a threshold to the absorption
+ *
+ * The absorption of a line of a band in local thermodynamic equilibrium is
+ * bounded over each cell of neighbouring points of the atmosphere, so that it
+ * holds for every point interpolated in the atmosphere.  The bound takes the
+ * extremes of the line strength and shape parameters over the cell, and the
+ * frequency of the grid nearest to where the line centre can be, as the line
+ * shapes fall off from there.  Bands with a cutoff or mirrored lines take
+ * twice the bound.  The weakest lines are then removed for as long as the sum
+ * of their bounds stays below the threshold.
+ *
+ * The lines that are kept keep their order and IDs.  Lines targeted by
+ * derivs, the lines of bands not in local thermodynamic equilibrium and the
+ * lines of speed-dependent shapes, which have no bound, are kept
+ *
+ * @param[in,out] bands Bands to remove lines from
+ * @param[in] f Frequency grid of the sensor
+ * @param[in] atm All points the bands are computed at
+ * @param[in] threshold Absorption the removed lines may add, in the unit of
+ * Results::x or relative to the strongest line
+ * @param[in] type If the threshold is absolute or relative
+ * @param[in] derivs Derivatives that the bands are computed for
+ * @return What was removed
+ */
+Pruned prune(std::vector<Band> &bands,
+             const std::vector<Frequency<FrequencyType::Freq>> &f,
+             const Atmosphere::Atm &atm, double threshold, Threshold type,
+             const std::vector<Derivative::Target> &derivs = {});
 }  // namespace Absorption::Xsec::Lbl
 
 #endif  // xsec_lbl_h
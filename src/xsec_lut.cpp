@@ -0,0 +1,302 @@
+#include "xsec_lut.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace Absorption::Xsec::Lut {
+namespace {
+/** How the two nodes around a temperature make up the cross-section there
+ *
+ * The cross-section is c[0] x0 + c[1] dx0 + c[2] x1 + c[3] dx1 and its
+ * temperature derivative e[0] x0 + e[1] dx0 + e[2] x1 + e[3] dx1, where x and
+ * dx are the cross-section and its temperature derivative at nodes i0 and i1
+ */
+struct Weights {
+  size_t i0;
+  size_t i1;
+  std::array<double, 4> c;
+  std::array<double, 4> e;
+};
+
+/** Cubic Hermite interpolation at dt between the perturbations in tp, and
+ * linear extrapolation from the end nodes outside them */
+Weights hermite(const std::vector<double> &tp, double dt) noexcept {
+  const size_t n = tp.size();
+  if (n == 1 or dt <= tp.front())
+    return {0, 0, {1, dt - tp.front(), 0, 0}, {0, 1, 0, 0}};
+  if (dt >= tp.back())
+    return {n - 1, n - 1, {1, dt - tp.back(), 0, 0}, {0, 1, 0, 0}};
+
+  const size_t i0 =
+      size_t(std::upper_bound(tp.cbegin(), tp.cend(), dt) - tp.cbegin()) - 1;
+  const double h = tp[i0 + 1] - tp[i0];
+  const double t = (dt - tp[i0]) / h;
+  const double u = 1 - t;
+  return {i0,
+          i0 + 1,
+          {(1 + 2 * t) * u * u, h * t * u * u, t * t * (3 - 2 * t),
+           -h * t * t * u},
+          {-6 * t * u / h, u * (1 - 3 * t), 6 * t * u / h, t * (3 * t - 2)}};
+}
+
+/** Up to four pressure levels from i0 on and their weights */
+struct PressureWeights {
+  size_t i0;
+  size_t n;
+  std::array<double, 4> w;
+};
+
+/** Cubic Lagrange interpolation at lp in the logarithms of the pressures, or
+ * of a lower order if there are fewer levels
+ *
+ * Cross-sections are close to proportional to the pressure in the line wings
+ * and to its inverse in the line centres, neither of which is linear in the
+ * logarithm of the pressure.  The pressure is clamped to the table
+ */
+PressureWeights pressure_weights(const std::vector<double> &log_p,
+                                 double lp) noexcept {
+  lp = std::clamp(lp, log_p.front(), log_p.back());
+  const size_t n = std::min<size_t>(4, log_p.size());
+  const size_t upp = size_t(
+      std::upper_bound(log_p.cbegin(), log_p.cend(), lp) - log_p.cbegin());
+  const size_t i0 = std::min(upp > n / 2 ? upp - n / 2 : 0, log_p.size() - n);
+
+  PressureWeights out{i0, n, {1, 1, 1, 1}};
+  for (size_t k = 0; k < n; k++)
+    for (size_t j = 0; j < n; j++)
+      if (j not_eq k)
+        out.w[k] *= (lp - log_p[i0 + j]) / (log_p[i0 + k] - log_p[i0 + j]);
+  return out;
+}
+
+/** The frequencies and the results must be those of the table */
+void check_frequencies(
+    const std::vector<Frequency<FrequencyType::Freq>> &table_f,
+    const std::vector<Frequency<FrequencyType::Freq>> &f,
+    const Lbl::Results &res) {
+  if (f not_eq table_f or res.x.size() not_eq table_f.size()) {
+    std::ostringstream os;
+    os << "Table has " << table_f.size() << " frequencies, but was given "
+       << f.size() << " other frequencies and " << res.x.size()
+       << " results\n";
+    throw std::runtime_error(os.str());
+  }
+}
+
+/** The table only has derivatives of temperature and volume mixing ratios */
+void check_derivatives(const std::vector<Derivative::Target> &derivs) {
+  for (auto &deriv : derivs) {
+    if (not(deriv == Derivative::Atm::Temperature or
+            deriv == Derivative::Atm::VMR)) {
+      std::ostringstream os;
+      os << "A table of cross-sections has no derivative of " << deriv
+         << ", only of temperature and volume mixing ratios\n";
+      throw std::runtime_error(os.str());
+    }
+  }
+}
+}  // namespace
+
+Table::Table(const std::vector<Band> &bands,
+             const std::vector<Frequency<FrequencyType::Freq>> &f_grid,
+             const std::vector<Pressure<PressureType::Pa>> &p_grid,
+             const std::vector<Temperature<TemperatureType::K>> &t_grid,
+             const std::vector<double> &t_perturbations,
+             const std::vector<VMR<VMRType::ratio>> &vmr)
+    : f(f_grid) {
+  if (bands.empty() or f.empty() or p_grid.empty() or
+      t_perturbations.empty() or p_grid.size() not_eq t_grid.size()) {
+    std::ostringstream os;
+    os << "Need bands (" << bands.size() << "), frequencies (" << f.size()
+       << "), pressures (" << p_grid.size() << "), as many temperatures ("
+       << t_grid.size() << "), and perturbations (" << t_perturbations.size()
+       << ") for a table\n";
+    throw std::runtime_error(os.str());
+  }
+
+  spec = bands.front().Isotopologue();
+  for (auto &band : bands) {
+    if (band.Isotopologue() not_eq spec or
+        band.PopType() not_eq Population::ByLTE or band.doZeeman()) {
+      std::ostringstream os;
+      os << "All bands of a table must be of " << spec
+         << " in LTE and without Zeeman effect, but one is of "
+         << band.Isotopologue() << " with " << band.PopType()
+         << " population and Zeeman " << band.doZeeman() << '\n';
+      throw std::runtime_error(os.str());
+    }
+  }
+
+  const auto nav = Geom::Nav();
+  const std::array<double, 3> zero{0, 0, 0};
+  const double vmr0 =
+      Atmosphere::Point(1, 1, zero, zero, vmr).VolumeMixingRatio(spec);
+  if (not(vmr0 > 0)) {
+    std::ostringstream os;
+    os << "Need a positive volume mixing ratio of " << spec
+       << " to make a table, got " << vmr0 << '\n';
+    throw std::runtime_error(os.str());
+  }
+
+  // Pressures increasing, keeping their temperatures
+  std::vector<size_t> order(p_grid.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return p_grid[a] < p_grid[b]; });
+  for (size_t i : order) {
+    log_p.push_back(std::log(p_grid[i]));
+    t_ref.push_back(t_grid[i]);
+  }
+
+  t_pert = t_perturbations;
+  std::sort(t_pert.begin(), t_pert.end());
+  if (not(p_grid[order.front()] > 0.0) or
+      std::adjacent_find(log_p.cbegin(), log_p.cend()) not_eq log_p.cend() or
+      std::adjacent_find(t_pert.cbegin(), t_pert.cend()) not_eq
+          t_pert.cend()) {
+    std::ostringstream os;
+    os << "Need positive and unique pressures, and unique perturbations, for "
+          "a table\n";
+    throw std::runtime_error(os.str());
+  }
+
+  x.resize(log_p.size() * t_pert.size() * f.size());
+  dxdT.resize(x.size());
+
+  const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature};
+  Lbl::Workspace ws(f.size(), derivs.size());
+  Lbl::Results res(f.size(), derivs.size()), src(f.size(), derivs.size());
+  for (size_t ip = 0; ip < log_p.size(); ip++) {
+    for (size_t it = 0; it < t_pert.size(); it++) {
+      const Path::Point atm{
+          nav, Atmosphere::Point(std::exp(log_p[ip]), t_ref[ip] + t_pert[it],
+                                 zero, zero, vmr)};
+      res.reset(f.size(), derivs.size());
+      src.reset(f.size(), derivs.size());
+      for (auto &band : bands)
+        Lbl::compute(res, src, ws, f, band, atm, derivs);
+
+      const size_t i0 = pos(ip, it);
+      for (size_t iv = 0; iv < f.size(); iv++) {
+        x[i0 + iv] = res.x[iv] / vmr0;
+        dxdT[i0 + iv] = res.dx[0][iv] / vmr0;
+      }
+    }
+  }
+}
+
+void Table::compute(Lbl::Results &res, Lbl::Results &,
+                    const std::vector<Frequency<FrequencyType::Freq>> &f_grid,
+                    const Path::Point &atm,
+                    const std::vector<Derivative::Target> &derivs) const {
+  check_frequencies(f, f_grid, res);
+  check_derivatives(derivs);
+
+  const auto p = pressure_weights(log_p, std::log(atm.atm.Pres()));
+  const double T = atm.atm.Temp();
+  std::array<Weights, 4> t;
+  std::array<const Complex *, 4> x0, x1, d0, d1;
+  for (size_t k = 0; k < p.n; k++) {
+    const size_t ip = p.i0 + k;
+    t[k] = hermite(t_pert, T - t_ref[ip]);
+    x0[k] = &x[pos(ip, t[k].i0)];
+    x1[k] = &x[pos(ip, t[k].i1)];
+    d0[k] = &dxdT[pos(ip, t[k].i0)];
+    d1[k] = &dxdT[pos(ip, t[k].i1)];
+  }
+
+  // The cross-section, or with e its temperature derivative, at iv
+  auto interp = [&](bool e, size_t iv) {
+    Complex out{0, 0};
+    for (size_t k = 0; k < p.n; k++) {
+      const auto &c = e ? t[k].e : t[k].c;
+      out += p.w[k] * (c[0] * x0[k][iv] + c[1] * d0[k][iv] +
+                       c[2] * x1[k][iv] + c[3] * d1[k][iv]);
+    }
+    return out;
+  };
+
+  const double vmr = atm.atm.VolumeMixingRatio(spec);
+  for (size_t iv = 0; iv < f.size(); iv++) res.x[iv] += vmr * interp(false, iv);
+
+  for (size_t i = 0; i < derivs.size(); i++) {
+    if (derivs[i] == Derivative::Atm::Temperature) {
+      for (size_t iv = 0; iv < f.size(); iv++)
+        res.dx[i][iv] += vmr * interp(true, iv);
+    } else if (derivs[i].isVMR(spec)) {
+      for (size_t iv = 0; iv < f.size(); iv++)
+        res.dx[i][iv] += interp(false, iv);
+    }
+  }
+}
+
+void saveTable(File::File<File::Operation::WriteBinary, File::Type::Xml> &file,
+               const Table &table) {
+  file.new_child("Table");
+  file.add_attribute("Isotopologue", table.spec);
+  file.add_attribute("Frequencies", table.f.size());
+  file.add_attribute("Pressures", table.log_p.size());
+  file.add_attribute("Temperatures", table.t_pert.size());
+  file.write(table.f);
+  file.write(table.log_p);
+  file.write(table.t_ref);
+  file.write(table.t_pert);
+  file.write(table.x);
+  file.write(table.dxdT);
+  file.leave_child();
+}
+
+void readTable(File::File<File::Operation::ReadBinary, File::Type::Xml> &file,
+               Table &table) {
+  file.get_child("Table");
+  std::istringstream spec(file.get_attribute("Isotopologue").as_string());
+  spec >> table.spec;
+  table.f.resize(file.get_attribute("Frequencies").as_int());
+  table.log_p.resize(file.get_attribute("Pressures").as_int());
+  table.t_ref.resize(table.log_p.size());
+  table.t_pert.resize(file.get_attribute("Temperatures").as_int());
+  table.x.resize(table.log_p.size() * table.t_pert.size() * table.f.size());
+  table.dxdT.resize(table.x.size());
+  file.read(table.f);
+  file.read(table.log_p);
+  file.read(table.t_ref);
+  file.read(table.t_pert);
+  file.read(table.x);
+  file.read(table.dxdT);
+  file.leave_child();
+}
+
+Accuracy compare(const Table &table, const std::vector<Band> &bands,
+                 const std::vector<Path::Point> &points) {
+  const auto &f = table.Frequencies();
+  const std::vector<Derivative::Target> derivs{Derivative::Atm::Temperature};
+  Lbl::Workspace ws(f.size(), derivs.size());
+  Lbl::Results lbl(f.size(), derivs.size()), lut(f.size(), derivs.size());
+  Lbl::Results src(f.size(), derivs.size());
+
+  Accuracy out{0, 0, 0};
+  for (auto &atm : points) {
+    lbl.reset(f.size(), derivs.size());
+    lut.reset(f.size(), derivs.size());
+    for (auto &band : bands) Lbl::compute(lbl, src, ws, f, band, atm, derivs);
+    table.compute(lut, src, f, atm, derivs);
+
+    double peak = 0, peak_dT = 0;
+    for (size_t iv = 0; iv < f.size(); iv++) {
+      peak = std::max(peak, std::abs(lbl.x[iv]));
+      peak_dT = std::max(peak_dT, std::abs(lbl.dx[0][iv]));
+    }
+    for (size_t iv = 0; iv < f.size(); iv++) {
+      const double d = std::abs(lut.x[iv] - lbl.x[iv]) / peak;
+      out.max = std::max(out.max, d);
+      out.rms += d * d;
+      const double d_dT = std::abs(lut.dx[0][iv] - lbl.dx[0][iv]) / peak_dT;
+      out.max_dT = std::max(out.max_dT, d_dT);
+    }
+  }
+  out.rms = std::sqrt(out.rms / double(points.size() * f.size()));
+  return out;
+}
+}  // namespace Absorption::Xsec::Lut
@@ -0,0 +1,134 @@
+#ifndef xsec_lut_h
+#define xsec_lut_h
+
+#include "atmpath.h"
+#include "derivatives.h"
+#include "file.h"
+#include "lbl.h"
+#include "xsec_lbl.h"
+
+namespace Absorption::Xsec::Lut {
+/** Line-by-line cross-sections of one isotopologue, precomputed on a grid
+ *
+ * The grid is the logarithm of pressure times a perturbation of the
+ * temperature from a reference temperature at each pressure, times the
+ * frequency grid of the table.  Each grid point keeps the cross-section per
+ * unit volume mixing ratio and its analytic temperature derivative.
+ *
+ * Cross-sections are interpolated with cubic polynomials in the logarithm of
+ * pressure and with cubic Hermite polynomials in temperature, which keeps the
+ * temperature derivative the derivative of the interpolated cross-section.
+ * They are scaled linearly by the volume mixing ratio, so the change of the
+ * broadening with the volume mixing ratios is not included.  The table has no
+ * Zeeman effect and no derivatives other than for temperature and the volume
+ * mixing ratio of the isotopologue
+ */
+class Table {
+  Species::Isotope spec;
+  std::vector<Frequency<FrequencyType::Freq>> f;
+
+  /** Natural logarithm of the pressures, increasing [log(Pa)] */
+  std::vector<double> log_p;
+
+  /** Reference temperature at each pressure [K] */
+  std::vector<double> t_ref;
+
+  /** Perturbations of the reference temperature, increasing [K] */
+  std::vector<double> t_pert;
+
+  /** Cross-sections per unit volume mixing ratio and their temperature
+   * derivatives, with the frequency running fastest, then the temperature
+   * perturbation, then the pressure */
+  std::vector<Complex> x;
+  std::vector<Complex> dxdT;
+
+  size_t pos(size_t ip, size_t it) const noexcept {
+    return (ip * t_pert.size() + it) * f.size();
+  }
+
+ public:
+  Table() = default;
+
+  /** Computes the table with Lbl::compute
+   *
+   * @param[in] bands Bands of a single isotopologue in local thermodynamic
+   * equilibrium and without Zeeman effect
+   * @param[in] f_grid Frequency grid of the table
+   * @param[in] p_grid Pressures of the table, in any order [Pa]
+   * @param[in] t_grid Reference temperature at each pressure [K]
+   * @param[in] t_perturbations Perturbations of the reference temperatures
+   * tabulated at each pressure, in any order [K]
+   * @param[in] vmr Volume mixing ratios of the atmosphere the lines are
+   * broadened by, including a non-zero value for the isotopologue
+   */
+  Table(const std::vector<Band> &bands,
+        const std::vector<Frequency<FrequencyType::Freq>> &f_grid,
+        const std::vector<Pressure<PressureType::Pa>> &p_grid,
+        const std::vector<Temperature<TemperatureType::K>> &t_grid,
+        const std::vector<double> &t_perturbations,
+        const std::vector<VMR<VMRType::ratio>> &vmr);
+
+  Species::Isotope Isotopologue() const noexcept { return spec; }
+  const std::vector<Frequency<FrequencyType::Freq>> &Frequencies()
+      const noexcept {
+    return f;
+  }
+  size_t Pressures() const noexcept { return log_p.size(); }
+  size_t Temperatures() const noexcept { return t_pert.size(); }
+
+  /** Adds the interpolated absorption of the table to res
+   *
+   * Follows Lbl::compute, so the table can take the place of the bands it was
+   * computed from.  Outside the table, the pressure is clamped to the nearest
+   * level and the temperature is extrapolated linearly from the nearest
+   * perturbation.  Throws if f are not the frequencies of the table or if a
+   * derivative is neither of temperature nor of a volume mixing ratio.  The
+   * derivatives of the volume mixing ratios of other species are zero
+   */
+  void compute(Lbl::Results &res, Lbl::Results &src,
+               const std::vector<Frequency<FrequencyType::Freq>> &f_grid,
+               const Path::Point &atm,
+               const std::vector<Derivative::Target> &derivs) const;
+
+  friend void saveTable(
+      File::File<File::Operation::WriteBinary, File::Type::Xml> &file,
+      const Table &table);
+  friend void readTable(
+      File::File<File::Operation::ReadBinary, File::Type::Xml> &file,
+      Table &table);
+};  // Table
+
+/** Differences of a table from line-by-line at some atmospheric points
+ *
+ * The largest difference at each point is relative to the largest value of
+ * line-by-line at that point, so the line wings do not dominate the report
+ */
+struct Accuracy {
+  /** Largest relative difference of the absorption of all points */
+  double max;
+
+  /** Root mean square of the relative differences of the absorption */
+  double rms;
+
+  /** Largest relative difference of the temperature derivatives */
+  double max_dT;
+
+  friend std::ostream &operator<<(std::ostream &os, const Accuracy &a) {
+    return os << "max " << a.max << ", rms " << a.rms << ", max of dT "
+              << a.max_dT;
+  }
+};
+
+/** Compares the table with Lbl::compute of the bands it was made from
+ *
+ * @param[in] table A table
+ * @param[in] bands The bands of the table
+ * @param[in] points Atmospheric points to compare at, preferably between the
+ * grid points of the table
+ * @return The differences
+ */
+Accuracy compare(const Table &table, const std::vector<Band> &bands,
+                 const std::vector<Path::Point> &points);
+}  // namespace Absorption::Xsec::Lut
+
+#endif  // xsec_lut_h
@@ -258,6 +258,8 @@ struct Model {
    *
    * The user has to ensure n is less than the number of elements
    *
+   * Throws if the Wigner symbol cannot be computed, as wigner3j
+   *
    * @param[in] Ju J of the upper state
    * @param[in] Jl J of the upper state
    * @param[in] type The polarization type
@@ -266,7 +268,7 @@ struct Model {
    * @return The relative strength of the Zeeman sub-line
    */
   double Strength(Rational Ju, Rational Jl, Polarization type,
-                  int n) const noexcept {
+                  int n) const {
     using Constant::pow2;
 
     auto ml = Ml(Ju, Jl, type, n);